@@ -41,3 +41,11 @@ time ./predict   1M.txt   1M.val.txt   1k_test.txt result_polatory/1M_1k.txt
 time ./predict   1M.txt   1M.val.txt  10k_test.txt result_polatory/1M_10k.txt
 time ./predict   1M.txt   1M.val.txt 100k_test.txt result_polatory/1M_100k.txt
 time ./predict   1M.txt   1M.val.txt   1M_test.txt result_polatory/1M_1M.txt
+
+time ./pu 100k.txt 100k.val.txt 100k_test.txt 4096
+time ./pu   1M.txt   1M.val.txt 100k_test.txt 4096
+
+time ./hmatrix 10k.txt 10k.val.txt
+time ./hmatrix 100k.txt 100k.val.txt
+
+time ./distance_filter 10000000 0.001
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <polatory/geometry/cuboid3d.hpp>
+#include <polatory/point_cloud/random_points.hpp>
+#include <polatory/polatory.hpp>
+#include <string>
+#include <vector>
+
+using polatory::Index;
+using polatory::geometry::Cuboid3;
+using polatory::point_cloud::DistanceFilter;
+using polatory::point_cloud::random_points;
+
+// Measures the time to filter the points visited in random order and in sorted order.
+// The latter is the worst case for the parallel rounds,
+// as each point depends on the preceding ones.
+int main(int /*argc*/, char* argv[]) {
+  try {
+    Index n_points = std::stoi(argv[1]);
+    auto distance = std::stod(argv[2]);
+
+    auto points = random_points(Cuboid3({0, 0, 0}, {1, 1, 1}), n_points, 0);
+
+    std::vector<Index> indices(n_points);
+    std::iota(indices.begin(), indices.end(), Index{0});
+
+    auto start = std::chrono::steady_clock::now();
+    auto n_random = DistanceFilter(points).filter(distance, indices).filtered_indices().size();
+    std::chrono::duration<double> random_time = std::chrono::steady_clock::now() - start;
+
+    std::sort(indices.begin(), indices.end(), [&](auto i, auto j) {
+      return std::lexicographical_compare(points.row(i).begin(), points.row(i).end(),
+                                          points.row(j).begin(), points.row(j).end());
+    });
+
+    start = std::chrono::steady_clock::now();
+    auto n_sorted = DistanceFilter(points).filter(distance, indices).filtered_indices().size();
+    std::chrono::duration<double> sorted_time = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::format("random order: {:.3f} s ({} points kept)", random_time.count(),
+                             n_random)
+              << std::endl
+              << std::format("sorted order: {:.3f} s ({} points kept)", sorted_time.count(),
+                             n_sorted)
+              << std::endl;
+
+    return 0;
+  } catch (const std::exception& e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    return 1;
+  } catch (...) {
+    std::cerr << "unknown error" << std::endl;
+    return 1;
+  }
+}
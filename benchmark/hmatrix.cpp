@@ -0,0 +1,100 @@
+#include <Eigen/Core>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <polatory/polatory.hpp>
+#include <utility>
+
+using polatory::Index;
+using polatory::Interpolant;
+using polatory::Model;
+using polatory::read_table;
+using polatory::VecX;
+using polatory::geometry::Points3;
+using polatory::interpolation::HMatrixOperator;
+using polatory::interpolation::Operator;
+using polatory::interpolation::OperatorType;
+using polatory::rbf::Biharmonic3D;
+
+// Compares the hierarchical matrix operator with the FMM operator
+// in terms of setup time, memory, time per matrix-vector product, and total fitting time.
+int main(int /*argc*/, char* argv[]) {
+  try {
+    Points3 points = read_table(argv[1]);
+    VecX values = read_table(argv[2]);
+
+    double tolerance = 1e-4;
+    double accuracy = tolerance / 100.0;
+    int n_matvecs = 10;
+
+    Biharmonic3D<3> rbf({1.0});
+
+    auto poly_degree = 0;
+    Model<3> model(std::move(rbf), poly_degree);
+
+    auto start = std::chrono::steady_clock::now();
+    Operator<3> op(model, points, Points3(0, 3), 0.0, 0.0);
+    std::chrono::duration<double> fmm_setup_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    HMatrixOperator<3> hmatrix_op(model, points, Points3(0, 3));
+    std::chrono::duration<double> hmatrix_setup_time = std::chrono::steady_clock::now() - start;
+
+    VecX weights = VecX::Random(op.size());
+    VecX expected;
+    VecX actual;
+
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < n_matvecs; i++) {
+      expected = op(weights);
+    }
+    std::chrono::duration<double> fmm_matvec_time =
+        (std::chrono::steady_clock::now() - start) / n_matvecs;
+
+    start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < n_matvecs; i++) {
+      actual = hmatrix_op(weights);
+    }
+    std::chrono::duration<double> hmatrix_matvec_time =
+        (std::chrono::steady_clock::now() - start) / n_matvecs;
+
+    auto n = points.rows();
+    auto dense_mb = static_cast<double>(n) * static_cast<double>(n) * sizeof(double) / 1e6;
+    auto hmatrix_mb = static_cast<double>(hmatrix_op.storage_size()) * sizeof(double) / 1e6;
+
+    start = std::chrono::steady_clock::now();
+    Interpolant<3> fmm_interpolant(model);
+    fmm_interpolant.fit(points, values, tolerance, 100, accuracy);
+    std::chrono::duration<double> fmm_fit_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    Interpolant<3> hmatrix_interpolant(model);
+    hmatrix_interpolant.set_operator_type(OperatorType::kHMatrix);
+    hmatrix_interpolant.fit(points, values, tolerance, 100, accuracy);
+    std::chrono::duration<double> hmatrix_fit_time = std::chrono::steady_clock::now() - start;
+
+    std::cout << std::format("setup: fmm {:.3f} s, hmatrix {:.3f} s", fmm_setup_time.count(),
+                             hmatrix_setup_time.count())
+              << std::endl
+              << std::format("matvec: fmm {:.3f} s, hmatrix {:.3f} s", fmm_matvec_time.count(),
+                             hmatrix_matvec_time.count())
+              << std::endl
+              << std::format("memory: hmatrix {:.1f} MB, dense {:.1f} MB", hmatrix_mb, dense_mb)
+              << std::endl
+              << std::format("relative diff: {:e}",
+                             (actual - expected).norm() / expected.norm())
+              << std::endl
+              << std::format("fit: fmm {:.3f} s, hmatrix {:.3f} s", fmm_fit_time.count(),
+                             hmatrix_fit_time.count())
+              << std::endl;
+
+    return 0;
+  } catch (const std::exception& e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    return 1;
+  } catch (...) {
+    std::cerr << "unknown error" << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,64 @@
+#include <Eigen/Core>
+#include <chrono>
+#include <cmath>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <polatory/polatory.hpp>
+#include <string>
+#include <utility>
+
+using polatory::Index;
+using polatory::Interpolant;
+using polatory::Model;
+using polatory::PartitionOfUnityInterpolant;
+using polatory::read_table;
+using polatory::VecX;
+using polatory::geometry::Points3;
+using polatory::rbf::CovExponential;
+
+// Compares a PartitionOfUnityInterpolant with a global Interpolant fitted to the same data.
+int main(int /*argc*/, char* argv[]) {
+  try {
+    Points3 points = read_table(argv[1]);
+    VecX values = read_table(argv[2]);
+    Points3 prediction_points = read_table(argv[3]);
+    Index patch_size = std::stoi(argv[4]);
+
+    double tolerance = 1e-4;
+
+    CovExponential<3> rbf({1.0, 0.02});
+
+    auto poly_degree = 0;
+    Model<3> model(std::move(rbf), poly_degree);
+
+    auto start = std::chrono::steady_clock::now();
+    Interpolant<3> interpolant(model);
+    interpolant.fit(points, values, tolerance);
+    VecX expected = interpolant.evaluate(prediction_points);
+    std::chrono::duration<double> global_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    PartitionOfUnityInterpolant<3> pu(model, patch_size);
+    pu.fit(points, values, tolerance);
+    VecX actual = pu.evaluate(prediction_points);
+    std::chrono::duration<double> pu_time = std::chrono::steady_clock::now() - start;
+
+    VecX diff = actual - expected;
+    std::cout << std::format("global: {:.3f} s", global_time.count()) << std::endl
+              << std::format("pu ({} patches): {:.3f} s", pu.num_patches(), pu_time.count())
+              << std::endl
+              << std::format("max abs diff: {:e}", diff.lpNorm<Eigen::Infinity>()) << std::endl
+              << std::format("rms diff: {:e}", diff.norm() / std::sqrt(diff.size())) << std::endl
+              << std::format("rms value: {:e}", expected.norm() / std::sqrt(expected.size()))
+              << std::endl;
+
+    return 0;
+  } catch (const std::exception& e) {
+    std::cerr << "error: " << e.what() << std::endl;
+    return 1;
+  } catch (...) {
+    std::cerr << "unknown error" << std::endl;
+    return 1;
+  }
+}
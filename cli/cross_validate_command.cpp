@@ -31,6 +31,8 @@ struct Options {
   double tolerance{};
   int max_iter{};
   double accuracy{};
+  int num_concurrent_sets{};
+  bool warm_start{};
   std::string out_file;
 };
 
@@ -47,8 +49,9 @@ void run_impl(const Options& opts) {
   auto model =
       !opts.model_file.empty() ? Model::load(opts.model_file) : make_model<Dim>(opts.model_opts);
 
-  auto predictions = cross_validate<Dim>(model, points, values, set_ids, opts.tolerance,
-                                         opts.max_iter, opts.accuracy);
+  auto predictions =
+      cross_validate<Dim>(model, points, values, set_ids, opts.tolerance, opts.max_iter,
+                          opts.accuracy, opts.num_concurrent_sets, opts.warm_start);
 
   write_table(opts.out_file, concatenate_cols<MatX>(table, predictions));
 }
@@ -78,6 +81,10 @@ void CrossValidateCommand::run(const std::vector<std::string>& args,
            ->default_value(std::numeric_limits<double>::infinity(), "ANY")
            ->value_name("ACC"),
        "Absolute evaluation accuracy")  //
+      ("concurrent-sets", po::value(&opts.num_concurrent_sets)->default_value(1)->value_name("N"),
+       "Number of sets processed concurrently; the threads are divided evenly among them")  //
+      ("warm-start", po::bool_switch(&opts.warm_start),
+       "Start fitting each set from the interpolant fitted to all points")  //
       ("out", po::value(&opts.out_file)->required()->value_name("FILE"),
        "Output file in CSV format:\n  X[,Y[,Z]],VAL,SET_ID,...,PREDICTION")  //
       ;
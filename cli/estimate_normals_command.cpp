@@ -35,6 +35,7 @@ struct Options {
   Point3 point;
   Vector3 direction;
   Index k_closed{};
+  Index patch_size{};
   std::string out_file;
 };
 
@@ -63,7 +64,11 @@ void run_impl(const Options& opts) {
       estimator.orient_toward_direction(opts.direction);
       break;
     case OrientationEstimationMethod::kClosed:
-      estimator.orient_closed_surface(opts.k_closed);
+      if (opts.patch_size > 0) {
+        estimator.orient_closed_surface_by_patches(opts.k_closed, opts.patch_size);
+      } else {
+        estimator.orient_closed_surface(opts.k_closed);
+      }
       break;
   }
 
@@ -100,6 +105,9 @@ void EstimateNormalsCommand::run(const std::vector<std::string>& args,
       ("closed", po::value(&opts.k_closed)->value_name("K"),
        "Orient normals of closed surface(s) using k-NN search with the specified number of points\n"
        "This option with 100 is default")  //
+      ("patch-size", po::value(&opts.patch_size)->value_name("N"),
+       "Orient normals of closed surface(s) in parallel over spatial patches of at most N "
+       "points")  //
       ("out", po::value(&opts.out_file)->required()->value_name("FILE"),
        "Output file in CSV format:\n  X,Y,Z,NX,NY,NZ")  //
       ;
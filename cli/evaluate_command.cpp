@@ -1,17 +1,26 @@
 #include <boost/program_options.hpp>
+#include <cmath>
+#include <format>
+#include <fstream>
 #include <limits>
 #include <polatory/polatory.hpp>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
 #include "commands.hpp"
 
+using polatory::Index;
 using polatory::Interpolant;
+using polatory::Mat;
 using polatory::MatX;
 using polatory::read_table;
 using polatory::write_table;
 using polatory::common::concatenate_cols;
+using polatory::geometry::GridPoints;
 using polatory::geometry::Points;
+using polatory::geometry::Vector;
+using polatory::numeric::to_string;
 
 namespace {
 
@@ -22,9 +31,43 @@ struct Options {
   bool grads{};
   double accuracy{};
   double grad_accuracy{};
+  std::vector<double> bbox;
+  double resolution{};
   std::string out_file;
 };
 
+// Returns the points on the regular grid with the given spacing that covers the bbox.
+template <int Dim>
+GridPoints<Dim> make_grid(const std::vector<double>& bbox, double resolution) {
+  using GridIndex = Eigen::Matrix<Index, 1, Dim>;
+
+  if (bbox.size() != 2 * Dim) {
+    throw std::runtime_error(std::format("--bbox must have {} values", 2 * Dim));
+  }
+  if (!(resolution > 0.0)) {
+    throw std::runtime_error("--res must be positive");
+  }
+
+  Vector<Dim> min = Eigen::Map<const Vector<Dim>>(bbox.data());
+  Vector<Dim> max = Eigen::Map<const Vector<Dim>>(bbox.data() + Dim);
+  GridIndex size = ((max - min) / resolution).array().floor().template cast<Index>() + 1;
+  if ((size.array() <= 0).any()) {
+    throw std::runtime_error("--bbox must not be empty");
+  }
+
+  GridPoints<Dim> grid(min / resolution, resolution * Mat<Dim>::Identity());
+  GridIndex start = GridIndex::Zero();
+  auto n_runs = size.tail(Dim - 1).prod();
+  for (Index r = 0; r < n_runs; r++) {
+    grid.add_run(start, size(0));
+    for (auto i = 1; i < Dim && ++start(i) == size(i); i++) {
+      start(i) = 0;
+    }
+  }
+
+  return grid;
+}
+
 template <int Dim>
 void run_impl(const Options& opts) {
   using Interpolant = Interpolant<Dim>;
@@ -32,6 +75,32 @@ void run_impl(const Options& opts) {
 
   auto inter = Interpolant::load(opts.interpolant_file);
 
+  if (!opts.bbox.empty()) {
+    if (!opts.points_file.empty() || opts.grads) {
+      throw std::runtime_error("--bbox cannot be used with --points or --grads");
+    }
+
+    auto grid = make_grid<Dim>(opts.bbox, opts.resolution);
+    auto values = inter.evaluate(grid, opts.accuracy);
+
+    // The points are written as they are generated, so that they are not stored all at once.
+    std::ofstream ofs(opts.out_file);
+    if (!ofs) {
+      throw std::runtime_error(std::format("cannot open file '{}'", opts.out_file));
+    }
+    grid.for_each_point([&](Index i, const auto& p) {
+      for (auto j = 0; j < Dim; j++) {
+        ofs << to_string(p(j)) << ' ';
+      }
+      ofs << to_string(values(i)) << '\n';
+    });
+    return;
+  }
+
+  if (opts.points_file.empty()) {
+    throw std::runtime_error("either --points or --bbox must be specified");
+  }
+
   MatX table = read_table(opts.points_file);
   Points points = table(Eigen::all, Eigen::seqN(0, Dim));
 
@@ -61,6 +130,11 @@ void EvaluateCommand::run(const std::vector<std::string>& args, const GlobalOpti
        "Input interpolant file")  //
       ("points", po::value(&opts.points_file)->value_name("FILE"),
        "Input evaluation points file in CSV format:\n  X[,Y[,Z]]")  //
+      ("bbox",
+       po::value(&opts.bbox)->multitoken()->value_name("X_MIN [Y_MIN [Z_MIN]] X_MAX [...]"),
+       "Evaluate on the regular grid covering the bbox instead of the points")  //
+      ("res", po::value(&opts.resolution)->value_name("RES"),
+       "Grid spacing, used with --bbox")  //
       ("dim", po::value(&opts.dim)->required()->value_name("1|2|3"),
        "Dimension of input points")  //
       ("grads", po::bool_switch(&opts.grads),
@@ -20,6 +20,7 @@ using polatory::read_table;
 using polatory::VecX;
 using polatory::geometry::Points;
 using polatory::geometry::Vectors;
+using polatory::interpolation::OperatorType;
 
 namespace {
 
@@ -37,6 +38,8 @@ struct Options {
   double grad_accuracy{};
   bool ineq{};
   bool reduce{};
+  bool out_of_core{};
+  bool hmatrix{};
   std::string out_file;
 };
 
@@ -77,6 +80,10 @@ void run_impl(const Options& opts) {
   }
 
   Interpolant inter(std::move(model));
+  inter.set_out_of_core(opts.out_of_core);
+  if (opts.hmatrix) {
+    inter.set_operator_type(OperatorType::kHMatrix);
+  }
   if (opts.ineq) {
     inter.fit_inequality(points, values, *values_lb, *values_ub, opts.tolerance, opts.max_iter,
                          opts.accuracy, initial ? &*initial : nullptr);
@@ -131,6 +138,12 @@ void FitCommand::run(const std::vector<std::string>& args, const GlobalOptions&
        "Use inequality constraints")  //
       ("reduce", po::bool_switch(&opts.reduce),
        "Try to reduce the number of RBF centers (incremental fitting)")  //
+      ("out-of-core", po::bool_switch(&opts.out_of_core),
+       "Store the Krylov subspace vectors and the polynomial matrices in memory-mapped\n"
+       "temporary files, which are created in $POLATORY_TMPDIR if it is set,\n"
+       "or in the system temporary directory otherwise")  //
+      ("hmatrix", po::bool_switch(&opts.hmatrix),
+       "Use a hierarchical matrix instead of FMM for the matrix-vector products")  //
       ("out", po::value(&opts.out_file)->required()->value_name("FILE"),
        "Output interpolant file")  //
       ;
@@ -3,7 +3,6 @@
 #include <boost/program_options.hpp>
 #include <format>
 #include <iostream>
-#include <limits>
 #include <polatory/kriging.hpp>
 #include <polatory/polatory.hpp>
 #include <stdexcept>
@@ -15,7 +14,7 @@
 #include "commands.hpp"
 
 using polatory::Model;
-using polatory::kriging::VariogramFitting;
+using polatory::kriging::fit_variogram;
 using polatory::kriging::VariogramSet;
 
 namespace {
@@ -34,7 +33,6 @@ struct Options {
 template <int Dim>
 void run_impl(const Options& opts) {
   using Model = Model<Dim>;
-  using VariogramFitting = VariogramFitting<Dim>;
   using VariogramSet = VariogramSet<Dim>;
 
   auto variog_set = VariogramSet::load(opts.in_file);
@@ -42,15 +40,8 @@ void run_impl(const Options& opts) {
   auto model =
       !opts.model_file.empty() ? Model::load(opts.model_file) : make_model<Dim>(opts.model_opts);
 
-  auto best_model = model;
-  auto best_cost = std::numeric_limits<double>::infinity();
-  for (auto i = 0; i < opts.num_trials; ++i) {
-    VariogramFitting fit(variog_set, model, opts.weight_fn);
-    if (fit.final_cost() < best_cost) {
-      best_model = fit.model();
-      best_cost = fit.final_cost();
-    }
-  }
+  auto fits = fit_variogram(variog_set, model, opts.num_trials, opts.weight_fn);
+  auto best_model = fits.front().model();
 
   std::cout << best_model.description() << std::endl;
 
@@ -89,7 +80,7 @@ where
   h_j: representative distance of the j-th bin
   gamma: model variogram)")  //
       ("num-trials", po::value(&opts.num_trials)->default_value(30)->value_name("N"),
-       "Number of trials")  //
+       "Number of starting points")  //
       ("out", po::value(&opts.out_file)->required()->value_name("FILE"),
        "Output model file")  //
       ;
@@ -4,7 +4,9 @@
 #include <format>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <polatory/polatory.hpp>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -18,8 +20,11 @@ using polatory::MatX;
 using polatory::read_table;
 using polatory::geometry::Bbox3;
 using polatory::geometry::Points3;
+using polatory::isosurface::FieldFunction;
 using polatory::isosurface::Isosurface;
+using polatory::isosurface::MeshStreamWriter;
 using polatory::isosurface::RbfFieldFunction;
+using polatory::isosurface::RbfFieldFunctionWithGradient;
 using polatory::numeric::to_double;
 
 namespace {
@@ -34,6 +39,8 @@ struct Options {
   double resolution{};
   Mat3 aniso;
   int refine{};
+  bool grad_refine{};
+  bool stream{};
   std::string out_file;
 };
 
@@ -42,7 +49,24 @@ void run_impl(const Options& opts) {
   auto bbox = opts.bbox.is_empty() ? inter.bbox() : opts.bbox;
 
   Isosurface isosurf(bbox, opts.resolution, opts.aniso);
-  RbfFieldFunction field_fn(inter, opts.accuracy, opts.grad_accuracy);
+  std::unique_ptr<FieldFunction> field_fn_ptr;
+  if (opts.grad_refine) {
+    field_fn_ptr =
+        std::make_unique<RbfFieldFunctionWithGradient>(inter, opts.accuracy, opts.grad_accuracy);
+  } else {
+    field_fn_ptr = std::make_unique<RbfFieldFunction>(inter, opts.accuracy, opts.grad_accuracy);
+  }
+  auto& field_fn = *field_fn_ptr;
+
+  if (opts.stream) {
+    if (!opts.seed_points_file.empty()) {
+      throw std::runtime_error("--stream cannot be used with --seeds");
+    }
+
+    MeshStreamWriter writer(opts.out_file);
+    isosurf.generate_streaming(field_fn, writer, opts.isovalue, opts.refine);
+    return;
+  }
 
   Points3 seed_points;
   if (!opts.seed_points_file.empty()) {
@@ -54,7 +78,7 @@ void run_impl(const Options& opts) {
                                                                          opts.isovalue, opts.refine)
                                      : isosurf.generate(field_fn, opts.isovalue, opts.refine);
 
-  mesh.export_obj(opts.out_file);
+  mesh.export_file(opts.out_file);
 }
 
 }  // namespace
@@ -99,8 +123,12 @@ void IsosurfaceCommand::run(const std::vector<std::string>& args,
        "Output mesh isovalue")  //
       ("refine", po::value(&opts.refine)->default_value(1)->value_name("N"),
        "Number of vertex refinement passes")  //
+      ("grad-refine", po::bool_switch(&opts.grad_refine),
+       "Refine vertices with the gradients, which takes fewer but more costly passes")  //
+      ("stream", po::bool_switch(&opts.stream),
+       "Write the mesh slab by slab to reduce memory usage (OBJ or STL only)")  //
       ("out", po::value(&opts.out_file)->required()->value_name("FILE"),
-       "Output mesh file in OBJ format")  //
+       "Output mesh file in OBJ, PLY, STL or raw format, chosen by the extension")  //
       ;
 
   if (global_opts.help) {
@@ -28,7 +28,7 @@ namespace {
 struct Options {
   std::string in_file;
   double min_offset{};
-  double max_offset{};
+  std::vector<double> max_offsets;
   double ratio{};
   Mat3 aniso;
   std::string out_file;
@@ -49,7 +49,7 @@ void run_impl(const Options& opts) {
   indices.resize(n_normals - n_normals_to_keep);
   normals(indices, Eigen::all) *= 0.0;
 
-  SdfDataGenerator sdf_data(points, normals, opts.min_offset, opts.max_offset, opts.aniso);
+  SdfDataGenerator sdf_data(points, normals, opts.min_offset, opts.max_offsets, opts.aniso);
 
   const auto& sdf_points = sdf_data.sdf_points();
   const auto& sdf_values = sdf_data.sdf_values();
@@ -71,8 +71,8 @@ void NormalsToSdfCommand::run(const std::vector<std::string>& args,
        "Input file in CSV format:\n  X,Y,Z,NX,NY,NZ")  //
       ("min-offset", po::value(&opts.min_offset)->default_value(0.0, "0.0")->value_name("OFFSET"),
        "Minimum offset distance of off-surface points")  //
-      ("offset", po::value(&opts.max_offset)->required()->value_name("OFFSET"),
-       "Default offset distance of off-surface points")  //
+      ("offset", po::value(&opts.max_offsets)->multitoken()->required()->value_name("OFFSET ..."),
+       "Default offset distances of off-surface points")  //
       ("aniso",
        po::value(&opts.aniso)
            ->multitoken()
@@ -3,6 +3,7 @@
 #include <format>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <optional>
 #include <polatory/polatory.hpp>
 #include <string>
@@ -17,8 +18,10 @@ using polatory::MatX;
 using polatory::read_table;
 using polatory::geometry::Bbox3;
 using polatory::geometry::Points3;
+using polatory::isosurface::FieldFunction;
 using polatory::isosurface::Isosurface;
 using polatory::isosurface::RbfFieldFunction25D;
+using polatory::isosurface::RbfFieldFunction25DWithGradient;
 
 namespace {
 
@@ -30,6 +33,7 @@ struct Options {
   Bbox3 bbox;
   double resolution{};
   int refine{};
+  bool grad_refine{};
   std::string out_file;
 };
 
@@ -38,7 +42,14 @@ void run_impl(const Options& opts) {
   auto bbox = opts.bbox;
 
   Isosurface isosurf(bbox, opts.resolution);
-  RbfFieldFunction25D field_fn(inter, opts.accuracy, opts.grad_accuracy);
+  std::unique_ptr<FieldFunction> field_fn_ptr;
+  if (opts.grad_refine) {
+    field_fn_ptr =
+        std::make_unique<RbfFieldFunction25DWithGradient>(inter, opts.accuracy, opts.grad_accuracy);
+  } else {
+    field_fn_ptr = std::make_unique<RbfFieldFunction25D>(inter, opts.accuracy, opts.grad_accuracy);
+  }
+  auto& field_fn = *field_fn_ptr;
 
   Points3 seed_points;
   if (!opts.seed_points_file.empty()) {
@@ -50,7 +61,7 @@ void run_impl(const Options& opts) {
                   ? isosurf.generate_from_seed_points(seed_points, field_fn, 0.0, opts.refine)
                   : isosurf.generate(field_fn, 0.0, opts.refine);
 
-  mesh.export_obj(opts.out_file);
+  mesh.export_file(opts.out_file);
 }
 
 }  // namespace
@@ -87,8 +98,10 @@ void Surface25DCommand::run(const std::vector<std::string>& args,
        "Output mesh resolution")  //
       ("refine", po::value(&opts.refine)->default_value(1)->value_name("N"),
        "Number of vertex refinement passes")  //
+      ("grad-refine", po::bool_switch(&opts.grad_refine),
+       "Refine vertices with the gradients, which takes fewer but more costly passes")  //
       ("out", po::value(&opts.out_file)->required()->value_name("FILE"),
-       "Output mesh file in OBJ format")  //
+       "Output mesh file in OBJ, PLY, STL or raw format, chosen by the extension")  //
       ;
 
   if (global_opts.help) {
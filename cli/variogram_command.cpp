@@ -17,6 +17,7 @@ using polatory::geometry::Points;
 using polatory::kriging::detrend;
 using polatory::kriging::NormalScoreTransformation;
 using polatory::kriging::VariogramCalculator;
+using polatory::kriging::VariogramEstimator;
 
 namespace {
 
@@ -30,9 +31,23 @@ struct Options {
   double lag_tolerance{};
   double angle_tolerance{};
   bool aniso{};
+  std::string estimator;
   std::string out_file;
 };
 
+VariogramEstimator parse_estimator(const std::string& name) {
+  if (name == "matheron") {
+    return VariogramEstimator::kMatheron;
+  }
+  if (name == "cressie-hawkins") {
+    return VariogramEstimator::kCressieHawkins;
+  }
+  if (name == "madogram") {
+    return VariogramEstimator::kMadogram;
+  }
+  throw std::runtime_error(std::format("unknown estimator: {}", name));
+}
+
 template <int Dim>
 void run_impl(const Options& opts) {
   using Points = Points<Dim>;
@@ -57,6 +72,7 @@ void run_impl(const Options& opts) {
   if (opts.aniso) {
     calc.set_directions(VariogramCalculator::kAnisotropicDirections);
   }
+  calc.set_estimator(parse_estimator(opts.estimator));
   auto variog_set = calc.calculate(points, values);
 
   if (opts.normal_score) {
@@ -99,6 +115,11 @@ void VariogramCommand::run(const std::vector<std::string>& args, const GlobalOpt
        "Angle tolerance in degrees")  //
       ("aniso", po::bool_switch(&opts.aniso),
        "Use anisotropic directions")  //
+      ("estimator",
+       po::value(&opts.estimator)
+           ->default_value("matheron")
+           ->value_name("matheron|cressie-hawkins|madogram"),
+       "Variogram estimator")  //
       ("out", po::value(&opts.out_file)->required()->value_name("FILE"),
        "Output variogram file")  //
       ;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+
+namespace polatory::common {
+
+// A temporary file mapped into memory, which is deleted on destruction.
+// The file is sparse, and its pages can be written back and evicted by the OS
+// instead of being swapped out.
+// The file is created in the directory given by the environment variable POLATORY_TMPDIR
+// if it is set, or in the system temporary directory otherwise. As the latter is often
+// on tmpfs, which is backed by memory, POLATORY_TMPDIR should point to a directory on disk.
+class MappedFile {
+ public:
+  explicit MappedFile(std::size_t size);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+
+  void* data() const { return data_; }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  std::size_t size_;
+
+#ifdef _WIN32
+  void* file_{};
+  void* mapping_{};
+#else
+  int file_{};
+#endif
+
+  void* data_{};
+};
+
+}  // namespace polatory::common
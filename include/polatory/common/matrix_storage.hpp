@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <memory>
+#include <polatory/common/mapped_file.hpp>
+#include <polatory/types.hpp>
+
+namespace polatory::common {
+
+// Storage for a dense matrix.
+// In the out-of-core mode, the matrix is stored in a memory-mapped temporary file.
+class MatrixStorage {
+ public:
+  MatrixStorage() = default;
+
+  MatrixStorage(Index rows, Index cols, bool out_of_core) : rows_(rows), cols_(cols) {
+    if (out_of_core && rows > 0 && cols > 0) {
+      file_ = std::make_unique<MappedFile>(sizeof(double) * rows * cols);
+    } else {
+      matrix_ = MatX(rows, cols);
+    }
+  }
+
+  Eigen::Map<MatX> matrix() {
+    return {file_ ? static_cast<double*>(file_->data()) : matrix_.data(), rows_, cols_};
+  }
+
+  Eigen::Map<const MatX> matrix() const {
+    return {file_ ? static_cast<const double*>(file_->data()) : matrix_.data(), rows_, cols_};
+  }
+
+ private:
+  Index rows_{};
+  Index cols_{};
+  MatX matrix_;
+  std::unique_ptr<MappedFile> file_;
+};
+
+}  // namespace polatory::common
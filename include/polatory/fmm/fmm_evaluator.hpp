@@ -7,6 +7,7 @@
 #include <polatory/fmm/hessian_kernel.hpp>
 #include <polatory/fmm/kernel.hpp>
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/rbf/rbf.hpp>
 #include <polatory/rbf/rbf_base.hpp>
@@ -17,6 +18,7 @@ namespace polatory::fmm {
 template <int Dim>
 class FmmGenericEvaluatorBase {
   static constexpr int kDim = Dim;
+  using GridPoints = geometry::GridPoints<kDim>;
   using Points = geometry::Points<kDim>;
 
  public:
@@ -37,6 +39,10 @@ class FmmGenericEvaluatorBase {
 
   virtual void set_target_points(const Points& points) = 0;
 
+  // Sets the target points on a grid, which are generated block by block during evaluation
+  // instead of being stored all at once.
+  virtual void set_target_points(const GridPoints& points) = 0;
+
   virtual void set_weights(const Eigen::Ref<const VecX>& weights) = 0;
 };
 
@@ -49,6 +55,7 @@ class FmmGenericEvaluator final : public FmmGenericEvaluatorBase<Kernel::kDim> {
   static constexpr int kDim = Kernel::kDim;
 
   using Bbox = geometry::Bbox<kDim>;
+  using GridPoints = geometry::GridPoints<kDim>;
   using Points = geometry::Points<kDim>;
 
  public:
@@ -69,6 +76,8 @@ class FmmGenericEvaluator final : public FmmGenericEvaluatorBase<Kernel::kDim> {
 
   void set_target_points(const Points& points) override;
 
+  void set_target_points(const GridPoints& points) override;
+
   void set_weights(const Eigen::Ref<const VecX>& weights) override;
 
  private:
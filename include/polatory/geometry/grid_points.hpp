@@ -0,0 +1,113 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <iterator>
+#include <polatory/common/macros.hpp>
+#include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/types.hpp>
+#include <vector>
+
+namespace polatory::geometry {
+
+// A set of points on a regular grid, whose positions are implicit from the grid parameters.
+// The point with the grid index i is at (offset + i) * basis,
+// and the points are given as runs of consecutive indices along the first axis.
+template <int Dim>
+class GridPoints {
+  using Bbox = Bbox<Dim>;
+  using GridIndex = Eigen::Matrix<Index, 1, Dim>;
+  using Mat = Mat<Dim>;
+  using Point = Point<Dim>;
+  using Points = Points<Dim>;
+  using Vector = Vector<Dim>;
+
+  struct Run {
+    GridIndex start;
+    Index length;
+  };
+
+ public:
+  GridPoints(const Vector& offset, const Mat& basis) : offset_(offset), basis_(basis) {}
+
+  // Appends the points with the grid indices start, start + e_0, ..., start + (length - 1) e_0.
+  void add_run(const GridIndex& start, Index length) {
+    POLATORY_ASSERT(length >= 0);
+
+    if (length == 0) {
+      return;
+    }
+
+    runs_.push_back({start, length});
+    run_offsets_.push_back(run_offsets_.back() + length);
+  }
+
+  // Returns the bounding box of the points, which is determined by the ends of the runs.
+  Bbox bbox() const {
+    Points ends(2 * runs_.size(), Dim);
+    for (std::size_t r = 0; r < runs_.size(); r++) {
+      const auto& run = runs_.at(r);
+      GridIndex last = run.start;
+      last(0) += run.length - 1;
+      ends.row(2 * r) = position(run.start);
+      ends.row(2 * r + 1) = position(last);
+    }
+    return Bbox::from_points(ends);
+  }
+
+  // Calls fn(i, p) for each point p in [begin, end), where i is the index of the point.
+  template <class Fn>
+  void for_each_point(Index begin, Index end, Fn fn) const {
+    POLATORY_ASSERT(begin >= 0 && begin <= end && end <= rows());
+
+    if (begin == end) {
+      return;
+    }
+
+    auto r = static_cast<std::size_t>(
+        std::distance(run_offsets_.begin(),
+                      std::upper_bound(run_offsets_.begin(), run_offsets_.end(), begin)) -
+        1);
+    for (auto i = begin; i < end; r++) {
+      GridIndex index = runs_.at(r).start;
+      index(0) += i - run_offsets_.at(r);
+      auto run_end = std::min(run_offsets_.at(r + 1), end);
+      for (; i < run_end; i++, index(0)++) {
+        fn(i, position(index));
+      }
+    }
+  }
+
+  template <class Fn>
+  void for_each_point(Fn fn) const {
+    for_each_point(0, rows(), fn);
+  }
+
+  // Returns the positions of the points in [begin, end).
+  Points points(Index begin, Index end) const {
+    Points points(end - begin, Dim);
+    for_each_point(begin, end, [&](Index i, const Point& p) { points.row(i - begin) = p; });
+    return points;
+  }
+
+  Points points() const { return points(0, rows()); }
+
+  Index rows() const { return run_offsets_.back(); }
+
+ private:
+  Point position(const GridIndex& index) const {
+    return (offset_ + index.template cast<double>()) * basis_;
+  }
+
+  const Vector offset_;
+  const Mat basis_;
+  std::vector<Run> runs_;
+  std::vector<Index> run_offsets_{0};
+};
+
+using GridPoints1 = GridPoints<1>;
+using GridPoints2 = GridPoints<2>;
+using GridPoints3 = GridPoints<3>;
+
+}  // namespace polatory::geometry
@@ -7,11 +7,13 @@
 #include <memory>
 #include <polatory/common/io.hpp>
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolation/evaluator.hpp>
 #include <polatory/interpolation/fitter.hpp>
 #include <polatory/interpolation/incremental_fitter.hpp>
 #include <polatory/interpolation/inequality_fitter.hpp>
+#include <polatory/interpolation/query_evaluator.hpp>
 #include <polatory/model.hpp>
 #include <polatory/types.hpp>
 #include <stdexcept>
@@ -30,11 +32,13 @@ class Interpolant {
   using Bbox = geometry::Bbox<kDim>;
   using Evaluator = interpolation::Evaluator<kDim>;
   using Fitter = interpolation::Fitter<kDim>;
+  using GridPoints = geometry::GridPoints<kDim>;
   using IncrementalFitter = interpolation::IncrementalFitter<kDim>;
   using InequalityFitter = interpolation::InequalityFitter<kDim>;
   using Model = Model<kDim>;
   using Point = geometry::Point<kDim>;
   using Points = geometry::Points<kDim>;
+  using QueryEvaluator = interpolation::QueryEvaluator<kDim>;
 
  public:
   explicit Interpolant(const Model& model) : model_(model) {}
@@ -66,8 +70,24 @@ class Interpolant {
     return evaluate_impl(points, grad_points);
   }
 
+  // Evaluates the interpolant at the points on a grid, without storing all of them at once.
+  VecX evaluate(const GridPoints& points, double accuracy = kInfinity) {
+    throw_if_not_fitted();
+
+    check_accuracy(accuracy, kInfinity);
+
+    set_evaluation_bbox_impl(points.bbox(), accuracy, kInfinity);
+    return evaluate_impl(points);
+  }
+
   VecX evaluate_impl(const Points& points) const { return evaluate_impl(points, Points(0, kDim)); }
 
+  VecX evaluate_impl(const GridPoints& points) const {
+    throw_if_not_fitted();
+
+    return evaluator_->evaluate(points);
+  }
+
   VecX evaluate_impl(const Points& points, const Points& grad_points) const {
     throw_if_not_fitted();
 
@@ -103,6 +123,8 @@ class Interpolant {
     clear();
 
     Fitter fitter(model_, points, grad_points);
+    fitter.set_out_of_core(out_of_core_);
+    fitter.set_operator_type(op_type_);
     weights_ = fitter.fit(values, tolerance, grad_tolerance, max_iter, accuracy, grad_accuracy,
                           initial != nullptr ? &initial_weights : nullptr);
 
@@ -135,6 +157,8 @@ class Interpolant {
     clear();
 
     IncrementalFitter fitter(model_, points, grad_points);
+    fitter.set_out_of_core(out_of_core_);
+    fitter.set_operator_type(op_type_);
     std::vector<Index> center_indices;
     std::vector<Index> grad_center_indices;
     std::tie(center_indices, grad_center_indices, weights_) =
@@ -180,6 +204,8 @@ class Interpolant {
     clear();
 
     InequalityFitter fitter(model_, points);
+    fitter.set_out_of_core(out_of_core_);
+    fitter.set_operator_type(op_type_);
     std::vector<Index> center_indices;
     std::tie(center_indices, weights_) =
         fitter.fit(values, values_lb, values_ub, tolerance, max_iter, accuracy,
@@ -198,6 +224,16 @@ class Interpolant {
 
   const Model& model() const { return model_; }
 
+  VecX query(const Points& points) const {
+    throw_if_not_fitted();
+
+    if (!query_evaluator_) {
+      throw std::runtime_error("query bbox has not been set");
+    }
+
+    return query_evaluator_->evaluate(points);
+  }
+
   void set_evaluation_bbox_impl(const Bbox& bbox, double accuracy = kInfinity,
                                 double grad_accuracy = kInfinity) {
     throw_if_not_fitted();
@@ -209,6 +245,24 @@ class Interpolant {
     evaluator_->set_weights(weights_);
   }
 
+  // Stores the Krylov basis vectors and the polynomial matrices of the solver in memory-mapped
+  // temporary files during fitting, which allows fitting to larger point sets with a given amount
+  // of memory. See common::MappedFile for the location of the files.
+  void set_out_of_core(bool out_of_core) { out_of_core_ = out_of_core; }
+
+  // Selects the backend for the matrix-vector products during fitting.
+  // A hierarchical matrix can be faster than FMM when the solver takes many iterations.
+  void set_operator_type(interpolation::OperatorType op_type) { op_type_ = op_type; }
+
+  void set_query_bbox(const Bbox& bbox, double accuracy = kInfinity) {
+    throw_if_not_fitted();
+
+    check_accuracy(accuracy, kInfinity);
+
+    query_evaluator_ = std::make_unique<QueryEvaluator>(model_, centers_, grad_centers_, weights_,
+                                                        bbox.convex_hull(bbox_), accuracy);
+  }
+
   const VecX& weights() const {
     throw_if_not_fitted();
 
@@ -320,6 +374,7 @@ class Interpolant {
     grad_centers_ = Points();
     bbox_ = Bbox();
     weights_ = VecX();
+    query_evaluator_.reset(nullptr);
   }
 
   void throw_if_not_fitted() const {
@@ -329,6 +384,8 @@ class Interpolant {
   }
 
   Model model_;
+  bool out_of_core_{};
+  interpolation::OperatorType op_type_{};
   bool fitted_{};
   Points centers_;
   Points grad_centers_;
@@ -336,6 +393,7 @@ class Interpolant {
   VecX weights_;
 
   std::unique_ptr<Evaluator> evaluator_;
+  std::unique_ptr<QueryEvaluator> query_evaluator_;
 };
 
 }  // namespace polatory
@@ -6,6 +6,7 @@
 #include <polatory/common/macros.hpp>
 #include <polatory/fmm/fmm_evaluator.hpp>
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/model.hpp>
 #include <polatory/polynomial/monomial_basis.hpp>
@@ -21,6 +22,7 @@ class Evaluator {
   static constexpr double kInfinity = std::numeric_limits<double>::infinity();
   using Bbox = geometry::Bbox<kDim>;
   using FmmGenericEvaluatorPtr = fmm::FmmGenericEvaluatorPtr<kDim>;
+  using GridPoints = geometry::GridPoints<kDim>;
   using Model = Model<kDim>;
   using MonomialBasis = polynomial::MonomialBasis<kDim>;
   using Points = geometry::Points<kDim>;
@@ -88,6 +90,12 @@ class Evaluator {
     return evaluate();
   }
 
+  VecX evaluate(const GridPoints& target_points) {
+    set_target_points(target_points);
+
+    return evaluate();
+  }
+
   void set_source_points(const Points& points, const Points& grad_points) {
     mu_ = points.rows();
     sigma_ = grad_points.rows();
@@ -127,6 +135,23 @@ class Evaluator {
     }
   }
 
+  // Sets the target points on a grid, which are not stored all at once.
+  void set_target_points(const GridPoints& points) {
+    trg_mu_ = points.rows();
+    trg_sigma_ = 0;
+
+    for (std::size_t i = 0; i < a_.size(); ++i) {
+      a_.at(i)->set_target_points(points);
+      f_.at(i)->set_target_points(points);
+      ft_.at(i)->set_target_points(Points(0, kDim));
+      h_.at(i)->set_target_points(Points(0, kDim));
+    }
+
+    if (l_ > 0) {
+      p_->set_target_points(points);
+    }
+  }
+
   template <class Derived>
   void set_weights(const Eigen::MatrixBase<Derived>& weights) {
     POLATORY_ASSERT(weights.rows() == mu_ + kDim * sigma_ + l_);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <polatory/geometry/bbox3d.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolation/solver.hpp>
 #include <polatory/model.hpp>
@@ -10,6 +11,7 @@ namespace polatory::interpolation {
 template <int Dim>
 class Fitter {
   static constexpr int kDim = Dim;
+  using Bbox = geometry::Bbox<kDim>;
   using Model = Model<kDim>;
   using Points = geometry::Points<kDim>;
   using Solver = Solver<kDim>;
@@ -20,15 +22,24 @@ class Fitter {
 
   VecX fit(const VecX& values, double tolerance, double grad_tolerance, int max_iter,
            double accuracy, double grad_accuracy, const VecX* initial_weights = nullptr) const {
-    Solver solver(model_, points_, grad_points_, accuracy, grad_accuracy);
+    Solver solver(model_, Bbox::from_points(points_).convex_hull(Bbox::from_points(grad_points_)),
+                  accuracy, grad_accuracy, op_type_);
+    solver.set_out_of_core(out_of_core_);
+    solver.set_points(points_, grad_points_);
 
     return solver.solve(values, tolerance, grad_tolerance, max_iter, initial_weights);
   }
 
+  void set_out_of_core(bool out_of_core) { out_of_core_ = out_of_core; }
+
+  void set_operator_type(OperatorType op_type) { op_type_ = op_type; }
+
  private:
   const Model& model_;
   const Points& points_;
   const Points& grad_points_;
+  bool out_of_core_{};
+  OperatorType op_type_{};
 };
 
 }  // namespace polatory::interpolation
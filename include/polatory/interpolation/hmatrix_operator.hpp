@@ -0,0 +1,444 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <omp.h>
+#include <polatory/common/macros.hpp>
+#include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/krylov/linear_operator.hpp>
+#include <polatory/model.hpp>
+#include <polatory/polynomial/monomial_basis.hpp>
+#include <polatory/types.hpp>
+#include <utility>
+#include <vector>
+
+namespace polatory::interpolation {
+
+// Applies the same operator as Operator using a hierarchical matrix,
+// which is compressed once in set_points() and can then be applied many times at a low cost.
+// The admissible blocks are approximated by adaptive cross approximation (ACA)
+// with the given relative tolerance, and the others are stored as dense blocks.
+// Only the blocks in the upper triangle are stored, as the operator is symmetric.
+template <int Dim>
+class HMatrixOperator : public krylov::LinearOperator {
+  static constexpr int kDim = Dim;
+  using Bbox = geometry::Bbox<kDim>;
+  using Model = Model<kDim>;
+  using MonomialBasis = polynomial::MonomialBasis<kDim>;
+  using Points = geometry::Points<kDim>;
+  using Vector = geometry::Vector<kDim>;
+
+  // A pair of clusters (s, t) is admissible if min(diam(s), diam(t)) <= kEta * dist(s, t).
+  static constexpr double kEta = 1.0;
+  static constexpr Index kLeafSize = 64;
+  // The number of the rows summed at a time in the reduction of the partial products.
+  static constexpr Index kReductionChunkSize = 4096;
+
+ public:
+  static constexpr double kDefaultTolerance = 1e-8;
+
+  HMatrixOperator(const Model& model, const Points& points, const Points& grad_points,
+                  double tolerance = kDefaultTolerance)
+      : HMatrixOperator(model, tolerance) {
+    set_points(points, grad_points);
+  }
+
+  explicit HMatrixOperator(const Model& model, double tolerance = kDefaultTolerance)
+      : model_(model), l_(model.poly_basis_size()), tolerance_(tolerance) {
+    if (l_ > 0) {
+      poly_basis_ = std::make_unique<MonomialBasis>(model.poly_degree());
+    }
+  }
+
+  VecX operator()(const VecX& weights) const override {
+    POLATORY_ASSERT(weights.rows() == size());
+
+    auto n = mu_ + kDim * sigma_;
+    VecX x = weights.head(n)(dofs_);
+    VecX y_perm(n);
+
+    // Each thread accumulates the products of its blocks in its own column, as the blocks and
+    // their transposes overlap in rows. The columns are summed in parallel by chunks of rows.
+    // Partitioning the blocks by row ranges instead would avoid the columns, but would read
+    // a block twice whenever its transpose falls in another range, while the columns are
+    // negligible compared to the blocks.
+    MatX y_partial;
+
+    auto n_blocks = static_cast<Index>(blocks_.size());
+#pragma omp parallel
+    {
+#pragma omp single
+      y_partial.resize(n, omp_get_num_threads());
+
+      auto y_local = y_partial.col(omp_get_thread_num());
+      y_local.setZero();
+
+#pragma omp for schedule(dynamic)
+      for (Index i = 0; i < n_blocks; i++) {
+        const auto& b = blocks_.at(i);
+        auto m = b.low_rank ? b.u.rows() : b.dense.rows();
+        auto k = b.low_rank ? b.v.rows() : b.dense.cols();
+        auto xs = x.segment(b.row_begin, m);
+        auto xt = x.segment(b.col_begin, k);
+
+        if (b.low_rank) {
+          y_local.segment(b.row_begin, m) += b.u * (b.v.transpose() * xt);
+          y_local.segment(b.col_begin, k) += b.v * (b.u.transpose() * xs);
+        } else {
+          y_local.segment(b.row_begin, m) += b.dense * xt;
+          if (b.row_begin != b.col_begin) {
+            y_local.segment(b.col_begin, k) += b.dense.transpose() * xs;
+          }
+        }
+      }
+
+#pragma omp for schedule(static)
+      for (Index begin = 0; begin < n; begin += kReductionChunkSize) {
+        auto size = std::min(kReductionChunkSize, n - begin);
+        y_perm.segment(begin, size) = y_partial.middleRows(begin, size).rowwise().sum();
+      }
+    }
+
+    VecX y = VecX::Zero(size());
+    y.head(n)(dofs_) = y_perm;
+
+    y.head(mu_) += weights.head(mu_) * model_.nugget();
+
+    if (l_ > 0) {
+      // Add polynomial terms.
+      y.head(n) += p_ * weights.tail(l_);
+      y.tail(l_) += p_.transpose() * weights.head(n);
+    }
+
+    return y;
+  }
+
+  void set_points(const Points& points, const Points& grad_points) {
+    mu_ = points.rows();
+    sigma_ = grad_points.rows();
+
+    // Indices >= mu_ refer to grad points.
+    auto n_points = mu_ + sigma_;
+    points_ = Points(n_points, kDim);
+    points_ << points, grad_points;
+
+    // The clustering is done in the transformed space if possible,
+    // while the kernel is evaluated with the original points.
+    const auto& aniso = model_.rbfs().at(0).anisotropy();
+    Points a_points = model_.num_rbfs() == 1 ? geometry::transform_points<kDim>(aniso, points_)
+                                             : points_;
+
+    order_.resize(n_points);
+    std::iota(order_.begin(), order_.end(), 0);
+    clusters_.clear();
+    dofs_.clear();
+    dof_points_.clear();
+    dof_components_.clear();
+    if (n_points > 0) {
+      build_cluster(a_points, 0, n_points);
+    }
+
+    std::vector<std::pair<Index, Index>> dense_pairs;
+    std::vector<std::pair<Index, Index>> low_rank_pairs;
+    if (n_points > 0) {
+      partition(0, 0, dense_pairs, low_rank_pairs);
+    }
+
+    auto n_dense = static_cast<Index>(dense_pairs.size());
+    auto n_low_rank = static_cast<Index>(low_rank_pairs.size());
+    blocks_.clear();
+    blocks_.resize(n_dense + n_low_rank);
+
+#pragma omp parallel for schedule(dynamic)
+    for (Index i = 0; i < n_low_rank + n_dense; i++) {
+      auto [s, t] = i < n_low_rank ? low_rank_pairs.at(i) : dense_pairs.at(i - n_low_rank);
+      auto& b = blocks_.at(i);
+      b.row_begin = clusters_.at(s).dof_begin;
+      b.col_begin = clusters_.at(t).dof_begin;
+      b.low_rank = i < n_low_rank && aca(s, t, b.u, b.v);
+      if (!b.low_rank) {
+        b.u = MatX();
+        b.v = MatX();
+        b.dense = dense_block(s, t);
+      }
+    }
+
+    if (l_ > 0) {
+      p_ = poly_basis_->evaluate(points, grad_points);
+    }
+  }
+
+  Index size() const override { return mu_ + kDim * sigma_ + l_; }
+
+  // Returns the number of the stored matrix entries.
+  Index storage_size() const {
+    Index size{};
+    for (const auto& b : blocks_) {
+      size += b.dense.size() + b.u.size() + b.v.size();
+    }
+    return size;
+  }
+
+ private:
+  struct Block {
+    Index row_begin{};
+    Index col_begin{};
+    bool low_rank{};
+    MatX dense;
+    // The block is approximated by u * v^T.
+    MatX u;
+    MatX v;
+  };
+
+  struct Cluster {
+    Index begin{};
+    Index end{};
+    Index dof_begin{};
+    Index dof_end{};
+    Bbox bbox;
+    Index left{-1};
+    Index right{-1};
+  };
+
+  // Approximates the block by adaptive cross approximation with partial pivoting.
+  // Returns false if the approximation does not pay off.
+  bool aca(Index s, Index t, MatX& u, MatX& v) const {
+    const auto& cs = clusters_.at(s);
+    const auto& ct = clusters_.at(t);
+    auto m = cs.dof_end - cs.dof_begin;
+    auto n = ct.dof_end - ct.dof_begin;
+    auto max_rank = m * n / (m + n);
+
+    std::vector<VecX> us;
+    std::vector<VecX> vs;
+    std::vector<bool> used_rows(m);
+    auto norm2 = 0.0;
+    Index i = 0;
+
+    while (true) {
+      used_rows.at(i) = true;
+
+      VecX row = kernel_row(cs.dof_begin + i, t);
+      for (std::size_t r = 0; r < us.size(); r++) {
+        row -= us.at(r)(i) * vs.at(r);
+      }
+
+      Index j{};
+      auto pivot = row.cwiseAbs().maxCoeff(&j);
+
+      if (pivot > 0.0) {
+        if (static_cast<Index>(us.size()) == max_rank) {
+          return false;
+        }
+
+        VecX vk = row / row(j);
+        VecX uk = kernel_row(ct.dof_begin + j, s);
+        for (std::size_t r = 0; r < us.size(); r++) {
+          uk -= vs.at(r)(j) * us.at(r);
+        }
+
+        auto cross = 0.0;
+        for (std::size_t r = 0; r < us.size(); r++) {
+          cross += us.at(r).dot(uk) * vs.at(r).dot(vk);
+        }
+        auto uk_norm = uk.norm();
+        auto vk_norm = vk.norm();
+        norm2 += 2.0 * cross + uk_norm * uk_norm * vk_norm * vk_norm;
+
+        us.push_back(std::move(uk));
+        vs.push_back(std::move(vk));
+
+        if (uk_norm * vk_norm <= tolerance_ * std::sqrt(std::abs(norm2))) {
+          break;
+        }
+      }
+
+      // Choose the next row with the largest entry of the last column.
+      Index next = -1;
+      auto max = -1.0;
+      for (Index k = 0; k < m; k++) {
+        if (used_rows.at(k)) {
+          continue;
+        }
+        auto value = us.empty() ? 0.0 : std::abs(us.back()(k));
+        if (value > max) {
+          next = k;
+          max = value;
+        }
+      }
+      if (next < 0) {
+        break;
+      }
+      i = next;
+    }
+
+    auto rank = static_cast<Index>(us.size());
+    u = MatX(m, rank);
+    v = MatX(n, rank);
+    for (Index r = 0; r < rank; r++) {
+      u.col(r) = us.at(r);
+      v.col(r) = vs.at(r);
+    }
+    return true;
+  }
+
+  bool admissible(Index s, Index t) const {
+    const auto& bs = clusters_.at(s).bbox;
+    const auto& bt = clusters_.at(t).bbox;
+
+    auto diam = std::min(bs.width().norm(), bt.width().norm());
+    auto dist = (bs.min() - bt.max()).cwiseMax(bt.min() - bs.max()).cwiseMax(0.0).norm();
+    return dist > 0.0 && diam <= kEta * dist;
+  }
+
+  Index build_cluster(const Points& a_points, Index begin, Index end) {
+    auto c = static_cast<Index>(clusters_.size());
+    clusters_.emplace_back();
+
+    Bbox bbox;
+    for (auto k = begin; k < end; k++) {
+      auto p = a_points.row(order_.at(k));
+      bbox = bbox.convex_hull(Bbox{p, p});
+    }
+
+    Index left = -1;
+    Index right = -1;
+    if (end - begin > kLeafSize) {
+      int axis{};
+      bbox.width().maxCoeff(&axis);
+      auto mid = begin + (end - begin) / 2;
+      std::nth_element(order_.begin() + begin, order_.begin() + mid, order_.begin() + end,
+                       [&](Index i, Index j) { return a_points(i, axis) < a_points(j, axis); });
+      left = build_cluster(a_points, begin, mid);
+      right = build_cluster(a_points, mid, end);
+    } else {
+      // The leaves are visited in order, which defines the ordering of the unknowns.
+      for (auto k = begin; k < end; k++) {
+        auto i = order_.at(k);
+        if (i < mu_) {
+          dofs_.push_back(i);
+          dof_points_.push_back(i);
+          dof_components_.push_back(0);
+        } else {
+          for (auto a = 0; a < kDim; a++) {
+            dofs_.push_back(mu_ + kDim * (i - mu_) + a);
+            dof_points_.push_back(i);
+            dof_components_.push_back(a);
+          }
+        }
+      }
+    }
+
+    auto& cluster = clusters_.at(c);
+    cluster.begin = begin;
+    cluster.end = end;
+    cluster.dof_begin = left < 0 ? static_cast<Index>(dofs_.size()) - dof_count(begin, end)
+                                 : clusters_.at(left).dof_begin;
+    cluster.dof_end = left < 0 ? static_cast<Index>(dofs_.size()) : clusters_.at(right).dof_end;
+    cluster.bbox = bbox;
+    cluster.left = left;
+    cluster.right = right;
+    return c;
+  }
+
+  MatX dense_block(Index s, Index t) const {
+    const auto& cs = clusters_.at(s);
+    const auto& ct = clusters_.at(t);
+
+    MatX block(cs.dof_end - cs.dof_begin, ct.dof_end - ct.dof_begin);
+    for (auto r = cs.dof_begin; r < cs.dof_end; r++) {
+      block.row(r - cs.dof_begin) = kernel_row(r, t).transpose();
+    }
+    return block;
+  }
+
+  Index dof_count(Index begin, Index end) const {
+    Index count{};
+    for (auto k = begin; k < end; k++) {
+      count += order_.at(k) < mu_ ? 1 : kDim;
+    }
+    return count;
+  }
+
+  // Returns the entries of the operator between the unknown r and the unknowns in the cluster t.
+  VecX kernel_row(Index r, Index t) const {
+    const auto& ct = clusters_.at(t);
+    auto i = dof_points_.at(r);
+    auto a = dof_components_.at(r);
+    auto i_grad = i >= mu_;
+
+    VecX row = VecX::Zero(ct.dof_end - ct.dof_begin);
+    Index col{};
+    for (auto k = ct.begin; k < ct.end; k++) {
+      auto j = order_.at(k);
+      Vector diff = points_.row(i) - points_.row(j);
+
+      if (j < mu_) {
+        for (const auto& rbf : model_.rbfs()) {
+          row(col) += i_grad ? rbf.evaluate_gradient(diff)(a) : rbf.evaluate(diff);
+        }
+        col++;
+      } else {
+        for (const auto& rbf : model_.rbfs()) {
+          if (i_grad) {
+            row.segment<kDim>(col) -= rbf.evaluate_hessian(diff).row(a).transpose();
+          } else {
+            row.segment<kDim>(col) -= rbf.evaluate_gradient(diff).transpose();
+          }
+        }
+        col += kDim;
+      }
+    }
+    return row;
+  }
+
+  void partition(Index s, Index t, std::vector<std::pair<Index, Index>>& dense_pairs,
+                 std::vector<std::pair<Index, Index>>& low_rank_pairs) const {
+    if (s != t && admissible(s, t)) {
+      low_rank_pairs.emplace_back(s, t);
+      return;
+    }
+
+    const auto& cs = clusters_.at(s);
+    const auto& ct = clusters_.at(t);
+    if (cs.left < 0 || ct.left < 0) {
+      dense_pairs.emplace_back(s, t);
+      return;
+    }
+
+    if (s == t) {
+      partition(cs.left, cs.left, dense_pairs, low_rank_pairs);
+      partition(cs.left, cs.right, dense_pairs, low_rank_pairs);
+      partition(cs.right, cs.right, dense_pairs, low_rank_pairs);
+    } else {
+      partition(cs.left, ct.left, dense_pairs, low_rank_pairs);
+      partition(cs.left, ct.right, dense_pairs, low_rank_pairs);
+      partition(cs.right, ct.left, dense_pairs, low_rank_pairs);
+      partition(cs.right, ct.right, dense_pairs, low_rank_pairs);
+    }
+  }
+
+  const Model& model_;
+  const Index l_;
+  const double tolerance_;
+  Index mu_{};
+  Index sigma_{};
+  Points points_;
+
+  std::vector<Index> order_;
+  std::vector<Cluster> clusters_;
+  // The original index of each unknown in the hierarchical ordering.
+  std::vector<Index> dofs_;
+  std::vector<Index> dof_points_;
+  std::vector<int> dof_components_;
+  std::vector<Block> blocks_;
+
+  std::unique_ptr<MonomialBasis> poly_basis_;
+  MatX p_;
+};
+
+}  // namespace polatory::interpolation
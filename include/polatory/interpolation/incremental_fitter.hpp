@@ -64,7 +64,8 @@ class IncrementalFitter {
     auto sigma = static_cast<Index>(grad_centers.size());
     VecX weights = VecX::Zero(mu + kDim * sigma + l_);
 
-    Solver solver(model_, bbox_, accuracy, grad_accuracy);
+    Solver solver(model_, bbox_, accuracy, grad_accuracy, op_type_);
+    solver.set_out_of_core(out_of_core_);
     Evaluator res_eval(model_, bbox_, accuracy, grad_accuracy);
 
     while (true) {
@@ -212,6 +213,10 @@ class IncrementalFitter {
     return c_grad_residuals;
   }
 
+  void set_out_of_core(bool out_of_core) { out_of_core_ = out_of_core; }
+
+  void set_operator_type(OperatorType op_type) { op_type_ = op_type; }
+
  private:
   const Model& model_;
   const Index l_;
@@ -220,6 +225,8 @@ class IncrementalFitter {
   const Points& points_full_;
   const Points& grad_points_full_;
   const Bbox bbox_;
+  bool out_of_core_{};
+  OperatorType op_type_{};
 };
 
 }  // namespace polatory::interpolation
@@ -58,7 +58,8 @@ class InequalityFitter {
     auto n_ineq = static_cast<Index>(ineq_idcs.size());
     Points ineq_points = points_(ineq_idcs, Eigen::all);
 
-    Solver solver(model_, bbox_, accuracy, kInfinity);
+    Solver solver(model_, bbox_, accuracy, kInfinity, op_type_);
+    solver.set_out_of_core(out_of_core_);
     Evaluator res_eval(model_, bbox_, accuracy, kInfinity);
 
     VecX weights = VecX::Zero(n_points_ + n_poly_basis_);
@@ -185,6 +186,10 @@ class InequalityFitter {
     return {std::move(centers), std::move(center_weights)};
   }
 
+  void set_out_of_core(bool out_of_core) { out_of_core_ = out_of_core; }
+
+  void set_operator_type(OperatorType op_type) { op_type_ = op_type; }
+
  private:
   template <class Predicate>
   static std::vector<Index> arg_where(const VecX& v, Predicate predicate) {
@@ -206,6 +211,8 @@ class InequalityFitter {
   const Index n_poly_basis_;
 
   const Bbox bbox_;
+  bool out_of_core_{};
+  OperatorType op_type_{};
 };
 
 }  // namespace polatory::interpolation
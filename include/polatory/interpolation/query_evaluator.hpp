@@ -0,0 +1,387 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <numbers>
+#include <polatory/common/macros.hpp>
+#include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/interpolation/evaluator.hpp>
+#include <polatory/model.hpp>
+#include <polatory/types.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace polatory::interpolation {
+
+// Evaluates an interpolant at small batches of points with low latency.
+//
+// The bbox is divided into a regular grid of cells. The contribution of the centers in the
+// neighboring cells (the near field) is computed directly, and the rest of the field including
+// the polynomial (the far field), which is smooth within each cell, is interpolated from its values
+// at the tensor-product Chebyshev nodes of the cell, which are computed once on construction.
+// The cost of evaluating a single point is thus O(leaf_size + order^Dim).
+//
+// The target points must be within the bbox, as the interpolation is inaccurate outside the cells.
+template <int Dim>
+class QueryEvaluator {
+  static constexpr int kDim = Dim;
+  static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+  using Bbox = geometry::Bbox<kDim>;
+  using CellIndex = std::array<Index, kDim>;
+  using Evaluator = Evaluator<kDim>;
+  using Model = Model<kDim>;
+  using Point = geometry::Point<kDim>;
+  using Points = geometry::Points<kDim>;
+  using Vector = geometry::Vector<kDim>;
+  using Vectors = geometry::Vectors<kDim>;
+
+  static constexpr int kMaxOrder = 16;
+  static constexpr Index kParallelThreshold = 64;
+
+ public:
+  static constexpr Index kDefaultLeafSize = 32;
+  static constexpr int kDefaultOrder = 6;
+
+  QueryEvaluator(const Model& model, const Points& source_points, const Points& source_grad_points,
+                 const VecX& weights, const Bbox& bbox, double accuracy = kInfinity,
+                 Index leaf_size = kDefaultLeafSize, int order = kDefaultOrder)
+      : model_(model),
+        l_(model.poly_basis_size()),
+        mu_(source_points.rows()),
+        sigma_(source_grad_points.rows()),
+        order_(order) {
+    POLATORY_ASSERT(weights.rows() == mu_ + kDim * sigma_ + l_);
+
+    if (leaf_size < 1) {
+      throw std::invalid_argument("leaf_size must be positive");
+    }
+
+    // Polynomials up to degree 2 must be reproduced exactly by the interpolation.
+    if (order < 3 || order > kMaxOrder) {
+      throw std::invalid_argument(std::format("order must be within 3 to {}", kMaxOrder));
+    }
+
+    auto union_bbox = bbox.convex_hull(Bbox::from_points(source_points))
+                          .convex_hull(Bbox::from_points(source_grad_points));
+
+    bbox_ = union_bbox;
+    make_grid(union_bbox, mu_ + sigma_, leaf_size);
+    make_chebyshev_nodes();
+    sort_sources(source_points, source_grad_points, weights);
+    compute_far_field(source_points, source_grad_points, weights, union_bbox, accuracy);
+  }
+
+  VecX evaluate(const Points& target_points) const {
+    auto n_points = target_points.rows();
+
+    for (Index i = 0; i < n_points; i++) {
+      if (!bbox_.contains(target_points.row(i))) {
+        throw std::invalid_argument("target_points must be within the bbox");
+      }
+    }
+
+    VecX y(n_points);
+
+#pragma omp parallel for schedule(static) if (n_points >= kParallelThreshold)
+    for (Index i = 0; i < n_points; i++) {
+      Point p = target_points.row(i);
+      auto c = cell_index(p);
+      y(i) = far_field(c, p) + near_field(c, p);
+    }
+
+    return y;
+  }
+
+  Index num_cells() const { return n_cells_; }
+
+ private:
+  // Points on the upper boundary of the grid are assigned to the last cells.
+  CellIndex cell_index(const Point& p) const {
+    CellIndex c{};
+    for (auto d = 0; d < kDim; d++) {
+      auto t = std::floor((p(d) - min_(d)) / cell_width_(d));
+      c.at(d) = std::clamp(static_cast<Index>(t), Index{0}, dims_.at(d) - 1);
+    }
+    return c;
+  }
+
+  CellIndex cell_index(Index linear_index) const {
+    CellIndex c{};
+    for (auto d = 0; d < kDim; d++) {
+      c.at(d) = linear_index % dims_.at(d);
+      linear_index /= dims_.at(d);
+    }
+    return c;
+  }
+
+  Point cell_min(const CellIndex& c) const {
+    Point min;
+    for (auto d = 0; d < kDim; d++) {
+      min(d) = min_(d) + static_cast<double>(c.at(d)) * cell_width_(d);
+    }
+    return min;
+  }
+
+  void compute_far_field(const Points& source_points, const Points& source_grad_points,
+                         const VecX& weights, const Bbox& bbox, double accuracy) {
+    Points nodes(n_cells_ * n_nodes_, kDim);
+    for (Index cell = 0; cell < n_cells_; cell++) {
+      auto c = cell_index(cell);
+      nodes.middleRows(cell * n_nodes_, n_nodes_) = cell_nodes(c);
+    }
+
+    Evaluator eval(model_, source_points, source_grad_points, bbox, accuracy);
+    eval.set_weights(weights);
+    far_values_ = eval.evaluate(nodes);
+
+#pragma omp parallel for schedule(dynamic)
+    for (Index cell = 0; cell < n_cells_; cell++) {
+      auto c = cell_index(cell);
+      for (Index i = 0; i < n_nodes_; i++) {
+        auto k = cell * n_nodes_ + i;
+        far_values_(k) -= near_field(c, nodes.row(k));
+      }
+    }
+  }
+
+  Points cell_nodes(const CellIndex& c) const {
+    auto min = cell_min(c);
+
+    Points nodes(n_nodes_, kDim);
+    for (Index i = 0; i < n_nodes_; i++) {
+      auto ii = i;
+      for (auto d = 0; d < kDim; d++) {
+        auto t = nodes_.at(ii % order_);
+        nodes(i, d) = min(d) + 0.5 * (t + 1.0) * cell_width_(d);
+        ii /= order_;
+      }
+    }
+
+    return nodes;
+  }
+
+  double far_field(const CellIndex& c, const Point& p) const {
+    auto min = cell_min(c);
+
+    Eigen::Matrix<double, kMaxOrder, kDim> l;
+    for (auto d = 0; d < kDim; d++) {
+      auto t = 2.0 * (p(d) - min(d)) / cell_width_(d) - 1.0;
+      lagrange_weights(t, l.col(d).data());
+    }
+
+    const auto* f = far_values_.data() + linear_index(c) * n_nodes_;
+
+    auto y = 0.0;
+    for (Index i = 0; i < n_nodes_; i++) {
+      auto ii = i;
+      auto w = 1.0;
+      for (auto d = 0; d < kDim; d++) {
+        w *= l(ii % order_, d);
+        ii /= order_;
+      }
+      y += w * f[i];
+    }
+
+    return y;
+  }
+
+  // Calls fn(first, last) for each run of the neighboring cells of c
+  // that are contiguous in the linear index.
+  template <class Fn>
+  void for_each_near_run(const CellIndex& c, Fn fn) const {
+    auto lo0 = std::max(Index{0}, c.at(0) - 1);
+    auto hi0 = std::min(dims_.at(0) - 1, c.at(0) + 1);
+
+    auto n_runs = 1;
+    for (auto d = 1; d < kDim; d++) {
+      n_runs *= 3;
+    }
+
+    for (auto r = 0; r < n_runs; r++) {
+      auto nc = c;
+      nc.at(0) = lo0;
+      auto rr = r;
+      auto valid = true;
+      for (auto d = 1; d < kDim; d++) {
+        nc.at(d) = c.at(d) + rr % 3 - 1;
+        rr /= 3;
+        if (nc.at(d) < 0 || nc.at(d) >= dims_.at(d)) {
+          valid = false;
+          break;
+        }
+      }
+      if (!valid) {
+        continue;
+      }
+
+      auto first = linear_index(nc);
+      fn(first, first + hi0 - lo0 + 1);
+    }
+  }
+
+  void lagrange_weights(double t, double* l) const {
+    for (auto k = 0; k < order_; k++) {
+      if (t == nodes_.at(k)) {
+        std::fill(l, l + order_, 0.0);
+        l[k] = 1.0;
+        return;
+      }
+    }
+
+    auto sum = 0.0;
+    for (auto k = 0; k < order_; k++) {
+      l[k] = barycentric_weights_.at(k) / (t - nodes_.at(k));
+      sum += l[k];
+    }
+    for (auto k = 0; k < order_; k++) {
+      l[k] /= sum;
+    }
+  }
+
+  Index linear_index(const CellIndex& c) const {
+    Index index = 0;
+    for (auto d = kDim - 1; d >= 0; d--) {
+      index = index * dims_.at(d) + c.at(d);
+    }
+    return index;
+  }
+
+  void make_chebyshev_nodes() {
+    n_nodes_ = 1;
+    for (auto d = 0; d < kDim; d++) {
+      n_nodes_ *= order_;
+    }
+
+    nodes_.resize(order_);
+    barycentric_weights_.resize(order_);
+    for (auto k = 0; k < order_; k++) {
+      auto theta = (2.0 * k + 1.0) * std::numbers::pi / (2.0 * order_);
+      nodes_.at(k) = std::cos(theta);
+      barycentric_weights_.at(k) = (k % 2 == 0 ? 1.0 : -1.0) * std::sin(theta);
+    }
+  }
+
+  void make_grid(const Bbox& bbox, Index n_sources, Index leaf_size) {
+    min_ = bbox.is_empty() ? Point::Zero() : bbox.min();
+
+    Vector width = bbox.is_empty() ? Vector::Zero() : bbox.width();
+    auto max_width = width.maxCoeff();
+    if (max_width == 0.0) {
+      max_width = 1.0;
+    }
+    width = width.cwiseMax(1e-6 * max_width);
+
+    auto max_cells = std::max(Index{1}, (n_sources + leaf_size - 1) / leaf_size);
+
+    auto num_cells = [&](double h) {
+      Index n = 1;
+      for (auto d = 0; d < kDim; d++) {
+        n *= static_cast<Index>(std::ceil(width(d) / h));
+      }
+      return n;
+    };
+
+    // Find the smallest cell size for which the number of cells does not exceed max_cells.
+    auto h_lo = max_width / static_cast<double>(max_cells);
+    auto h_hi = max_width;
+    for (auto i = 0; i < 64; i++) {
+      auto h = std::sqrt(h_lo * h_hi);
+      if (num_cells(h) <= max_cells) {
+        h_hi = h;
+      } else {
+        h_lo = h;
+      }
+    }
+
+    n_cells_ = 1;
+    for (auto d = 0; d < kDim; d++) {
+      dims_.at(d) = std::max(Index{1}, static_cast<Index>(std::ceil(width(d) / h_hi)));
+      cell_width_(d) = width(d) / static_cast<double>(dims_.at(d));
+      n_cells_ *= dims_.at(d);
+    }
+  }
+
+  double near_field(const CellIndex& c, const Point& p) const {
+    auto y = 0.0;
+
+    for_each_near_run(c, [&](Index first, Index last) {
+      for (Index j = offsets_.at(first); j < offsets_.at(last); j++) {
+        Vector diff = p - points_.row(j);
+        for (const auto& rbf : model_.rbfs()) {
+          y += weights_(j) * rbf.evaluate(diff);
+        }
+      }
+
+      for (Index j = grad_offsets_.at(first); j < grad_offsets_.at(last); j++) {
+        Vector diff = p - grad_points_.row(j);
+        for (const auto& rbf : model_.rbfs()) {
+          y += grad_weights_.row(j).dot(-rbf.evaluate_gradient(diff));
+        }
+      }
+    });
+
+    return y;
+  }
+
+  void sort_sources(const Points& source_points, const Points& source_grad_points,
+                    const VecX& weights) {
+    auto sort = [this](const Points& points, std::vector<Index>& offsets) {
+      std::vector<Index> cells(points.rows());
+      offsets.assign(n_cells_ + 1, 0);
+      for (Index i = 0; i < points.rows(); i++) {
+        cells.at(i) = linear_index(cell_index(Point(points.row(i))));
+        offsets.at(cells.at(i) + 1)++;
+      }
+      for (Index cell = 0; cell < n_cells_; cell++) {
+        offsets.at(cell + 1) += offsets.at(cell);
+      }
+
+      std::vector<Index> perm(points.rows());
+      auto next = offsets;
+      for (Index i = 0; i < points.rows(); i++) {
+        perm.at(next.at(cells.at(i))++) = i;
+      }
+      return perm;
+    };
+
+    auto perm = sort(source_points, offsets_);
+    points_ = source_points(perm, Eigen::all);
+    weights_ = weights.head(mu_)(perm);
+
+    auto grad_perm = sort(source_grad_points, grad_offsets_);
+    grad_points_ = source_grad_points(grad_perm, Eigen::all);
+    grad_weights_ = weights.segment(mu_, kDim * sigma_)
+                        .template reshaped<Eigen::RowMajor>(sigma_, kDim)(grad_perm, Eigen::all);
+  }
+
+  // Held by value, as the owning Interpolant can be moved.
+  const Model model_;
+  const Index l_;
+  const Index mu_;
+  const Index sigma_;
+  const int order_;
+
+  Bbox bbox_;
+  Point min_;
+  Vector cell_width_;
+  CellIndex dims_{};
+  Index n_cells_{};
+  Index n_nodes_{};
+  std::vector<double> nodes_;
+  std::vector<double> barycentric_weights_;
+
+  std::vector<Index> offsets_;
+  std::vector<Index> grad_offsets_;
+  Points points_;
+  Points grad_points_;
+  VecX weights_;
+  Vectors grad_weights_;
+  VecX far_values_;
+};
+
+}  // namespace polatory::interpolation
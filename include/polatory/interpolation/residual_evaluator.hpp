@@ -2,6 +2,7 @@
 
 #include <Eigen/Core>
 #include <algorithm>
+#include <memory>
 #include <numeric>
 #include <polatory/common/macros.hpp>
 #include <polatory/geometry/bbox3d.hpp>
@@ -41,16 +42,34 @@ class ResidualEvaluator {
         l_(model.poly_basis_size()),
         mu_(points.rows()),
         sigma_(grad_points.rows()),
+        accuracy_(accuracy),
+        grad_accuracy_(grad_accuracy),
         points_(points),
         grad_points_(grad_points),
         direct_evaluator_(model, points, grad_points),
-        evaluator_(model, points, grad_points, accuracy, grad_accuracy) {}
+        owned_evaluator_(
+            std::make_unique<Evaluator>(model, points, grad_points, accuracy, grad_accuracy)),
+        evaluator_(*owned_evaluator_) {}
 
   ResidualEvaluator(const Model& model, const Bbox& bbox, double accuracy, double grad_accuracy)
       : model_(model),
         l_(model.poly_basis_size()),
+        accuracy_(accuracy),
+        grad_accuracy_(grad_accuracy),
         direct_evaluator_(model),
-        evaluator_(model, bbox, accuracy, grad_accuracy) {}
+        owned_evaluator_(std::make_unique<Evaluator>(model, bbox, accuracy, grad_accuracy)),
+        evaluator_(*owned_evaluator_) {}
+
+  // Uses the given evaluator, which can be shared with other users (e.g. Operator).
+  // The caller is responsible for keeping it alive and for setting its points.
+  ResidualEvaluator(const Model& model, Evaluator& evaluator, double accuracy,
+                    double grad_accuracy)
+      : model_(model),
+        l_(model.poly_basis_size()),
+        accuracy_(accuracy),
+        grad_accuracy_(grad_accuracy),
+        direct_evaluator_(model),
+        evaluator_(evaluator) {}
 
   template <class Derived>
   Convergence converged(const Eigen::MatrixBase<Derived>& weights, double tolerance,
@@ -90,6 +109,7 @@ class ResidualEvaluator {
     }
 
     {
+      evaluator_.set_accuracy(accuracy_, grad_accuracy_);
       evaluator_.set_weights(weights);
 
       VecX fit = evaluator_.evaluate();
@@ -114,7 +134,9 @@ class ResidualEvaluator {
     grad_points_ = grad_points;
 
     direct_evaluator_.set_source_points(points, grad_points);
-    evaluator_.set_points(points, grad_points);
+    if (owned_evaluator_) {
+      owned_evaluator_->set_points(points, grad_points);
+    }
   }
 
   template <class Derived>
@@ -153,6 +175,8 @@ class ResidualEvaluator {
  private:
   const Model& model_;
   const Index l_;
+  const double accuracy_;
+  const double grad_accuracy_;
 
   Index mu_{};
   Index sigma_{};
@@ -167,7 +191,8 @@ class ResidualEvaluator {
   Points direct_grad_points_;
   VecX direct_values_;
   mutable DirectEvaluator direct_evaluator_;
-  mutable Evaluator evaluator_;
+  std::unique_ptr<Evaluator> owned_evaluator_;
+  Evaluator& evaluator_;
 };
 
 }  // namespace polatory::interpolation
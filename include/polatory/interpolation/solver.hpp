@@ -5,13 +5,17 @@
 #include <iostream>
 #include <memory>
 #include <polatory/common/macros.hpp>
+#include <polatory/common/matrix_storage.hpp>
 #include <polatory/common/orthonormalize.hpp>
 #include <polatory/geometry/bbox3d.hpp>
 #include <polatory/geometry/point3d.hpp>
+#include <polatory/interpolation/hmatrix_operator.hpp>
 #include <polatory/interpolation/operator.hpp>
 #include <polatory/interpolation/residual_evaluator.hpp>
+#include <polatory/interpolation/symmetric_evaluator.hpp>
 #include <polatory/krylov/fgmres.hpp>
 #include <polatory/model.hpp>
+#include <polatory/polynomial/evaluate_into.hpp>
 #include <polatory/polynomial/monomial_basis.hpp>
 #include <polatory/preconditioner/ras_preconditioner.hpp>
 #include <polatory/types.hpp>
@@ -19,34 +23,56 @@
 
 namespace polatory::interpolation {
 
+// The backend used for computing the matrix-vector products in the Krylov iteration.
+enum class OperatorType {
+  // Fast multipole method (the default).
+  kFmm,
+  // Hierarchical matrix, which takes time to build but makes each iteration cheaper.
+  kHMatrix,
+};
+
 template <int Dim>
 class Solver {
   static constexpr int kDim = Dim;
   using Bbox = geometry::Bbox<kDim>;
+  using HMatrixOperator = HMatrixOperator<kDim>;
   using Model = Model<kDim>;
   using MonomialBasis = polynomial::MonomialBasis<kDim>;
   using Operator = Operator<kDim>;
   using Points = geometry::Points<kDim>;
   using Preconditioner = preconditioner::RasPreconditioner<kDim>;
   using ResidualEvaluator = ResidualEvaluator<kDim>;
+  using SymmetricEvaluator = SymmetricEvaluator<kDim>;
 
  public:
   Solver(const Model& model, const Points& points, const Points& grad_points, double accuracy,
-         double grad_accuracy)
-      : model_(model),
-        l_(model.poly_basis_size()),
-        mu_(points.rows()),
-        sigma_(grad_points.rows()),
-        op_(model, points, grad_points, 0.0, 0.0),
-        res_eval_(model, points, grad_points, accuracy, grad_accuracy) {
+         double grad_accuracy, OperatorType op_type = OperatorType::kFmm)
+      : Solver(model, Bbox::from_points(points).convex_hull(Bbox::from_points(grad_points)),
+               accuracy, grad_accuracy, op_type) {
     set_points(points, grad_points);
   }
 
-  Solver(const Model& model, const Bbox& bbox, double accuracy, double grad_accuracy)
+  Solver(const Model& model, const Bbox& bbox, double accuracy, double grad_accuracy,
+         OperatorType op_type = OperatorType::kFmm)
       : model_(model),
         l_(model.poly_basis_size()),
-        op_(model, bbox, 0.0, 0.0),
-        res_eval_(model, bbox, accuracy, grad_accuracy) {}
+        evaluator_(model, bbox),
+        res_eval_(model, evaluator_, accuracy, grad_accuracy) {
+    switch (op_type) {
+      case OperatorType::kFmm:
+        op_ = std::make_unique<Operator>(model, evaluator_, 0.0, 0.0);
+        break;
+      case OperatorType::kHMatrix:
+        hmatrix_op_ = std::make_unique<HMatrixOperator>(model);
+        break;
+      default:
+        throw std::invalid_argument("op_type is invalid");
+    }
+  }
+
+  // Stores the Krylov basis vectors and the dense matrices of size O(N) in the solver and the
+  // preconditioner in memory-mapped temporary files. Must be called before set_points().
+  void set_out_of_core(bool out_of_core) { out_of_core_ = out_of_core; }
 
   void set_points(const Points& points) { set_points(points, Points(0, kDim)); }
 
@@ -54,15 +80,24 @@ class Solver {
     mu_ = points.rows();
     sigma_ = grad_points.rows();
 
-    op_.set_points(points, grad_points);
+    // The FMM evaluator is shared by the operator and the residual evaluator.
+    evaluator_.set_points(points, grad_points);
+
+    if (op_) {
+      op_->set_points(points, grad_points);
+    } else {
+      hmatrix_op_->set_points(points, grad_points);
+    }
     res_eval_.set_points(points, grad_points);
 
-    pc_ = std::make_unique<Preconditioner>(model_, points, grad_points);
+    pc_ = std::make_unique<Preconditioner>(model_, points, grad_points, out_of_core_);
 
     if (l_ > 0) {
       MonomialBasis poly(model_.poly_degree());
-      p_ = poly.evaluate(points, grad_points);
-      common::orthonormalize_cols(p_);
+      p_ = common::MatrixStorage(mu_ + kDim * sigma_, l_, out_of_core_);
+      auto p = p_.matrix();
+      polynomial::evaluate_into(poly, points, grad_points, p);
+      common::orthonormalize_cols(p);
     }
   }
 
@@ -87,8 +122,9 @@ class Solver {
 
       if (l_ > 0) {
         // Orthogonalize weights against P.
-        VecX dot = p_.transpose() * weights.head(mu_ + kDim * sigma_);
-        weights.head(mu_ + kDim * sigma_) -= p_ * dot;
+        auto p = p_.matrix();
+        VecX dot = p.transpose() * weights.head(mu_ + kDim * sigma_);
+        weights.head(mu_ + kDim * sigma_) -= p * dot;
       }
     }
 
@@ -96,7 +132,8 @@ class Solver {
     rhs.head(mu_ + kDim * sigma_) = values;
     rhs.tail(l_) = VecX::Zero(l_);
 
-    krylov::Fgmres solver(op_, rhs, max_iter);
+    krylov::Fgmres solver(op(), rhs, max_iter);
+    solver.set_out_of_core(out_of_core_);
     solver.set_initial_solution(weights);
     solver.set_right_preconditioner(*pc_);
     solver.setup();
@@ -142,15 +179,25 @@ class Solver {
   }
 
  private:
+  const krylov::LinearOperator& op() const {
+    if (op_) {
+      return *op_;
+    }
+    return *hmatrix_op_;
+  }
+
   const Model& model_;
   const Index l_;
 
   Index mu_{};
   Index sigma_{};
-  Operator op_;
+  SymmetricEvaluator evaluator_;
+  std::unique_ptr<Operator> op_;
+  std::unique_ptr<HMatrixOperator> hmatrix_op_;
   mutable ResidualEvaluator res_eval_;
   std::unique_ptr<Preconditioner> pc_;
-  MatX p_;
+  common::MatrixStorage p_;
+  bool out_of_core_{};
 };
 
 }  // namespace polatory::interpolation
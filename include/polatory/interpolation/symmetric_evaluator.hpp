@@ -70,14 +70,23 @@ class SymmetricEvaluator {
     return y;
   }
 
+  // Changes the accuracy while keeping the points.
+  // The configurations found for each accuracy are cached, so that a single evaluator
+  // can be shared between users that require different accuracies.
+  void set_accuracy(double accuracy, double grad_accuracy) {
+    if (accuracy == accuracy_ && grad_accuracy == grad_accuracy_) {
+      return;
+    }
+
+    accuracy_ = accuracy;
+    grad_accuracy_ = grad_accuracy;
+    update_accuracy();
+  }
+
   void set_points(const Points& points, const Points& grad_points) {
     mu_ = points.rows();
     sigma_ = grad_points.rows();
 
-    auto accuracy = (sigma_ > 0 ? accuracy_ / 2.0 : accuracy_) / static_cast<double>(a_.size());
-    auto grad_accuracy =
-        (sigma_ > 0 ? grad_accuracy_ / 2.0 : grad_accuracy_) / static_cast<double>(a_.size());
-
     for (std::size_t i = 0; i < a_.size(); ++i) {
       a_.at(i)->set_points(points);
       f_.at(i)->set_source_points(grad_points);
@@ -85,13 +94,10 @@ class SymmetricEvaluator {
       ft_.at(i)->set_source_points(points);
       ft_.at(i)->set_target_points(grad_points);
       h_.at(i)->set_points(grad_points);
-
-      a_.at(i)->set_accuracy(accuracy);
-      f_.at(i)->set_accuracy(accuracy);
-      ft_.at(i)->set_accuracy(grad_accuracy);
-      h_.at(i)->set_accuracy(grad_accuracy);
     }
 
+    update_accuracy();
+
     if (l_ > 0) {
       p_->set_target_points(points, grad_points);
     }
@@ -114,9 +120,22 @@ class SymmetricEvaluator {
   }
 
  private:
+  void update_accuracy() {
+    auto accuracy = (sigma_ > 0 ? accuracy_ / 2.0 : accuracy_) / static_cast<double>(a_.size());
+    auto grad_accuracy =
+        (sigma_ > 0 ? grad_accuracy_ / 2.0 : grad_accuracy_) / static_cast<double>(a_.size());
+
+    for (std::size_t i = 0; i < a_.size(); ++i) {
+      a_.at(i)->set_accuracy(accuracy);
+      f_.at(i)->set_accuracy(accuracy);
+      ft_.at(i)->set_accuracy(grad_accuracy);
+      h_.at(i)->set_accuracy(grad_accuracy);
+    }
+  }
+
   const Index l_;
-  const double accuracy_;
-  const double grad_accuracy_;
+  double accuracy_;
+  double grad_accuracy_;
   Index mu_{};
   Index sigma_{};
 
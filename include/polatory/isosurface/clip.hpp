@@ -4,6 +4,7 @@
 #include <Eigen/Geometry>
 #include <Eigen/LU>
 #include <algorithm>
+#include <array>
 #include <boost/container_hash/hash.hpp>
 #include <iterator>
 #include <polatory/geometry/bbox3d.hpp>
@@ -29,16 +30,127 @@ class MeshClipper {
   MeshClipper(const Mesh& mesh, const Bbox& bbox) {
     const auto& vertices = mesh.vertices();
     const auto& faces = mesh.faces();
+    auto n_vertices = vertices.rows();
+    auto n_faces = faces.rows();
 
-    std::vector<Triangle> triangles;
-    for (auto f : faces.rowwise()) {
+    // Only the faces with a vertex on or outside the bbox need to be clipped.
+    std::vector<char> is_interior(n_vertices);
+#pragma omp parallel for
+    for (Index vi = 0; vi < n_vertices; vi++) {
+      auto v = vertices.row(vi);
+      is_interior.at(vi) = static_cast<char>(
+          (v.array() > bbox.min().array() && v.array() < bbox.max().array()).all());
+    }
+
+    std::vector<Index> boundary_fis;
+    for (Index fi = 0; fi < n_faces; fi++) {
+      auto f = faces.row(fi);
+      if (!is_interior.at(f(0)) || !is_interior.at(f(1)) || !is_interior.at(f(2))) {
+        boundary_fis.push_back(fi);
+      }
+    }
+
+    auto n_boundary_faces = static_cast<Index>(boundary_fis.size());
+    std::vector<std::vector<Triangle>> pieces(boundary_fis.size());
+#pragma omp parallel for schedule(guided)
+    for (Index i = 0; i < n_boundary_faces; i++) {
+      auto f = faces.row(boundary_fis.at(i));
       Point p = vertices.row(f(0));
       Point q = vertices.row(f(1));
       Point r = vertices.row(f(2));
-      triangles.push_back((Triangle() << p, q, r).finished());
+      pieces.at(i) = clip((Triangle() << p, q, r).finished(), bbox);
+    }
+
+    // Reindex the vertices in the order of appearance.
+    // The vertices generated by clipping are shared between adjacent faces
+    // as they are computed exactly in the same way.
+    std::vector<Index> vertex_map(n_vertices, -1);
+    std::unordered_map<Point, Index, PointHash> new_vertex_map;
+    std::vector<Point> clipped_vertices_v;
+    std::vector<Face> clipped_faces_v;
+
+    auto map_vertex = [&](Index vi) {
+      auto& new_vi = vertex_map.at(vi);
+      if (new_vi < 0) {
+        new_vi = static_cast<Index>(clipped_vertices_v.size());
+        clipped_vertices_v.emplace_back(vertices.row(vi));
+        original_vertices_.push_back(vi);
+        generating_faces_.push_back(-1);
+      }
+      return new_vi;
+    };
+
+    auto map_point = [&](const Point& p, Index fi) {
+      Face f = faces.row(fi);
+      for (auto vi : f) {
+        if (p == vertices.row(vi)) {
+          return map_vertex(vi);
+        }
+      }
+
+      auto [it, inserted] =
+          new_vertex_map.emplace(p, static_cast<Index>(clipped_vertices_v.size()));
+      if (inserted) {
+        clipped_vertices_v.push_back(p);
+        original_vertices_.push_back(-1);
+        generating_faces_.push_back(fi);
+      }
+      return it->second;
+    };
+
+    auto boundary_it = boundary_fis.begin();
+    auto pieces_it = pieces.begin();
+    for (Index fi = 0; fi < n_faces; fi++) {
+      Face f = faces.row(fi);
+      if (boundary_it == boundary_fis.end() || *boundary_it != fi) {
+        clipped_faces_v.emplace_back(map_vertex(f(0)), map_vertex(f(1)), map_vertex(f(2)));
+        continue;
+      }
+
+      for (const auto& tri : *pieces_it) {
+        auto v0 = map_point(tri.row(0), fi);
+        auto v1 = map_point(tri.row(1), fi);
+        auto v2 = map_point(tri.row(2), fi);
+        clipped_faces_v.emplace_back(v0, v1, v2);
+      }
+      ++boundary_it;
+      ++pieces_it;
     }
 
-    std::array<Mat, 6> permutations{
+    geometry::Points3 clipped_vertices(static_cast<Index>(clipped_vertices_v.size()), 3);
+    Faces clipped_faces(static_cast<Index>(clipped_faces_v.size()), 3);
+
+    for (std::size_t i = 0; i < clipped_vertices_v.size(); i++) {
+      clipped_vertices.row(static_cast<Index>(i)) = clipped_vertices_v.at(i);
+    }
+
+    for (std::size_t i = 0; i < clipped_faces_v.size(); i++) {
+      clipped_faces.row(static_cast<Index>(i)) = clipped_faces_v.at(i);
+    }
+
+    clipped_mesh_ = Mesh(std::move(clipped_vertices), std::move(clipped_faces));
+  }
+
+  const Mesh& clipped_mesh() const { return clipped_mesh_; }
+
+  // Returns the index of the original vertex for each vertex of the clipped mesh,
+  // or -1 if the vertex is generated by clipping.
+  const std::vector<Index>& original_vertices() const { return original_vertices_; }
+
+  // Returns the index of the original face that generated each vertex of the clipped mesh,
+  // or -1 if the vertex is an original one.
+  const std::vector<Index>& generating_faces() const { return generating_faces_; }
+
+ private:
+  struct PointHash {
+    std::size_t operator()(const Point& p) const noexcept {
+      return boost::hash_range(p.begin(), p.end());
+    }
+  };
+
+  // Clips the triangle by the six faces of the bbox.
+  static std::vector<Triangle> clip(const Triangle& triangle, const Bbox& bbox) {
+    static const std::array<Mat, 6> permutations{
         (Mat() << 1, 0, 0, 0, 1, 0, 0, 0, 1).finished(),   // x, y, z
         (Mat() << -1, 0, 0, 0, 0, 1, 0, 1, 0).finished(),  // -x, z, y
         (Mat() << 0, 1, 0, 0, 0, 1, 1, 0, 0).finished(),   // y, z, x
@@ -49,6 +161,7 @@ class MeshClipper {
     std::array<double, 6> thresholds{bbox.max()(0),  -bbox.min()(0), bbox.max()(1),
                                      -bbox.min()(1), bbox.max()(2),  -bbox.min()(2)};
 
+    std::vector<Triangle> triangles{triangle};
     std::vector<Triangle> clipped;
     for (auto face = 0; face < 6; face++) {
       const auto& perm = permutations.at(face);
@@ -64,42 +177,9 @@ class MeshClipper {
       clipped.clear();
     }
 
-    std::unordered_map<Point, Index, PointHash> vertex_map;
-    for (const auto& tri : triangles) {
-      for (auto v : tri.rowwise()) {
-        if (!vertex_map.contains(v)) {
-          vertex_map.emplace(v, static_cast<Index>(vertex_map.size()));
-        }
-      }
-    }
-
-    geometry::Points3 clipped_vertices(static_cast<Index>(vertex_map.size()), 3);
-    Faces clipped_faces(static_cast<Index>(triangles.size()), 3);
-
-    for (const auto& pair : vertex_map) {
-      clipped_vertices.row(pair.second) = pair.first;
-    }
-
-    for (std::size_t i = 0; i < triangles.size(); i++) {
-      const auto& tri = triangles.at(i);
-      auto face = clipped_faces.row(static_cast<Index>(i));
-      face(0) = vertex_map.at(tri.row(0));
-      face(1) = vertex_map.at(tri.row(1));
-      face(2) = vertex_map.at(tri.row(2));
-    }
-
-    clipped_mesh_ = Mesh(std::move(clipped_vertices), std::move(clipped_faces));
+    return triangles;
   }
 
-  const Mesh& clipped_mesh() const { return clipped_mesh_; }
-
- private:
-  struct PointHash {
-    std::size_t operator()(const Point& p) const noexcept {
-      return boost::hash_range(p.begin(), p.end());
-    }
-  };
-
   static void clip(Triangle& tri, double threshold, std::vector<Triangle>& clipped) {
     auto interior = 0;
     auto boundary = 0;
@@ -248,10 +328,94 @@ class MeshClipper {
   }
 
   Mesh clipped_mesh_;
+  std::vector<Index> original_vertices_;
+  std::vector<Index> generating_faces_;
 };
 
 inline Mesh clip(const Mesh& mesh, const geometry::Bbox3& bbox) {
   return MeshClipper(mesh, bbox).clipped_mesh();
 }
 
+// Clips meshes that are generated piece by piece against the bbox, and identifies the vertices
+// of the clipped meshes across the pieces. The vertices of the input meshes are identified by
+// the non-negative identifiers given with them. The vertices generated by clipping are identified
+// by negative identifiers, which are shared between the pieces by position, as they are computed
+// exactly in the same way from the same edge.
+class MeshStreamClipper {
+  using Point = geometry::Point3;
+
+  struct PointHash {
+    std::size_t operator()(const Point& p) const noexcept {
+      return boost::hash_range(p.begin(), p.end());
+    }
+  };
+
+  struct GeneratedVertex {
+    Point position;
+    // The identifiers of the vertices of the face that generated the vertex.
+    std::array<Index, 3> face_vertex_ids;
+  };
+
+ public:
+  explicit MeshStreamClipper(const geometry::Bbox3& bbox) : bbox_(bbox) {}
+
+  // Returns the clipped mesh and the identifiers of its vertices.
+  std::pair<Mesh, std::vector<Index>> clip(const Mesh& mesh, const std::vector<Index>& vertex_ids) {
+    MeshClipper clipper(mesh, bbox_);
+    const auto& clipped_mesh = clipper.clipped_mesh();
+    const auto& original_vertices = clipper.original_vertices();
+    const auto& generating_faces = clipper.generating_faces();
+
+    auto n_vertices = clipped_mesh.vertices().rows();
+    std::vector<Index> ids(n_vertices);
+    for (Index i = 0; i < n_vertices; i++) {
+      auto vi = original_vertices.at(i);
+      if (vi >= 0) {
+        ids.at(i) = vertex_ids.at(vi);
+        continue;
+      }
+
+      Point p = clipped_mesh.vertices().row(i);
+      auto [it, inserted] = generated_ids_.emplace(p, next_generated_id_);
+      if (inserted) {
+        auto f = mesh.faces().row(generating_faces.at(i));
+        generated_vertices_.emplace(
+            next_generated_id_,
+            GeneratedVertex{p, {vertex_ids.at(f(0)), vertex_ids.at(f(1)), vertex_ids.at(f(2))}});
+        next_generated_id_--;
+      }
+      ids.at(i) = it->second;
+    }
+
+    return {clipped_mesh, std::move(ids)};
+  }
+
+  // Returns whether the generated vertex has been released by release_vertices.
+  bool is_released(Index id) const { return !generated_vertices_.contains(id); }
+
+  // Releases the generated vertices that cannot appear in later pieces,
+  // given whether each input vertex has been released, i.e., cannot appear in later pieces.
+  // A generated vertex shared between two faces lies on their common edge, which cannot appear
+  // once either endpoint of it has been released; thus it is released once any two vertices
+  // of the face that generated it have been released.
+  template <class Released>
+  void release_vertices(Released released) {
+    std::erase_if(generated_vertices_, [&](const auto& id_vertex) {
+      const auto& [id, v] = id_vertex;
+      const auto& ids = v.face_vertex_ids;
+      if (std::count_if(ids.begin(), ids.end(), released) < 2) {
+        return false;
+      }
+      generated_ids_.erase(v.position);
+      return true;
+    });
+  }
+
+ private:
+  const geometry::Bbox3 bbox_;
+  Index next_generated_id_{-1};
+  std::unordered_map<Point, Index, PointHash> generated_ids_;
+  std::unordered_map<Index, GeneratedVertex> generated_vertices_;
+};
+
 }  // namespace polatory::isosurface
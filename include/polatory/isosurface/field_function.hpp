@@ -1,8 +1,10 @@
 #pragma once
 
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/types.hpp>
+#include <utility>
 
 namespace polatory::isosurface {
 
@@ -17,10 +19,25 @@ class FieldFunction {
 
   virtual VecX operator()(const geometry::Points3& points) const = 0;
 
+  // Evaluates the field at the points on a grid.
+  // Override this if the field can be evaluated without storing all the points at once.
+  virtual VecX evaluate_grid(const geometry::GridPoints3& points) const {
+    return (*this)(points.points());
+  }
+
   virtual void set_evaluation_bbox(const geometry::Bbox3& /*bbox*/) {}
 
  protected:
   FieldFunction() = default;
 };
 
+// A field function that can evaluate the gradients along with the values in a single call.
+// Isosurface uses the gradients to refine vertices with fewer evaluation passes.
+class FieldFunctionWithGradient : public FieldFunction {
+ public:
+  // Returns the values and the gradients at the points.
+  virtual std::pair<VecX, geometry::Vectors3> evaluate_with_gradient(
+      const geometry::Points3& points) const = 0;
+};
+
 }  // namespace polatory::isosurface
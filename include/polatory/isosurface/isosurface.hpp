@@ -5,10 +5,13 @@
 #include <polatory/isosurface/clip.hpp>
 #include <polatory/isosurface/mesh.hpp>
 #include <polatory/isosurface/mesh_defects_finder.hpp>
+#include <polatory/isosurface/mesh_stream_writer.hpp>
 #include <polatory/isosurface/rmt/lattice.hpp>
 #include <polatory/isosurface/sign.hpp>
 #include <stdexcept>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace polatory::isosurface {
 
@@ -39,6 +42,57 @@ class Isosurface {
     return generate_common();
   }
 
+  // Generates a mesh for each isovalue. The field is evaluated only once
+  // at each lattice node and the values are reused for all isovalues.
+  std::vector<Mesh> generate_multiple(FieldFunction& field_fn, const std::vector<double>& isovalues,
+                                      int refine = 1) {
+    if (refine < 0) {
+      throw std::runtime_error("refine must be non-negative");
+    }
+
+    field_fn.set_evaluation_bbox(lattice_.second_extended_bbox());
+
+    std::vector<double> node_values;
+    std::vector<Mesh> meshes;
+    meshes.reserve(isovalues.size());
+
+    for (auto isovalue : isovalues) {
+      lattice_.add_all_nodes(field_fn, isovalue, node_values);
+      lattice_.refine_vertices(field_fn, isovalue, refine);
+      meshes.push_back(generate_common());
+    }
+
+    return meshes;
+  }
+
+  // Same as generate, but the field is evaluated only around the surface,
+  // which is located by subdividing the cells of a coarse lattice with spacing
+  // 2^num_levels times the resolution. See rmt::Lattice::add_nodes_adaptively for details.
+  // A component of the surface smaller than a coarse cell can be missed if the field varies
+  // much faster around it than elsewhere, which can be mitigated by increasing
+  // lipschitz_safety_factor or decreasing num_levels.
+  Mesh generate_adaptive(FieldFunction& field_fn, double isovalue = 0.0, int refine = 1,
+                         int num_levels = 3, double lipschitz_safety_factor = 2.0) {
+    if (refine < 0) {
+      throw std::runtime_error("refine must be non-negative");
+    }
+
+    if (num_levels < 0) {
+      throw std::runtime_error("num_levels must be non-negative");
+    }
+
+    if (!(lipschitz_safety_factor >= 1.0)) {
+      throw std::runtime_error("lipschitz_safety_factor must be greater than or equal to 1");
+    }
+
+    field_fn.set_evaluation_bbox(lattice_.second_extended_bbox());
+
+    lattice_.add_nodes_adaptively(field_fn, isovalue, num_levels, lipschitz_safety_factor);
+    lattice_.refine_vertices(field_fn, isovalue, refine);
+
+    return generate_common();
+  }
+
   Mesh generate_from_seed_points(const geometry::Points3& seed_points, FieldFunction& field_fn,
                                  double isovalue = 0.0, int refine = 1) {
     if (seed_points.rows() == 0) {
@@ -57,38 +111,80 @@ class Isosurface {
     return generate_common();
   }
 
+  // Same as generate, but the mesh is written to the writer slab by slab,
+  // so that the entire lattice and mesh need not be held in memory.
+  void generate_streaming(FieldFunction& field_fn, MeshStreamWriter& writer,
+                          double isovalue = 0.0, int refine = 1) {
+    if (refine < 0) {
+      throw std::runtime_error("refine must be non-negative");
+    }
+
+    field_fn.set_evaluation_bbox(lattice_.second_extended_bbox());
+
+    // The vertices are identified across the slabs by their indices in the lattice
+    // and by the identifiers assigned by the clipper.
+    MeshStreamClipper clipper(lattice_.bbox());
+    lattice_.generate_mesh_slab_by_slab(
+        field_fn, isovalue, refine,
+        [this, &clipper, &writer](const Mesh& mesh, const std::vector<Index>& vertex_ids) {
+          auto released = [this](Index vi) { return lattice_.is_vertex_released(vi); };
+          clipper.release_vertices(released);
+          writer.release_vertices(
+              [&](Index id) { return id >= 0 ? released(id) : clipper.is_released(id); });
+
+          auto [clipped_mesh, clipped_vertex_ids] = clipper.clip(mesh, vertex_ids);
+          writer.write(clipped_mesh, clipped_vertex_ids);
+        });
+
+    writer.finish(lattice_.value_sign_at_arbitrary_point_within_bbox() == BinarySign::kNeg);
+
+    lattice_.clear();
+  }
+
  private:
   Mesh generate_common() {
     lattice_.cluster_vertices();
 
-    Mesh mesh;
+    // Only the clustering changes below, so the vertices and the faces are collected only once.
+    auto vertices = lattice_.get_vertices();
+    auto unclustered_faces = lattice_.get_unclustered_faces();
+    auto faces = lattice_.cluster_faces(unclustered_faces);
+
+    std::vector<Index> vis;
+    std::vector<Index> fis;
+    {
+      MeshDefectsFinder defects(vertices, faces);
+      vis = defects.singular_vertices();
+      fis = defects.intersecting_faces();
+    }
 
     // Unclustering non-manifold vertices may require a few iterations.
     while (true) {
-      mesh = lattice_.get_mesh();
-      MeshDefectsFinder defects(mesh);
-
-      auto vis = defects.singular_vertices();
-      auto fis = defects.intersecting_faces();
-
       std::unordered_set<Index> vertices_to_uncluster;
       for (auto vi : vis) {
         vertices_to_uncluster.insert(vi);
       }
       for (auto fi : fis) {
-        auto f = mesh.faces().row(fi);
+        auto f = faces.row(fi);
         vertices_to_uncluster.insert(f(0));
         vertices_to_uncluster.insert(f(1));
         vertices_to_uncluster.insert(f(2));
       }
 
-      auto num_unclustered = lattice_.uncluster_vertices(vertices_to_uncluster);
-      if (num_unclustered == 0) {
+      auto unclustered = lattice_.uncluster_vertices(vertices_to_uncluster);
+      if (unclustered.empty()) {
         break;
       }
+
+      faces = lattice_.cluster_faces(unclustered_faces);
+
+      // Only the faces around the unclustered vertices have changed.
+      MeshDefectsFinder defects(vertices, faces);
+      vis = defects.singular_vertices(unclustered);
+      fis = defects.intersecting_faces(unclustered);
     }
 
-    mesh = clip(mesh, lattice_.bbox());
+    auto mesh = clip(Mesh(std::move(vertices), std::move(faces)), lattice_.bbox());
 
     if (mesh.is_empty() &&
         lattice_.value_sign_at_arbitrary_point_within_bbox() == BinarySign::kNeg) {
@@ -1,18 +1,128 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
 #include <format>
 #include <fstream>
+#include <limits>
+#include <ostream>
+#include <polatory/common/io.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/isosurface/types.hpp>
-#include <polatory/numeric/conv.hpp>
 #include <polatory/types.hpp>
 #include <stdexcept>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace polatory::isosurface {
 
+namespace internal {
+
+// Writes the bytes appended to a buffer by append(i, buffer) for i = 0, ..., n - 1 in order.
+// The items are formatted in parallel in chunks, a bounded number of chunks at a time.
+template <class Append>
+void write_in_parallel(std::ostream& os, Index n, Append append) {
+  constexpr Index kChunkSize = 16384;
+  constexpr Index kChunksPerBatch = 64;
+
+  std::vector<std::string> buffers(kChunksPerBatch);
+  auto n_chunks = (n + kChunkSize - 1) / kChunkSize;
+  for (Index batch_begin = 0; batch_begin < n_chunks; batch_begin += kChunksPerBatch) {
+    auto batch_end = std::min(batch_begin + kChunksPerBatch, n_chunks);
+
+#pragma omp parallel for schedule(dynamic)
+    for (Index chunk = batch_begin; chunk < batch_end; chunk++) {
+      auto& buffer = buffers.at(chunk - batch_begin);
+      buffer.clear();
+      auto end = std::min((chunk + 1) * kChunkSize, n);
+      for (Index i = chunk * kChunkSize; i < end; i++) {
+        append(i, buffer);
+      }
+    }
+
+    for (Index chunk = batch_begin; chunk < batch_end; chunk++) {
+      const auto& buffer = buffers.at(chunk - batch_begin);
+      os.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+  }
+}
+
+// Appends the shortest decimal representation of the value, same as numeric::to_string.
+template <class T>
+void append_decimal(std::string& buffer, T value) {
+  std::array<char, 32> chars{};
+  auto [ptr, ec] = std::to_chars(chars.data(), chars.data() + chars.size(), value);
+  buffer.append(chars.data(), ptr);
+}
+
+// Appends the bytes of the value in little-endian order.
+template <class T>
+void append_little_endian(std::string& buffer, T value) {
+  auto bytes = std::bit_cast<std::array<char, sizeof(T)>>(value);
+  if constexpr (std::endian::native == std::endian::big) {
+    std::reverse(bytes.begin(), bytes.end());
+  }
+  buffer.append(bytes.data(), bytes.size());
+}
+
+inline void append_obj_vertex(std::string& buffer, const geometry::Point3& v) {
+  buffer += "v ";
+  append_decimal(buffer, v(0));
+  buffer += ' ';
+  append_decimal(buffer, v(1));
+  buffer += ' ';
+  append_decimal(buffer, v(2));
+  buffer += '\n';
+}
+
+// vi_offset is added to the vertex indices, which are 1-based in OBJ.
+inline void append_obj_face(std::string& buffer, const Face& f, Index vi_offset) {
+  buffer += "f ";
+  append_decimal(buffer, f(0) + vi_offset);
+  buffer += ' ';
+  append_decimal(buffer, f(1) + vi_offset);
+  buffer += ' ';
+  append_decimal(buffer, f(2) + vi_offset);
+  buffer += '\n';
+}
+
+// Appends a triangle in the binary STL format.
+inline void append_stl_triangle(std::string& buffer, const geometry::Point3& p,
+                                const geometry::Point3& q, const geometry::Point3& r) {
+  geometry::Vector3 normal = (q - p).cross(r - p).normalized();
+  for (const auto& v : {normal, p, q, r}) {
+    append_little_endian(buffer, static_cast<float>(v(0)));
+    append_little_endian(buffer, static_cast<float>(v(1)));
+    append_little_endian(buffer, static_cast<float>(v(2)));
+  }
+  append_little_endian(buffer, std::uint16_t{0});
+}
+
+// Returns the 80-byte header of a binary STL file.
+inline std::string stl_header(const std::string& comment) {
+  // The header must not begin with "solid", which indicates an ASCII STL file.
+  auto header = "polatory " + comment;
+  header.resize(80, ' ');
+  return header;
+}
+
+inline std::string lowercase_extension(const std::string& filename) {
+  auto ext = std::filesystem::path(filename).extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  return ext;
+}
+
+}  // namespace internal
+
 struct EntireTag {};
 
 class Mesh {
@@ -25,8 +135,23 @@ class Mesh {
 
   explicit Mesh(EntireTag /*tag*/) : entire_(true) {}
 
+  // Exports the mesh in the format determined by the extension of the filename:
+  // .ply (binary PLY), .stl (binary STL), .raw (see save) or OBJ otherwise.
+  void export_file(const std::string& filename) const {
+    auto ext = internal::lowercase_extension(filename);
+    if (ext == ".ply") {
+      export_ply(filename);
+    } else if (ext == ".stl") {
+      export_stl(filename);
+    } else if (ext == ".raw") {
+      save(filename);
+    } else {
+      export_obj(filename);
+    }
+  }
+
   void export_obj(const std::string& filename) const {
-    std::ofstream ofs(filename);
+    std::ofstream ofs(filename, std::ios::binary);
     if (!ofs) {
       throw std::runtime_error(std::format("cannot open file '{}'", filename));
     }
@@ -39,14 +164,82 @@ class Mesh {
       }
     }
 
-    for (auto v : vertices_.rowwise()) {
-      ofs << "v " << numeric::to_string(v(0)) << ' ' << numeric::to_string(v(1)) << ' '
-          << numeric::to_string(v(2)) << '\n';
+    internal::write_in_parallel(ofs, vertices_.rows(), [this](Index i, std::string& buffer) {
+      internal::append_obj_vertex(buffer, vertices_.row(i));
+    });
+
+    internal::write_in_parallel(ofs, faces_.rows(), [this](Index i, std::string& buffer) {
+      internal::append_obj_face(buffer, faces_.row(i), 1);
+    });
+  }
+
+  // Exports the mesh in the binary PLY format with double-precision coordinates.
+  void export_ply(const std::string& filename) const {
+    if (vertices_.rows() > std::numeric_limits<std::int32_t>::max()) {
+      throw std::runtime_error("too many vertices for PLY");
     }
 
-    for (auto f : faces_.rowwise()) {
-      ofs << "f " << f(0) + 1 << ' ' << f(1) + 1 << ' ' << f(2) + 1 << '\n';
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs) {
+      throw std::runtime_error(std::format("cannot open file '{}'", filename));
     }
+
+    ofs << "ply\n"
+        << "format binary_little_endian 1.0\n";
+    if (faces_.rows() == 0) {
+      ofs << (entire_ ? "comment entire\n" : "comment empty\n");
+    }
+    ofs << "element vertex " << vertices_.rows() << '\n'
+        << "property double x\n"
+        << "property double y\n"
+        << "property double z\n"
+        << "element face " << faces_.rows() << '\n'
+        << "property list uchar int vertex_indices\n"
+        << "end_header\n";
+
+    if constexpr (std::endian::native == std::endian::little) {
+      // The vertices are stored in the same layout.
+      // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+      ofs.write(reinterpret_cast<const char*>(vertices_.data()),
+                static_cast<std::streamsize>(sizeof(double) * vertices_.size()));
+    } else {
+      internal::write_in_parallel(ofs, vertices_.rows(), [this](Index i, std::string& buffer) {
+        for (auto x : vertices_.row(i)) {
+          internal::append_little_endian(buffer, x);
+        }
+      });
+    }
+
+    internal::write_in_parallel(ofs, faces_.rows(), [this](Index i, std::string& buffer) {
+      buffer += static_cast<char>(3);
+      for (auto vi : faces_.row(i)) {
+        internal::append_little_endian(buffer, static_cast<std::int32_t>(vi));
+      }
+    });
+  }
+
+  // Exports the mesh in the binary STL format, which has single-precision coordinates
+  // and no vertex sharing between faces.
+  void export_stl(const std::string& filename) const {
+    if (faces_.rows() > std::numeric_limits<std::uint32_t>::max()) {
+      throw std::runtime_error("too many faces for STL");
+    }
+
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs) {
+      throw std::runtime_error(std::format("cannot open file '{}'", filename));
+    }
+
+    const auto* comment = faces_.rows() > 0 ? "" : entire_ ? "entire" : "empty";
+    auto header = internal::stl_header(comment);
+    internal::append_little_endian(header, static_cast<std::uint32_t>(faces_.rows()));
+    ofs << header;
+
+    internal::write_in_parallel(ofs, faces_.rows(), [this](Index i, std::string& buffer) {
+      auto f = faces_.row(i);
+      internal::append_stl_triangle(buffer, vertices_.row(f(0)), vertices_.row(f(1)),
+                                    vertices_.row(f(2)));
+    });
   }
 
   const Faces& faces() const { return faces_; }
@@ -57,10 +250,40 @@ class Mesh {
 
   const Points& vertices() const { return vertices_; }
 
+  // The file consists of the number of vertices (int64), the vertices (double[3] each),
+  // the number of faces (int64), the faces (int64[3] each) and whether the mesh is entire
+  // (uint8) in the native byte order. The arrays are 8-byte aligned,
+  // so they can be used in place by mapping the file into memory.
+  POLATORY_IMPLEMENT_LOAD_SAVE(Mesh);
+
  private:
+  POLATORY_FRIEND_READ_WRITE;
+
   Points vertices_;
   Faces faces_;
   bool entire_{};
 };
 
 }  // namespace polatory::isosurface
+
+namespace polatory::common {
+
+template <>
+struct Read<isosurface::Mesh> {
+  void operator()(std::istream& is, isosurface::Mesh& t) const {
+    read(is, t.vertices_);
+    read(is, t.faces_);
+    read(is, t.entire_);
+  }
+};
+
+template <>
+struct Write<isosurface::Mesh> {
+  void operator()(std::ostream& os, const isosurface::Mesh& t) const {
+    write(os, t.vertices_);
+    write(os, t.faces_);
+    write(os, t.entire_);
+  }
+};
+
+}  // namespace polatory::common
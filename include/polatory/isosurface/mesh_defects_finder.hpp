@@ -15,13 +15,27 @@ class MeshDefectsFinder {
  public:
   explicit MeshDefectsFinder(const Mesh& mesh);
 
+  MeshDefectsFinder(const Points& vertices, const Faces& faces);
+
   std::vector<Index> intersecting_faces() const;
 
   std::vector<Index> singular_vertices() const;
 
+  // Same as above, but only the vertices in vis or adjacent to them and the faces around them
+  // are checked. This is sufficient to find new defects after the faces around vis are changed.
+  std::vector<Index> intersecting_faces(const std::vector<Index>& vis) const;
+
+  std::vector<Index> singular_vertices(const std::vector<Index>& vis) const;
+
  private:
   bool edge_face_intersect(Index vi, Index vj, Index fi) const;
 
+  void find_intersecting_faces_around(Index vi, std::vector<Index>& result) const;
+
+  bool is_singular(Index vi) const;
+
+  std::vector<Index> neighborhood(const std::vector<Index>& vis) const;
+
   Index next_vertex(Index fi, Index vi) const;
 
   Index prev_vertex(Index fi, Index vi) const;
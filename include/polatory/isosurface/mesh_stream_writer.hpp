@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <polatory/isosurface/mesh.hpp>
+#include <polatory/isosurface/types.hpp>
+#include <polatory/types.hpp>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace polatory::isosurface {
+
+// Writes a mesh to a file chunk by chunk, in the binary STL format if the extension
+// of the filename is .stl, or in the OBJ format otherwise.
+// In an OBJ file, the vertices of the chunks can be identified across the chunks by stable
+// identifiers; a vertex is written only once so that the faces refer to the same global index.
+class MeshStreamWriter {
+ public:
+  explicit MeshStreamWriter(const std::string& filename) {
+    auto ext = internal::lowercase_extension(filename);
+    if (ext == ".ply" || ext == ".raw") {
+      throw std::invalid_argument(std::format("cannot stream a mesh to a {} file", ext));
+    }
+    stl_ = ext == ".stl";
+
+    ofs_.open(filename, std::ios::binary);
+    if (!ofs_) {
+      throw std::runtime_error(std::format("cannot open file '{}'", filename));
+    }
+
+    if (stl_) {
+      // The header is rewritten by finish.
+      ofs_ << std::string(84, '\0');
+    }
+  }
+
+  // Writes a comment if no faces have been written. entire indicates whether
+  // the entire bbox is enclosed by the surface in that case.
+  void finish(bool entire) {
+    const auto* comment = num_faces_ > 0 ? "" : entire ? "entire" : "empty";
+
+    if (stl_) {
+      if (num_faces_ > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("too many faces for STL");
+      }
+
+      auto header = internal::stl_header(comment);
+      internal::append_little_endian(header, static_cast<std::uint32_t>(num_faces_));
+      ofs_.seekp(0);
+      ofs_ << header;
+    } else if (num_faces_ == 0) {
+      ofs_ << "# " << comment << '\n';
+    }
+    ofs_.flush();
+  }
+
+  Index num_faces() const { return num_faces_; }
+
+  Index num_vertices() const { return num_vertices_; }
+
+  // Writes the chunk, whose vertices are not shared with other chunks.
+  void write(const Mesh& mesh) {
+    std::vector<Index> rows(mesh.vertices().rows());
+    std::iota(rows.begin(), rows.end(), Index{0});
+    std::vector<Index> global_vis(rows.size());
+    std::iota(global_vis.begin(), global_vis.end(), num_vertices_);
+    num_vertices_ += mesh.vertices().rows();
+    write_impl(mesh, global_vis, rows);
+  }
+
+  // Writes the chunk, whose vertices are identified by vertex_ids across the chunks.
+  // The vertices that have been written before are not written again.
+  void write(const Mesh& mesh, const std::vector<Index>& vertex_ids) {
+    std::vector<Index> global_vis(mesh.vertices().rows());
+    std::vector<Index> new_vertex_rows;
+    for (Index i = 0; i < mesh.vertices().rows(); i++) {
+      auto [it, inserted] = vertex_map_.emplace(vertex_ids.at(i), num_vertices_);
+      if (inserted) {
+        num_vertices_++;
+        new_vertex_rows.push_back(i);
+      }
+      global_vis.at(i) = it->second;
+    }
+    write_impl(mesh, global_vis, new_vertex_rows);
+  }
+
+  // Forgets the identifiers of the vertices for which released returns true,
+  // which must not appear in later chunks.
+  template <class Released>
+  void release_vertices(Released released) {
+    std::erase_if(vertex_map_, [&](const auto& id_vi) { return released(id_vi.first); });
+  }
+
+ private:
+  void write_impl(const Mesh& mesh, const std::vector<Index>& global_vis,
+                  const std::vector<Index>& new_vertex_rows) {
+    const auto& vertices = mesh.vertices();
+    const auto& faces = mesh.faces();
+
+    if (stl_) {
+      internal::write_in_parallel(ofs_, faces.rows(), [&](Index i, std::string& buffer) {
+        auto f = faces.row(i);
+        internal::append_stl_triangle(buffer, vertices.row(f(0)), vertices.row(f(1)),
+                                      vertices.row(f(2)));
+      });
+      num_faces_ += faces.rows();
+      return;
+    }
+
+    internal::write_in_parallel(
+        ofs_, static_cast<Index>(new_vertex_rows.size()), [&](Index i, std::string& buffer) {
+          internal::append_obj_vertex(buffer, vertices.row(new_vertex_rows.at(i)));
+        });
+
+    internal::write_in_parallel(ofs_, faces.rows(), [&](Index i, std::string& buffer) {
+      auto f = faces.row(i);
+      Face global_f(global_vis.at(f(0)), global_vis.at(f(1)), global_vis.at(f(2)));
+      internal::append_obj_face(buffer, global_f, 1);
+    });
+    num_faces_ += faces.rows();
+  }
+
+  std::ofstream ofs_;
+  bool stl_{};
+  Index num_vertices_{};
+  Index num_faces_{};
+  // Maps the identifiers of the vertices to their global indices.
+  std::unordered_map<Index, Index> vertex_map_;
+};
+
+}  // namespace polatory::isosurface
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <Eigen/Core>
 #include <limits>
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolant.hpp>
 #include <polatory/isosurface/field_function.hpp>
 #include <polatory/types.hpp>
+#include <utility>
 
 namespace polatory::isosurface {
 
@@ -22,6 +25,48 @@ class RbfFieldFunction : public FieldFunction {
     return interpolant_.evaluate_impl(points);
   }
 
+  VecX evaluate_grid(const geometry::GridPoints3& points) const override {
+    return interpolant_.evaluate_impl(points);
+  }
+
+  void set_evaluation_bbox(const geometry::Bbox3& bbox) override {
+    interpolant_.set_evaluation_bbox_impl(bbox, accuracy_, grad_accuracy_);
+  }
+
+ private:
+  Interpolant& interpolant_;
+  double accuracy_;
+  double grad_accuracy_;
+};
+
+// Same as RbfFieldFunction, but the vertices are refined with the gradients.
+// Each refinement pass costs more, as the gradients are evaluated along with the values,
+// but fewer passes are needed for the same accuracy.
+class RbfFieldFunctionWithGradient : public FieldFunctionWithGradient {
+  static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+  using Interpolant = Interpolant<3>;
+
+ public:
+  explicit RbfFieldFunctionWithGradient(Interpolant& interpolant, double accuracy = kInfinity,
+                                        double grad_accuracy = kInfinity)
+      : interpolant_(interpolant), accuracy_(accuracy), grad_accuracy_(grad_accuracy) {}
+
+  VecX operator()(const geometry::Points3& points) const override {
+    return interpolant_.evaluate_impl(points);
+  }
+
+  VecX evaluate_grid(const geometry::GridPoints3& points) const override {
+    return interpolant_.evaluate_impl(points);
+  }
+
+  std::pair<VecX, geometry::Vectors3> evaluate_with_gradient(
+      const geometry::Points3& points) const override {
+    auto n = points.rows();
+    VecX values = interpolant_.evaluate_impl(points, points);
+
+    return {values.head(n), values.tail(3 * n).reshaped<Eigen::RowMajor>(n, 3)};
+  }
+
   void set_evaluation_bbox(const geometry::Bbox3& bbox) override {
     interpolant_.set_evaluation_bbox_impl(bbox, accuracy_, grad_accuracy_);
   }
@@ -1,11 +1,13 @@
 #pragma once
 
+#include <Eigen/Core>
 #include <limits>
 #include <polatory/geometry/bbox3d.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolant.hpp>
 #include <polatory/isosurface/field_function.hpp>
 #include <polatory/types.hpp>
+#include <utility>
 
 namespace polatory::isosurface {
 
@@ -36,4 +38,45 @@ class RbfFieldFunction25D : public FieldFunction {
   double grad_accuracy_;
 };
 
+// Same as RbfFieldFunction25D, but the vertices are refined with the gradients.
+class RbfFieldFunction25DWithGradient : public FieldFunctionWithGradient {
+  static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+  using Interpolant = Interpolant<2>;
+
+ public:
+  explicit RbfFieldFunction25DWithGradient(Interpolant& interpolant, double accuracy = kInfinity,
+                                           double grad_accuracy = kInfinity)
+      : interpolant_(interpolant), accuracy_(accuracy), grad_accuracy_(grad_accuracy) {}
+
+  VecX operator()(const geometry::Points3& points) const override {
+    geometry::Points2 points_2d(points.leftCols(2));
+
+    return points.col(2) - interpolant_.evaluate_impl(points_2d);
+  }
+
+  std::pair<VecX, geometry::Vectors3> evaluate_with_gradient(
+      const geometry::Points3& points) const override {
+    auto n = points.rows();
+    geometry::Points2 points_2d(points.leftCols(2));
+    VecX values_2d = interpolant_.evaluate_impl(points_2d, points_2d);
+
+    geometry::Vectors3 gradients(n, 3);
+    gradients.leftCols(2) = -values_2d.tail(2 * n).reshaped<Eigen::RowMajor>(n, 2);
+    gradients.col(2).setOnes();
+
+    return {points.col(2) - values_2d.head(n), std::move(gradients)};
+  }
+
+  void set_evaluation_bbox(const geometry::Bbox3& bbox) override {
+    geometry::Bbox2 bbox_2d{bbox.min().head<2>(), bbox.max().head<2>()};
+
+    interpolant_.set_evaluation_bbox_impl(bbox_2d, accuracy_, grad_accuracy_);
+  }
+
+ private:
+  Interpolant& interpolant_;
+  double accuracy_;
+  double grad_accuracy_;
+};
+
 }  // namespace polatory::isosurface
@@ -5,11 +5,17 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <deque>
 #include <iterator>
+#include <limits>
+#include <numeric>
+#include <polatory/common/macros.hpp>
 #include <polatory/geometry/bbox3d.hpp>
 #include <polatory/geometry/point3d.hpp>
+#include <polatory/isosurface/bit.hpp>
 #include <polatory/isosurface/field_function.hpp>
 #include <polatory/isosurface/mesh.hpp>
+#include <polatory/isosurface/mesh_defects_finder.hpp>
 #include <polatory/isosurface/rmt/edge.hpp>
 #include <polatory/isosurface/rmt/neighbor.hpp>
 #include <polatory/isosurface/rmt/node.hpp>
@@ -19,6 +25,8 @@
 #include <polatory/isosurface/sign.hpp>
 #include <polatory/isosurface/types.hpp>
 #include <polatory/types.hpp>
+#include <stdexcept>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -31,39 +39,110 @@ class Lattice : public PrimitiveLattice {
 
   static constexpr double kVertexPositionMinimumOffset = 1e-4;
 
+  // In slab-by-slab generation, clustered vertices are indexed from this value
+  // so that they can be told apart from the unclustered ones.
+  static constexpr Index kClusteredVertexIndexBase = Index{1} << 62;
+
+  // The minimum number of lattice points evaluated at once, unless the lattice is smaller.
+  static constexpr Index kSlabBatchSize = Index{1} << 20;
+
  public:
   Lattice(const geometry::Bbox3& bbox, double resolution, const Mat3& aniso)
-      : Base(bbox, resolution, aniso) {}
+      : Base(bbox, resolution, aniso) {
+    // The lattice coordinates of the nodes and their neighbors must fit in the keys of NodeList.
+    auto corners = second_extended_bbox().corners();
+    for (auto v : corners.rowwise()) {
+      auto lc = lattice_coordinates_unrounded(v);
+      if (!((lc.array() - 1.0 >= NodeList::kMinCoordinate).all() &&
+            (lc.array() + 1.0 <= NodeList::kMaxCoordinate).all())) {
+        throw std::runtime_error("the lattice is too large for the bbox and the resolution");
+      }
+    }
+  }
 
   // Add all nodes within the second extended bbox.
   void add_all_nodes(const FieldFunction& field_fn, double isovalue) {
-    value_at_arbitrary_point_.emplace(bbox().center(), *this);
+    add_all_nodes_impl(
+        [&](const geometry::GridPoints3& grid) -> VecX { return field_fn.evaluate_grid(grid); },
+        isovalue);
+  }
 
-    std::vector<LatticeCoordinates> nodes;
-    std::vector<LatticeCoordinates> new_nodes;
+  // Same as add_all_nodes, but the field values at the lattice points are taken from node_values.
+  // If node_values is empty, the field is evaluated and the values are stored in it,
+  // so that the lattice can be built for another isovalue without evaluating the field again.
+  void add_all_nodes(const FieldFunction& field_fn, double isovalue,
+                     std::vector<double>& node_values) {
+    auto reuse_values = !node_values.empty();
+    std::size_t offset = 0;
+
+    add_all_nodes_impl(
+        [&](const geometry::GridPoints3& grid) -> VecX {
+          auto n = static_cast<std::size_t>(grid.rows());
+          if (!reuse_values) {
+            VecX values = field_fn.evaluate_grid(grid);
+            node_values.insert(node_values.end(), values.begin(), values.end());
+          }
 
-    auto [lc2_min, lc2_max] = third_lattice_coordinate_range();
-    for (auto lc2 = lc2_min; lc2 <= lc2_max; lc2++) {
-      auto [lc1_min, lc1_max] = second_lattice_coordinate_range(lc2);
-      for (auto lc1 = lc1_min; lc1 <= lc1_max; lc1++) {
-        auto [lc0_min, lc0_max] = first_lattice_coordinate_range(lc1, lc2);
-        for (auto lc0 = lc0_min; lc0 <= lc0_max; lc0++) {
-          LatticeCoordinates lc(lc0, lc1, lc2);
-          if (add_node_unchecked(lc)) {
-            new_nodes.push_back(lc);
+          if (offset + n > node_values.size()) {
+            throw std::invalid_argument("node_values does not match the lattice");
           }
-        }
+
+          VecX values = Eigen::Map<const VecX>(node_values.data() + offset, static_cast<Index>(n));
+          offset += n;
+          return values;
+        },
+        isovalue);
+
+    if (offset != node_values.size()) {
+      throw std::invalid_argument("node_values does not match the lattice");
+    }
+  }
+
+  // Same as add_all_nodes followed by refine_vertices, cluster_vertices and get_mesh,
+  // but the lattice is processed slab by slab along the third lattice coordinate.
+  // Once the faces in a slab are finalized, they are passed to mesh_fn as a Mesh along with
+  // the indices of its vertices in the lattice, and the nodes and the vertices that are
+  // no longer needed are released, so that the memory usage is bounded by a few slabs.
+  // A vertex shared between meshes has the same index and exactly the same position in all of them.
+  // Once a vertex is released (see is_vertex_released), it does not appear in later meshes.
+  template <class MeshFn>
+  void generate_mesh_slab_by_slab(const FieldFunction& field_fn, double isovalue,
+                                  int num_refine_passes, MeshFn mesh_fn) {
+    value_at_arbitrary_point_.emplace(bbox().center(), *this);
+
+    std::deque<Slab> slabs;
+    FrozenFaces frozen;
+
+    auto evaluate = [&](const geometry::GridPoints3& grid) -> VecX {
+      return field_fn.evaluate_grid(grid);
+    };
+    for_each_slab_values(evaluate, [&](int lc2, const VecX& values, Index& values_offset) {
+      auto& slab = slabs.emplace_back();
+      slab.lc2 = lc2;
+
+      add_slab_nodes(lc2, values, values_offset, isovalue, slab.nodes);
+      auto vertices_begin = vertex_offset_ + static_cast<Index>(vertices_.size());
+      generate_vertices(slab.nodes);
+      refine_vertices(field_fn, isovalue, num_refine_passes, vertices_begin);
+
+      // All edges of the nodes in the previous slab are known now.
+      if (slabs.size() >= 2) {
+        finalize_slab(slabs.at(slabs.size() - 2));
       }
 
-      evaluate_field(field_fn, isovalue);
-      generate_vertices(new_nodes);
-      remove_free_nodes(nodes);
-      if (lc2 == lc2_max) {
-        remove_free_nodes(new_nodes);
+      if (slabs.size() >= 4) {
+        flush_slab(slabs, frozen, mesh_fn);
+        slabs.pop_front();
       }
+    });
 
-      nodes.swap(new_nodes);
-      new_nodes.clear();
+    if (!slabs.empty()) {
+      finalize_slab(slabs.back());
+    }
+
+    while (!slabs.empty()) {
+      flush_slab(slabs, frozen, mesh_fn);
+      slabs.pop_front();
     }
   }
 
@@ -76,13 +155,14 @@ class Lattice : public PrimitiveLattice {
                                       *this);
 
     std::vector<Seed> seeds;
+    KnnNodesBuffers buffers;
 
     for (auto seed_point : seed_points.rowwise()) {
       geometry::Point3 clamped = seed_point.array().max(min.array()).min(max.array());
 
       auto lc = lattice_coordinates_rounded(clamped);
       add_node(lc);
-      for (const auto& nlc : knn_nodes(lc, 1)) {
+      for (const auto& nlc : knn_nodes(lc, 1, buffers)) {
         add_node(nlc);
       }
       seeds.emplace_back(lc, geometry::Vector3::Zero(), 1);
@@ -98,89 +178,51 @@ class Lattice : public PrimitiveLattice {
 
     std::vector<LatticeCoordinatesPair> pairs;
 
+    // The seeds are advanced front by front. The seeds in a front are tracked in parallel,
+    // along with the search for the nodes around the next seeds, and only the insertion
+    // of the nodes is serial. The nodes added by a front are evaluated at once.
     std::vector<Seed> new_seeds;
-    std::vector<LatticeCoordinates> nlcs;
     while (!seeds.empty()) {
-      for (const auto& seed : seeds) {
-        const auto& lc = seed.lc;
-        const auto& corrector = seed.corrector;
-        auto k = seed.k;
-        const auto& n = node_list_.at(lc);
-
-        nlcs.clear();
-        auto found_intersection = false;
-        auto reached_minimum = true;
-        for (const auto& nlc : knn_nodes(lc, k)) {
-          auto boundary_node = is_boundary_node(nlc);
-
-          const auto& nn = node_list_.at(nlc);
-          if (k == 1 && nn.value_sign() != n.value_sign()) {
-            // The following usage of the if statement maximizes the chances of successful
-            // surface tracking.
-            pairs.push_back(make_lattice_coordinates_pair(lc, nlc));
-            if (!boundary_node) {
-              found_intersection = true;
-              break;
-            }
-          }
-
-          if (std::abs(nn.value()) < std::abs(n.value())) {
-            // The gradient cannot be computed at a boundary node.
-            if (!boundary_node) {
-              nlcs.push_back(nlc);
-            }
-            reached_minimum = false;
+      auto n_seeds = seeds.size();
+      std::vector<EdgeBitset> pair_edge_sets(n_seeds);
+      std::vector<Seed> next_seeds(n_seeds);
+      std::vector<std::vector<LatticeCoordinates>> next_nodes(n_seeds);
+
+#pragma omp parallel
+      {
+        KnnNodesBuffers thread_buffers;
+        std::vector<LatticeCoordinates> nlcs;
+
+#pragma omp for schedule(guided)
+        for (std::size_t i = 0; i < n_seeds; i++) {
+          std::tie(pair_edge_sets.at(i), next_seeds.at(i)) =
+              track_seed(seeds.at(i), thread_buffers, nlcs);
+
+          const auto& next_seed = next_seeds.at(i);
+          if (next_seed.k != 0) {
+            next_nodes.at(i) = knn_nodes(next_seed.lc, next_seed.k, thread_buffers);
           }
         }
+      }
 
-        if (found_intersection) {
-          continue;
+      for (std::size_t i = 0; i < n_seeds; i++) {
+        const auto& lc = seeds.at(i).lc;
+        auto edge_set = pair_edge_sets.at(i);
+        while (edge_set != 0) {
+          auto ei = static_cast<EdgeIndex>(bit_pop(&edge_set));
+          pairs.push_back(make_lattice_coordinates_pair(lc, neighbor(lc, ei)));
         }
 
+        const auto& next_seed = next_seeds.at(i);
+        const auto& nlcs = next_nodes.at(i);
         if (nlcs.empty()) {
-          if (k >= 10 || reached_minimum) {
-            // Give up.
-            continue;
-          }
-          auto nnlcs = knn_nodes(lc, k + 1);
-          if (nnlcs.empty()) {
-            // No more nodes in the second extended bbox.
-            continue;
-          }
-          for (const auto& nnlc : nnlcs) {
-            add_node(nnlc);
-          }
-          new_seeds.emplace_back(lc, corrector, k + 1);
+          // The tracking ends, or there are no more nodes in the second extended bbox.
           continue;
         }
-
-        geometry::Vector3 neg_grad = -gradient(lc).normalized();
-
-        auto nlc_it = std::min_element(
-            nlcs.begin(), nlcs.end(),
-            [this, &n, &neg_grad, &corrector](const auto& lca, const auto& lcb) {
-              const auto& na = node_list_.at(lca);
-              const auto& nb = node_list_.at(lcb);
-              const auto& p = n.position();
-              const auto& pa = na.position();
-              const auto& pb = nb.position();
-              geometry::Vector3 va = pa - p;
-              geometry::Vector3 vb = pb - p;
-              geometry::Vector3 corrector_a = corrector + va - va.dot(neg_grad) * neg_grad;
-              geometry::Vector3 corrector_b = corrector + vb - vb.dot(neg_grad) * neg_grad;
-              return corrector_a.norm() < corrector_b.norm();
-            });
-
-        {
-          const auto& nlc = *nlc_it;
-          for (const auto& nnlc : knn_nodes(nlc, 1)) {
-            add_node(nnlc);
-          }
-
-          const auto& nn = node_list_.at(nlc);
-          geometry::Vector3 v = nn.position() - n.position();
-          new_seeds.emplace_back(nlc, corrector + v - v.dot(neg_grad) * neg_grad, 1);
+        for (const auto& nlc : nlcs) {
+          add_node(nlc);
         }
+        new_seeds.push_back(next_seed);
       }
 
       std::swap(seeds, new_seeds);
@@ -191,37 +233,28 @@ class Lattice : public PrimitiveLattice {
 
     std::unordered_set<LatticeCoordinatesPair, LatticeCoordinatesPairHash> visited_pairs;
     std::vector<LatticeCoordinatesPair> new_pairs;
-    std::vector<LatticeCoordinates> neighbors0;
-    std::vector<LatticeCoordinates> neighbors1;
     std::vector<LatticeCoordinates> common_neighbors;
     while (!pairs.empty()) {
-      for (const auto& pair : pairs) {
-        if (visited_pairs.contains(pair)) {
-          continue;
-        }
-        visited_pairs.insert(pair);
+      std::erase_if(pairs, [&](const auto& pair) { return !visited_pairs.insert(pair).second; });
 
-        const auto& [lc0, lc1] = pair;
-        const auto& n0 = node_list_.at(lc0);
-        const auto& n1 = node_list_.at(lc1);
-        if (n0.value_sign() == n1.value_sign()) {
-          continue;
-        }
+      auto n_pairs = pairs.size();
+      std::vector<EdgeBitset> common_edge_sets(n_pairs);
+
+#pragma omp parallel for schedule(guided)
+      for (std::size_t i = 0; i < n_pairs; i++) {
+        common_edge_sets.at(i) = common_neighbor_edges(pairs.at(i));
+      }
+
+      for (std::size_t i = 0; i < n_pairs; i++) {
+        const auto& [lc0, lc1] = pairs.at(i);
 
-        neighbors0.clear();
-        neighbors1.clear();
         common_neighbors.clear();
-        for (const auto& nlc : knn_nodes(lc0, 1)) {
-          neighbors0.push_back(nlc);
-        }
-        for (const auto& nlc : knn_nodes(lc1, 1)) {
-          neighbors1.push_back(nlc);
+        auto edge_set = common_edge_sets.at(i);
+        while (edge_set != 0) {
+          auto ei = static_cast<EdgeIndex>(bit_pop(&edge_set));
+          common_neighbors.push_back(neighbor(lc0, ei));
         }
-        std::sort(neighbors0.begin(), neighbors0.end(), LatticeCoordinatesLess());
-        std::sort(neighbors1.begin(), neighbors1.end(), LatticeCoordinatesLess());
-        std::set_intersection(neighbors0.begin(), neighbors0.end(), neighbors1.begin(),
-                              neighbors1.end(), std::back_inserter(common_neighbors),
-                              LatticeCoordinatesLess());
+        std::sort(common_neighbors.begin(), common_neighbors.end(), LatticeCoordinatesLess());
 
         for (const auto& nlc : common_neighbors) {
           add_node(nlc);
@@ -247,12 +280,260 @@ class Lattice : public PrimitiveLattice {
     remove_free_nodes(all_nodes);
   }
 
+  // Adds the nodes around the surface in a coarse-to-fine manner.
+  // The field is first evaluated at the nodes of the sublattice with spacing 2^num_levels.
+  // Then only the cells that may contain the surface are subdivided, down to the cells
+  // of the lattice. Whether a cell may contain the surface is decided from the values
+  // at its corners and a Lipschitz constant of the field estimated from the differences
+  // of the values, multiplied by lipschitz_safety_factor. The neighbors of a cell that has
+  // corners of both signs are also subdivided. As long as the estimate holds, the resulting nodes
+  // produce the same mesh as add_all_nodes, with far fewer field evaluations. Since the estimate
+  // is taken from the values at the nodes, a component of the surface that fits in a cell
+  // without changing the signs of the values around it can be missed, if the field varies
+  // much faster inside the cell than between the nodes.
+  void add_nodes_adaptively(const FieldFunction& field_fn, double isovalue, int num_levels,
+                            double lipschitz_safety_factor) {
+    value_at_arbitrary_point_.emplace(bbox().center(), *this);
+
+    // The values at the evaluated nodes, or NaN for the nodes outside the second extended bbox.
+    std::unordered_map<LatticeCoordinates, double, LatticeCoordinatesHash> values;
+    std::vector<LatticeCoordinates> lcs_to_evaluate;
+
+    auto request_value = [&](const LatticeCoordinates& lc) {
+      auto [it, inserted] = values.emplace(lc, std::numeric_limits<double>::quiet_NaN());
+      if (inserted && second_extended_bbox().contains(position(lc))) {
+        lcs_to_evaluate.push_back(lc);
+      }
+    };
+
+    auto evaluate_requested_values = [&] {
+      if (lcs_to_evaluate.empty()) {
+        return;
+      }
+
+      geometry::Points3 points(static_cast<Index>(lcs_to_evaluate.size()), 3);
+      for (std::size_t i = 0; i < lcs_to_evaluate.size(); i++) {
+        points.row(static_cast<Index>(i)) = position(lcs_to_evaluate.at(i));
+      }
+
+      VecX vs = field_fn(points).array() - isovalue;
+      for (std::size_t i = 0; i < lcs_to_evaluate.size(); i++) {
+        values.at(lcs_to_evaluate.at(i)) = vs(static_cast<Index>(i));
+      }
+
+      lcs_to_evaluate.clear();
+    };
+
+    auto corner = [](const LatticeCoordinates& cell, int size, int i) -> LatticeCoordinates {
+      return cell + size * LatticeCoordinates(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+    };
+
+    // The diameter of the cell of size 1.
+    auto unit_diameter = 0.0;
+    for (auto i = 0; i < 4; i++) {
+      LatticeCoordinates d(1, (i & 1) != 0 ? 1 : -1, (i & 2) != 0 ? 1 : -1);
+      unit_diameter = std::max(unit_diameter, (position(d) - position({0, 0, 0})).norm());
+    }
+
+    auto lipschitz = 0.0;
+
+    // The values at the corners of a cell.
+    using CornerValues = std::array<double, 8>;
+
+    auto has_sign_change = [](const CornerValues& cvs) {
+      auto has_pos = false;
+      auto has_neg = false;
+      for (auto value : cvs) {
+        if (std::isnan(value)) {
+          continue;
+        }
+        if (sign(value) == BinarySign::kPos) {
+          has_pos = true;
+        } else {
+          has_neg = true;
+        }
+      }
+      return has_pos && has_neg;
+    };
+
+    auto may_contain_surface = [&](const LatticeCoordinates& cell, int size,
+                                   const CornerValues& cvs) {
+      if (std::all_of(cvs.begin(), cvs.end(), [](auto value) { return std::isnan(value); })) {
+        // All corners are outside the second extended bbox, but the cell may not be.
+        geometry::Points3 corners(8, 3);
+        for (auto i = 0; i < 8; i++) {
+          corners.row(i) = position(corner(cell, size, i));
+        }
+        auto cell_bbox = geometry::Bbox3::from_points(corners);
+        const auto& ext_bbox = second_extended_bbox();
+        return (cell_bbox.min().array() <= ext_bbox.max().array()).all() &&
+               (cell_bbox.max().array() >= ext_bbox.min().array()).all();
+      }
+
+      if (has_sign_change(cvs)) {
+        return true;
+      }
+
+      // If the surface passes through the cell, the absolute value at every corner
+      // is bounded by the Lipschitz constant times the diameter of the cell.
+      auto max_abs_value = 0.0;
+      for (auto value : cvs) {
+        if (!std::isnan(value)) {
+          max_abs_value = std::max(max_abs_value, std::abs(value));
+        }
+      }
+      return max_abs_value <= lipschitz_safety_factor * lipschitz * size * unit_diameter;
+    };
+
+    // Cover the second extended bbox with the coarsest cells.
+    auto size = 1 << num_levels;
+    auto floor_to_size = [&size](int x) {
+      return x >= 0 ? x / size * size : -((size - 1 - x) / size) * size;
+    };
+
+    // The lattice coordinates of the corners of the second extended bbox bound those of the nodes.
+    LatticeCoordinates lc_min = LatticeCoordinates::Constant(std::numeric_limits<int>::max());
+    LatticeCoordinates lc_max = LatticeCoordinates::Constant(std::numeric_limits<int>::min());
+    auto ext_corners = second_extended_bbox().corners();
+    for (auto v : ext_corners.rowwise()) {
+      geometry::Vector3 lcd = lattice_coordinates_unrounded(v);
+      lc_min = lc_min.cwiseMin(LatticeCoordinates(lcd.array().floor().cast<int>()));
+      lc_max = lc_max.cwiseMax(LatticeCoordinates(lcd.array().ceil().cast<int>()));
+    }
+
+    std::vector<LatticeCoordinates> cells;
+    for (auto lc2 = floor_to_size(lc_min(2)); lc2 <= lc_max(2); lc2 += size) {
+      for (auto lc1 = floor_to_size(lc_min(1)); lc1 <= lc_max(1); lc1 += size) {
+        for (auto lc0 = floor_to_size(lc_min(0)); lc0 <= lc_max(0); lc0 += size) {
+          cells.emplace_back(lc0, lc1, lc2);
+        }
+      }
+    }
+
+    std::vector<CornerValues> corner_values;
+    std::vector<LatticeCoordinates> selected_cells;
+    while (true) {
+      for (const auto& cell : cells) {
+        for (auto i = 0; i < 8; i++) {
+          request_value(corner(cell, size, i));
+        }
+      }
+      evaluate_requested_values();
+
+      corner_values.resize(cells.size());
+      for (std::size_t j = 0; j < cells.size(); j++) {
+        for (auto i = 0; i < 8; i++) {
+          corner_values.at(j).at(i) = values.at(corner(cells.at(j), size, i));
+        }
+      }
+
+      selected_cells.clear();
+
+      if (size == 1) {
+        // Faces are generated only in the cells that have corners of both signs.
+        for (std::size_t j = 0; j < cells.size(); j++) {
+          if (has_sign_change(corner_values.at(j))) {
+            selected_cells.push_back(cells.at(j));
+          }
+        }
+        break;
+      }
+
+      // Update the estimate with the differences along the edges of the cells.
+      std::array<double, 3> edge_lengths{};
+      for (auto axis = 0; axis < 3; axis++) {
+        edge_lengths.at(axis) =
+            (position(corner({0, 0, 0}, size, 1 << axis)) - position({0, 0, 0})).norm();
+      }
+      for (const auto& cvs : corner_values) {
+        for (auto i = 0; i < 8; i++) {
+          for (auto axis = 0; axis < 3; axis++) {
+            if ((i & (1 << axis)) != 0) {
+              continue;
+            }
+            auto slope = std::abs(cvs.at(i | (1 << axis)) - cvs.at(i)) / edge_lengths.at(axis);
+            if (!std::isnan(slope)) {
+              lipschitz = std::max(lipschitz, slope);
+            }
+          }
+        }
+      }
+
+      // Regardless of the estimate, the neighbors of the cells with sign changes are kept,
+      // as the surface passing through a cell often extends into its neighbors.
+      std::unordered_set<LatticeCoordinates, LatticeCoordinatesHash> sign_change_cells;
+      for (std::size_t j = 0; j < cells.size(); j++) {
+        if (has_sign_change(corner_values.at(j))) {
+          sign_change_cells.insert(cells.at(j));
+        }
+      }
+
+      auto has_sign_change_neighbor = [&](const LatticeCoordinates& cell) {
+        for (auto d0 = -1; d0 <= 1; d0++) {
+          for (auto d1 = -1; d1 <= 1; d1++) {
+            for (auto d2 = -1; d2 <= 1; d2++) {
+              if (sign_change_cells.contains(cell + size * LatticeCoordinates(d0, d1, d2))) {
+                return true;
+              }
+            }
+          }
+        }
+        return false;
+      };
+
+      for (std::size_t j = 0; j < cells.size(); j++) {
+        if (may_contain_surface(cells.at(j), size, corner_values.at(j)) ||
+            has_sign_change_neighbor(cells.at(j))) {
+          selected_cells.push_back(cells.at(j));
+        }
+      }
+
+      size /= 2;
+      cells.clear();
+      for (const auto& cell : selected_cells) {
+        for (auto i = 0; i < 8; i++) {
+          cells.push_back(corner(cell, size, i));
+        }
+      }
+    }
+
+    // Add the corners of the selected cells, which have been evaluated.
+    std::vector<LatticeCoordinates> all_nodes;
+    for (const auto& cell : selected_cells) {
+      for (auto i = 0; i < 8; i++) {
+        auto lc = corner(cell, 1, i);
+        auto value = values.at(lc);
+        if (std::isnan(value) || node_list_.contains(lc)) {
+          continue;
+        }
+        node_list_.emplace(lc, Node(position(lc))).first->second.set_value(value);
+        all_nodes.push_back(lc);
+      }
+    }
+
+    auto tet = tetrahedron(bbox().center());
+    for (auto lc : tet.rowwise()) {
+      request_value(lc);
+    }
+    evaluate_requested_values();
+    auto& arb_value = value_at_arbitrary_point_.value();
+    for (auto lc : tet.rowwise()) {
+      arb_value.tell(lc, values.at(lc));
+    }
+
+    std::sort(all_nodes.begin(), all_nodes.end(), LatticeCoordinatesLess());
+    generate_vertices(all_nodes);
+    remove_free_nodes(all_nodes);
+  }
+
   void clear() {
     node_list_.clear();
     nodes_to_evaluate_.clear();
     vertices_.clear();
+    vertex_offset_ = 0;
     cluster_map_.clear();
     clustered_vertices_.clear();
+    clustered_vertex_offset_ = 0;
     value_at_arbitrary_point_.reset();
   }
 
@@ -264,36 +545,24 @@ class Lattice : public PrimitiveLattice {
       vertices.at(i) = vertices_.at(i).position_clamped(node_list_);
     }
 
-    const auto& min = first_extended_bbox().min();
-    const auto& max = first_extended_bbox().max();
+    auto vertex_position = [&vertices](Index vi) -> const geometry::Point3& {
+      return vertices.at(vi);
+    };
+    auto vi_offset = static_cast<Index>(vertices.size());
 
     for (auto& lc_node : node_list_) {
-      auto& node = lc_node.second;
-      const auto& p = node.position();
-      if ((p.array() <= min.array() || p.array() >= max.array()).any()) {
-        // Do not cluster vertices of a node on/outside the bbox,
-        // as this can produce a boundary vertex inside the bbox.
-        continue;
-      }
-      node.cluster(vertices, cluster_map_, clustered_vertices_);
+      cluster_node(lc_node.second, vertex_position, vi_offset);
     }
   }
 
-  Mesh get_mesh() const {
-    std::vector<Face> faces_v;
-    auto inserter = std::back_inserter(faces_v);
-    for (const auto& lc_node : node_list_) {
-      const auto& lc = lc_node.first;
-      for (TetrahedronIterator it(lc, node_list_); it.is_valid(); ++it) {
-        it->get_faces(inserter);
-      }
-    }
-
-    Faces faces(static_cast<Index>(faces_v.size()), 3);
+  // Returns the faces with the clustered vertex indices, excluding the degenerate ones.
+  // unclustered_faces must be the result of get_unclustered_faces.
+  Faces cluster_faces(const std::vector<Face>& unclustered_faces) const {
+    Faces faces(static_cast<Index>(unclustered_faces.size()), 3);
     Index n_faces = 0;
 
     auto it = faces.rowwise().begin();
-    for (const auto& face : faces_v) {
+    for (const auto& face : unclustered_faces) {
       auto v0 = clustered_vertex_index(face(0));
       auto v1 = clustered_vertex_index(face(1));
       auto v2 = clustered_vertex_index(face(2));
@@ -309,58 +578,71 @@ class Lattice : public PrimitiveLattice {
 
     faces.conservativeResize(n_faces, 3);
 
-    return {get_vertices(), faces};
+    return faces;
   }
 
-  void refine_vertices(const FieldFunction& field_fn, double isovalue, int num_passes) {
-    if (num_passes <= 0) {
-      return;
-    }
+  Mesh get_mesh() const { return {get_vertices(), cluster_faces(get_unclustered_faces())}; }
 
-    auto n = static_cast<Index>(vertices_.size());
-    geometry::Points3 vertices(n, 3);
-
-    for (auto pass = 0; pass < num_passes; pass++) {
-      for (Index i = 0; i < n; i++) {
-        const auto& v = vertices_.at(i);
-        vertices.row(i) = v.position_unclamped(node_list_);
-      }
-
-      VecX vertex_values = field_fn(vertices).array() - isovalue;
+  // Returns whether the vertex passed to mesh_fn by generate_mesh_slab_by_slab has been released.
+  bool is_vertex_released(Index vi) const {
+    if (vi >= kClusteredVertexIndexBase) {
+      return vi - kClusteredVertexIndexBase < clustered_vertex_offset_;
+    }
+    return vi < vertex_offset_;
+  }
 
-      for (Index i = 0; i < n; i++) {
-        auto& v = vertices_.at(i);
-        v.v1 = vertex_values(i);
+  // Returns the faces with the vertex indices before clustering.
+  std::vector<Face> get_unclustered_faces() const {
+    std::vector<Face> faces;
+    auto inserter = std::back_inserter(faces);
+    for (const auto& lc_node : node_list_) {
+      const auto& lc = lc_node.first;
+      for (TetrahedronIterator it(lc, node_list_); it.is_valid(); ++it) {
+        it->get_faces(inserter);
       }
-
-      refine_vertices(vertices_);
     }
 
+    return faces;
+  }
+
+  // Returns the vertices, which are indexed in the same way as the faces returned by get_mesh.
+  geometry::Points3 get_vertices() const {
+    geometry::Points3 vertices(static_cast<Index>(vertices_.size() + clustered_vertices_.size()),
+                               3);
+    auto it = vertices.rowwise().begin();
     for (const auto& v : vertices_) {
-      if (v.t1 >= 0.5) {
-        auto& node0 = node_list_.at(v.node_lc);
-        auto& node1 = node_list_.at(neighbor(v.node_lc, v.ei));
-        node0.remove_vertex(v.ei);
-        node1.insert_vertex(v.vi, kOppositeEdge.at(v.ei));
-      }
+      *it++ = v.position_clamped(node_list_);
+    }
+    for (const auto& v : clustered_vertices_) {
+      *it++ = v;
     }
+
+    snap_vertices_to_bbox(vertices);
+
+    return vertices;
+  }
+
+  void refine_vertices(const FieldFunction& field_fn, double isovalue, int num_passes) {
+    refine_vertices(field_fn, isovalue, num_passes, vertex_offset_);
   }
 
-  Index uncluster_vertices(const std::unordered_set<Index>& vis) {
-    Index num_unclustered = 0;
+  // Unclusters the vertices that are clustered into any of vis.
+  // Returns the indices of the unclustered vertices.
+  std::vector<Index> uncluster_vertices(const std::unordered_set<Index>& vis) {
+    std::vector<Index> unclustered;
 
     auto it = cluster_map_.begin();
     while (it != cluster_map_.end()) {
       if (vis.contains(it->second)) {
         // Uncluster.
+        unclustered.push_back(it->first);
         it = cluster_map_.erase(it);
-        ++num_unclustered;
       } else {
         ++it;
       }
     }
 
-    return num_unclustered;
+    return unclustered;
   }
 
   BinarySign value_sign_at_arbitrary_point_within_bbox() const {
@@ -403,12 +685,36 @@ class Lattice : public PrimitiveLattice {
     std::array<bool, 4> populated_{false, false, false, false};
   };
 
+  // A node from which the surface is tracked. k is the distance to the nodes examined.
   struct Seed {
     LatticeCoordinates lc;
     geometry::Vector3 corrector;
     int k{};
   };
 
+  // Scratch buffers for knn_nodes.
+  struct KnnNodesBuffers {
+    std::vector<LatticeCoordinates> frontier;
+    std::vector<LatticeCoordinates> sorted_frontier;
+    std::vector<LatticeCoordinates> sorted_prev_frontier;
+    std::vector<LatticeCoordinates> candidates;
+    std::vector<Index> order;
+  };
+
+  // The nodes with the same third lattice coordinate.
+  struct Slab {
+    int lc2{};
+    std::vector<LatticeCoordinates> nodes;
+    // The index of the first vertex clustered at the nodes.
+    Index clustered_vertices_begin{};
+  };
+
+  // The faces passed to mesh_fn most recently, with the positions of their vertices.
+  struct FrozenFaces {
+    std::vector<Face> faces;
+    std::unordered_map<Index, geometry::Point3> positions;
+  };
+
   struct Vertex {
     LatticeCoordinates node_lc;
     EdgeIndex ei{};
@@ -437,8 +743,86 @@ class Lattice : public PrimitiveLattice {
       auto t = t1;
       return p0 + t * (p1 - p0);
     }
+
+    // The smaller third lattice coordinate of the nodes on the edge.
+    // Only the tetrahedra of the nodes in the slab or the previous one contain the edge.
+    int min_lc2() const { return std::min(node_lc(2), neighbor(node_lc, ei)(2)); }
   };
 
+  // evaluate(grid) returns the field values at the lattice points in grid.
+  template <class Evaluate>
+  void add_all_nodes_impl(Evaluate evaluate, double isovalue) {
+    value_at_arbitrary_point_.emplace(bbox().center(), *this);
+
+    std::vector<LatticeCoordinates> nodes;
+    std::vector<LatticeCoordinates> new_nodes;
+
+    auto lc2_max = third_lattice_coordinate_range().second;
+    for_each_slab_values(evaluate, [&](int lc2, const VecX& values, Index& values_offset) {
+      add_slab_nodes(lc2, values, values_offset, isovalue, new_nodes);
+      generate_vertices(new_nodes);
+      remove_free_nodes(nodes);
+      if (lc2 == lc2_max) {
+        remove_free_nodes(new_nodes);
+      }
+
+      nodes.swap(new_nodes);
+      new_nodes.clear();
+    });
+  }
+
+  // Calls slab_fn(lc2, values, values_offset) for each slab in ascending order of lc2,
+  // where the field values at grid_points(lc2, lc2 + 1) are in values, starting at values_offset.
+  // The field is evaluated by evaluate(grid) on batches of slabs with at least kSlabBatchSize
+  // lattice points, which amortizes the setup cost of each evaluation while keeping
+  // the memory usage bounded by a batch.
+  template <class Evaluate, class SlabFn>
+  void for_each_slab_values(Evaluate evaluate, SlabFn slab_fn) const {
+    VecX values;
+    Index values_offset{};
+    auto batch_end = std::numeric_limits<int>::min();
+
+    auto [lc2_min, lc2_max] = third_lattice_coordinate_range();
+    for (auto lc2 = lc2_min; lc2 <= lc2_max; lc2++) {
+      if (lc2 >= batch_end) {
+        Index n_points{};
+        batch_end = lc2;
+        while (n_points < kSlabBatchSize && batch_end <= lc2_max) {
+          n_points += grid_points(batch_end, batch_end + 1).rows();
+          batch_end++;
+        }
+        values = evaluate(grid_points(lc2, batch_end));
+        values_offset = 0;
+      }
+
+      slab_fn(lc2, values, values_offset);
+    }
+  }
+
+  // Adds the nodes in the slab lc2 to the lattice and to added_nodes.
+  // The field values at the lattice points in grid_points(lc2, lc2 + 1) are taken from values,
+  // starting at values_offset, which is advanced past the slab.
+  void add_slab_nodes(int lc2, const VecX& values, Index& values_offset, double isovalue,
+                      std::vector<LatticeCoordinates>& added_nodes) {
+    std::vector<double> node_values;
+
+    auto [lc1_min, lc1_max] = second_lattice_coordinate_range(lc2);
+    for (auto lc1 = lc1_min; lc1 <= lc1_max; lc1++) {
+      auto [lc0_min, lc0_max] = first_lattice_coordinate_range(lc1, lc2);
+      for (auto lc0 = lc0_min; lc0 <= lc0_max; lc0++) {
+        LatticeCoordinates lc(lc0, lc1, lc2);
+        auto value = values(values_offset++);
+        if (add_node_unchecked(lc)) {
+          added_nodes.push_back(lc);
+          node_values.push_back(value - isovalue);
+        }
+      }
+    }
+
+    set_node_values(
+        Eigen::Map<const VecX>(node_values.data(), static_cast<Index>(node_values.size())));
+  }
+
   // Returns true if the node is added.
   bool add_node(const LatticeCoordinates& lc) {
     if (node_list_.contains(lc)) {
@@ -484,12 +868,244 @@ class Lattice : public PrimitiveLattice {
     return cluster_map_.contains(vi) ? cluster_map_.at(vi) : vi;
   }
 
+  template <class VertexPosition>
+  void cluster_node(Node& node, VertexPosition vertex_position, Index vi_offset) {
+    const auto& min = first_extended_bbox().min();
+    const auto& max = first_extended_bbox().max();
+
+    const auto& p = node.position();
+    if ((p.array() <= min.array() || p.array() >= max.array()).any()) {
+      // Do not cluster vertices of a node on/outside the bbox,
+      // as this can produce a boundary vertex inside the bbox.
+      return;
+    }
+    node.cluster(vertex_position, vi_offset, cluster_map_, clustered_vertices_);
+  }
+
+  // Removes the free nodes in the slab and clusters the vertices of the remaining ones.
+  // All nodes in the next slab must have been added.
+  void finalize_slab(Slab& slab) {
+    remove_free_nodes(slab.nodes);
+
+    auto vertex_position = [this](Index vi) {
+      return vertices_.at(vi - vertex_offset_).position_clamped(node_list_);
+    };
+    auto vi_offset = kClusteredVertexIndexBase + clustered_vertex_offset_;
+
+    slab.clustered_vertices_begin = vi_offset + static_cast<Index>(clustered_vertices_.size());
+    for (const auto& lc : slab.nodes) {
+      cluster_node(node_list_.at(lc), vertex_position, vi_offset);
+    }
+  }
+
+  // Passes the faces in the first slab to mesh_fn and releases the slab.
+  // Before that, defects are looked for around the vertices of the faces in the first two slabs,
+  // and the vertices clustered at the nodes in the second and the third slabs are unclustered
+  // as needed. The vertices clustered at the nodes in the first slab are shared with
+  // the faces passed to mesh_fn last time (the frozen faces), so they are not unclustered.
+  template <class MeshFn>
+  void flush_slab(const std::deque<Slab>& slabs, FrozenFaces& frozen, MeshFn& mesh_fn) {
+    const auto& slab = slabs.front();
+    const auto* center_slab = slabs.size() >= 2 ? &slabs.at(1) : nullptr;
+    const auto* next_slab = slabs.size() >= 3 ? &slabs.at(2) : nullptr;
+    auto unclusterable_begin = center_slab != nullptr ? center_slab->clustered_vertices_begin
+                                                      : std::numeric_limits<Index>::max();
+
+    std::vector<Face> faces;
+    std::vector<Face> center_faces;
+    std::vector<Face> next_faces;
+    std::unordered_map<Index, Index> rows;
+    std::vector<Index> vis;
+    geometry::Points3 window_vertices;
+    Faces window_faces;
+    Index n_slab_vertices{};
+
+    // Unclustering non-manifold vertices may require a few iterations.
+    while (true) {
+      faces = get_faces(slab.nodes);
+      center_faces = center_slab != nullptr ? get_faces(center_slab->nodes) : std::vector<Face>{};
+      next_faces = next_slab != nullptr ? get_faces(next_slab->nodes) : std::vector<Face>{};
+
+      // The window consists of the faces in the three slabs and the frozen faces.
+      // The vertices of the faces in the first two slabs come first in this order.
+      // The fans of them are complete within the window.
+      rows.clear();
+      vis.clear();
+      auto n_window_faces = static_cast<Index>(faces.size() + center_faces.size() +
+                                               frozen.faces.size() + next_faces.size());
+      window_faces.resize(n_window_faces, 3);
+      auto it = window_faces.rowwise().begin();
+      Index n_checked_vertices{};
+      for (const auto* fs : {&faces, &center_faces, &frozen.faces, &next_faces}) {
+        for (const auto& f : *fs) {
+          auto row = *it++;
+          for (auto i = 0; i < 3; i++) {
+            auto [row_it, inserted] = rows.emplace(f(i), static_cast<Index>(vis.size()));
+            if (inserted) {
+              vis.push_back(f(i));
+            }
+            row(i) = row_it->second;
+          }
+        }
+        if (fs == &faces) {
+          n_slab_vertices = static_cast<Index>(vis.size());
+        } else if (fs == &center_faces) {
+          n_checked_vertices = static_cast<Index>(vis.size());
+        }
+      }
+
+      window_vertices.resize(static_cast<Index>(vis.size()), 3);
+      for (std::size_t i = 0; i < vis.size(); i++) {
+        window_vertices.row(static_cast<Index>(i)) = streamed_vertex_position(vis.at(i), frozen);
+      }
+      snap_vertices_to_bbox(window_vertices);
+
+      if (center_slab == nullptr) {
+        // No vertices can be unclustered.
+        break;
+      }
+
+      Mesh window(window_vertices, window_faces);
+      MeshDefectsFinder defects(window);
+
+      std::unordered_set<Index> vertices_to_uncluster;
+      auto try_uncluster = [&](Index row) {
+        auto vi = vis.at(row);
+        if (vi >= unclusterable_begin) {
+          vertices_to_uncluster.insert(vi);
+        }
+      };
+      for (auto row : defects.singular_vertices()) {
+        if (row >= n_checked_vertices) {
+          continue;
+        }
+        if (vis.at(row) >= unclusterable_begin) {
+          try_uncluster(row);
+          continue;
+        }
+        // The vertex cannot be unclustered; try the vertices around it instead.
+        for (auto f : window_faces.rowwise()) {
+          if ((f.array() == row).any()) {
+            try_uncluster(f(0));
+            try_uncluster(f(1));
+            try_uncluster(f(2));
+          }
+        }
+      }
+      for (auto fi : defects.intersecting_faces()) {
+        auto f = window_faces.row(fi);
+        try_uncluster(f(0));
+        try_uncluster(f(1));
+        try_uncluster(f(2));
+      }
+
+      if (uncluster_vertices(vertices_to_uncluster).empty()) {
+        break;
+      }
+    }
+
+    auto n_faces = static_cast<Index>(faces.size());
+    mesh_fn(Mesh(window_vertices.topRows(n_slab_vertices), window_faces.topRows(n_faces)),
+            std::vector<Index>(vis.begin(), vis.begin() + n_slab_vertices));
+
+    frozen.faces = std::move(faces);
+    frozen.positions.clear();
+    for (Index row = 0; row < n_slab_vertices; row++) {
+      frozen.positions.emplace(vis.at(row), window_vertices.row(row));
+    }
+
+    release_slab(slab, center_slab);
+  }
+
+  // Releases the nodes in the slab and the vertices that are no longer needed.
+  void release_slab(const Slab& slab, const Slab* next_slab) {
+    for (const auto& lc : slab.nodes) {
+      node_list_.erase(lc);
+    }
+
+    while (!vertices_.empty() && vertices_.front().min_lc2() <= slab.lc2) {
+      cluster_map_.erase(vertex_offset_);
+      vertices_.pop_front();
+      vertex_offset_++;
+    }
+
+    auto clustered_vertices_end =
+        next_slab != nullptr ? next_slab->clustered_vertices_begin
+                             : kClusteredVertexIndexBase + clustered_vertex_offset_ +
+                                   static_cast<Index>(clustered_vertices_.size());
+    while (kClusteredVertexIndexBase + clustered_vertex_offset_ < clustered_vertices_end) {
+      clustered_vertices_.pop_front();
+      clustered_vertex_offset_++;
+    }
+  }
+
+  // Returns the non-degenerate faces in the tetrahedra of the nodes, with clustered indices.
+  std::vector<Face> get_faces(const std::vector<LatticeCoordinates>& node_lcs) const {
+    std::vector<Face> faces;
+    auto inserter = std::back_inserter(faces);
+    for (const auto& lc : node_lcs) {
+      for (TetrahedronIterator it(lc, node_list_); it.is_valid(); ++it) {
+        it->get_faces(inserter);
+      }
+    }
+
+    std::size_t n_faces = 0;
+    for (const auto& face : faces) {
+      auto v0 = clustered_vertex_index(face(0));
+      auto v1 = clustered_vertex_index(face(1));
+      auto v2 = clustered_vertex_index(face(2));
+
+      if (v0 == v1 || v1 == v2 || v2 == v0) {
+        // Degenerate face (due to vertex clustering).
+        continue;
+      }
+
+      faces.at(n_faces++) << v0, v1, v2;
+    }
+    faces.resize(n_faces);
+
+    return faces;
+  }
+
+  geometry::Point3 streamed_vertex_position(Index vi, const FrozenFaces& frozen) const {
+    // The vertex may have been released.
+    auto it = frozen.positions.find(vi);
+    if (it != frozen.positions.end()) {
+      return it->second;
+    }
+
+    if (vi >= kClusteredVertexIndexBase) {
+      return clustered_vertices_.at(vi - kClusteredVertexIndexBase - clustered_vertex_offset_);
+    }
+
+    return vertices_.at(vi - vertex_offset_).position_clamped(node_list_);
+  }
+
+  // Returns the index of the edge from lc to its neighbor nlc.
+  static EdgeIndex edge_index(const LatticeCoordinates& lc, const LatticeCoordinates& nlc) {
+    const auto& deltas = kNeighborLatticeCoordinatesDeltas;
+    LatticeCoordinates delta = nlc - lc;
+    auto it = std::find(deltas.begin(), deltas.end(), delta);
+    POLATORY_ASSERT(it != deltas.end());
+    return static_cast<EdgeIndex>(std::distance(deltas.begin(), it));
+  }
+
   // Evaluates field values for each node in nodes_to_evaluate_.
   void evaluate_field(const FieldFunction& field_fn, double isovalue) {
     if (nodes_to_evaluate_.empty()) {
       return;
     }
 
+    VecX values = evaluate_field_at_nodes(field_fn).array() - isovalue;
+    set_node_values(values);
+  }
+
+  // Returns the field values at the nodes in nodes_to_evaluate_.
+  VecX evaluate_field_at_nodes(const FieldFunction& field_fn) const {
+    if (nodes_to_evaluate_.empty()) {
+      return {};
+    }
+
     geometry::Points3 points(nodes_to_evaluate_.size(), 3);
 
     auto point_it = points.rowwise().begin();
@@ -497,7 +1113,11 @@ class Lattice : public PrimitiveLattice {
       *point_it++ = node_list_.at(lc).position();
     }
 
-    VecX values = field_fn(points).array() - isovalue;
+    return field_fn(points);
+  }
+
+  // Sets the values relative to the isovalue to the nodes in nodes_to_evaluate_.
+  void set_node_values(const VecX& values) {
     auto& arb_value = value_at_arbitrary_point_.value();
 
     Index i{};
@@ -511,75 +1131,115 @@ class Lattice : public PrimitiveLattice {
     nodes_to_evaluate_.clear();
   }
 
+  // Generates vertices on the edges from each node to its neighbors that are less than it.
+  // The vertices are indexed in the order of the nodes and then the edges,
+  // so the result does not depend on the number of threads.
   void generate_vertices(const std::vector<LatticeCoordinates>& node_lcs) {
+    auto n_nodes = node_lcs.size();
+
+    // The edges of each node on which vertices are generated.
+    std::vector<EdgeBitset> edge_sets(n_nodes);
+
 #pragma omp parallel for schedule(guided)
-    // NOLINTNEXTLINE(modernize-loop-convert)
-    for (std::size_t i = 0; i < node_lcs.size(); i++) {
+    for (std::size_t i = 0; i < n_nodes; i++) {
       const auto& lc0 = node_lcs.at(i);
-      auto& node0 = node_list_.at(lc0);
-      auto v0 = node0.value();
-      auto sign_v0 = node0.value_sign();
+      auto sign_v0 = node_list_.at(lc0).value_sign();
 
+      EdgeBitset edge_set{};
       for (EdgeIndex ei = 0; ei < 14; ei++) {
         auto lc1 = neighbor(lc0, ei);
         if (!LatticeCoordinatesLess()(lc1, lc0)) {
           continue;
         }
 
-        auto* node1_ptr = node_list_.node_ptr(lc1);
+        const auto* node1_ptr = node_list_.node_ptr(lc1);
         if (node1_ptr == nullptr) {
           // There is no neighbor node on the opposite end of the edge.
           continue;
         }
 
-        auto& node1 = *node1_ptr;
-        auto v1 = node1.value();
-        auto sign_v1 = node1.value_sign();
-
-        if (sign_v0 == sign_v1) {
+        if (node1_ptr->value_sign() == sign_v0) {
           // There is no intersection on the edge.
           continue;
         }
 
-        auto t = v0 / (v0 - v1);
+        edge_set |= 1 << ei;
+      }
+      edge_sets.at(i) = edge_set;
+    }
 
-#pragma omp critical
-        {
-          auto vi = static_cast<Index>(vertices_.size());
-          auto opp_ei = kOppositeEdge.at(ei);
-
-          if (t < 0.5) {
-            node0.insert_vertex(vi, ei);
-            vertices_.emplace_back(lc0, ei, vi,                                  //
-                                   0.0, v0,                                      //
-                                   t, std::numeric_limits<double>::quiet_NaN(),  //
-                                   1.0, v1);
-          } else {
-            node1.insert_vertex(vi, opp_ei);
-            vertices_.emplace_back(lc1, opp_ei, vi,                                    //
-                                   0.0, v1,                                            //
-                                   1.0 - t, std::numeric_limits<double>::quiet_NaN(),  //
-                                   1.0, v0);
-          }
+    // The index of the first vertex of each node.
+    std::vector<Index> node_vis(n_nodes);
+    auto vi = vertex_offset_ + static_cast<Index>(vertices_.size());
+    for (std::size_t i = 0; i < n_nodes; i++) {
+      node_vis.at(i) = vi;
+      vi += bit_count(edge_sets.at(i));
+    }
+    vertices_.resize(static_cast<std::size_t>(vi - vertex_offset_));
+
+    // Each thread updates only the nodes in node_lcs that it is responsible for.
+#pragma omp parallel for schedule(guided)
+    for (std::size_t i = 0; i < n_nodes; i++) {
+      const auto& lc0 = node_lcs.at(i);
+      auto& node0 = node_list_.at(lc0);
+      auto v0 = node0.value();
+
+      auto node_vi = node_vis.at(i);
+      auto edge_set = edge_sets.at(i);
+      while (edge_set != 0) {
+        auto ei = static_cast<EdgeIndex>(bit_pop(&edge_set));
+        auto lc1 = neighbor(lc0, ei);
+        auto v1 = node_list_.at(lc1).value();
+        auto t = v0 / (v0 - v1);
 
-          node0.set_intersection(ei);
-          node1.set_intersection(opp_ei);
+        auto& v = vertices_.at(node_vi - vertex_offset_);
+        if (t < 0.5) {
+          node0.insert_vertex(node_vi, ei);
+          v = {lc0, ei, node_vi,                             //
+               0.0, v0,                                      //
+               t, std::numeric_limits<double>::quiet_NaN(),  //
+               1.0, v1};
+        } else {
+          v = {lc1, kOppositeEdge.at(ei), node_vi,             //
+               0.0, v1,                                            //
+               1.0 - t, std::numeric_limits<double>::quiet_NaN(),  //
+               1.0, v0};
         }
+
+        node0.set_intersection(ei);
+        node_vi++;
       }
     }
-  }
 
-  geometry::Points3 get_vertices() const {
-    geometry::Points3 vertices(static_cast<Index>(vertices_.size() + clustered_vertices_.size()),
-                               3);
-    auto it = vertices.rowwise().begin();
-    for (const auto& v : vertices_) {
-      *it++ = v.position_clamped(node_list_);
-    }
-    for (const auto& v : clustered_vertices_) {
-      *it++ = v;
+    // A node can be on the opposite ends of edges from several nodes, but not of the same edge
+    // index, so the opposite ends are updated one edge index at a time.
+    for (EdgeIndex ei = 0; ei < 14; ei++) {
+      EdgeBitset edge_bit = 1 << ei;
+      EdgeBitset edge_count_mask = edge_bit - 1;
+      auto opp_ei = kOppositeEdge.at(ei);
+
+#pragma omp parallel for schedule(guided)
+      for (std::size_t i = 0; i < n_nodes; i++) {
+        auto edge_set = edge_sets.at(i);
+        if ((edge_set & edge_bit) == 0) {
+          continue;
+        }
+
+        auto node_vi =
+            node_vis.at(i) + bit_count(static_cast<EdgeBitset>(edge_set & edge_count_mask));
+        const auto& v = vertices_.at(node_vi - vertex_offset_);
+        auto lc1 = neighbor(node_lcs.at(i), ei);
+        auto& node1 = node_list_.at(lc1);
+
+        if (v.node_lc == lc1) {
+          node1.insert_vertex(node_vi, opp_ei);
+        }
+        node1.set_intersection(opp_ei);
+      }
     }
+  }
 
+  void snap_vertices_to_bbox(geometry::Points3& vertices) const {
     // To reduce the risk of generating near-degenerate faces during surface clipping,
     // snap vertices that are very close to the bbox .
 
@@ -591,8 +1251,6 @@ class Lattice : public PrimitiveLattice {
       p = ((p.array() - min.array()).abs() < tiny).select(min, p);
       p = ((p.array() - max.array()).abs() < tiny).select(max, p);
     }
-
-    return vertices;
   }
 
   geometry::Vector3 gradient(const LatticeCoordinates& lc) const {
@@ -625,79 +1283,325 @@ class Lattice : public PrimitiveLattice {
     return false;
   }
 
-  std::vector<LatticeCoordinates> knn_nodes(const LatticeCoordinates& lc, int k) const {
-    std::unordered_set<LatticeCoordinates, LatticeCoordinatesHash> visited;
-    visited.insert(lc);
+  // Returns the edges from the first node of the pair to the common neighbors of the nodes,
+  // or zero if the values at the nodes have the same sign.
+  EdgeBitset common_neighbor_edges(const LatticeCoordinatesPair& pair) const {
+    const auto& [lc0, lc1] = pair;
+    if (node_list_.at(lc0).value_sign() == node_list_.at(lc1).value_sign()) {
+      return 0;
+    }
+
+    const auto& deltas = kNeighborLatticeCoordinatesDeltas;
+    EdgeBitset edge_set{};
+    for (EdgeIndex ei = 0; ei < 14; ei++) {
+      auto nlc = neighbor(lc0, ei);
+      LatticeCoordinates delta = nlc - lc1;
+      if (std::find(deltas.begin(), deltas.end(), delta) == deltas.end()) {
+        continue;
+      }
+      if (!second_extended_bbox().contains(position(nlc))) {
+        continue;
+      }
+      edge_set |= 1 << ei;
+    }
+    return edge_set;
+  }
 
-    std::vector<LatticeCoordinates> frontier{lc};
-    std::vector<LatticeCoordinates> next_frontier;
+  // Returns the nodes whose distance from lc in the graph of the nodes within
+  // the second extended bbox is k, in the order of breadth-first search.
+  // The result is valid until the next call with the same buffers.
+  const std::vector<LatticeCoordinates>& knn_nodes(const LatticeCoordinates& lc, int k,
+                                                   KnnNodesBuffers& buffers) const {
+    auto& frontier = buffers.frontier;
+    auto& sorted_frontier = buffers.sorted_frontier;
+    auto& sorted_prev_frontier = buffers.sorted_prev_frontier;
+    auto& candidates = buffers.candidates;
+    auto& order = buffers.order;
+
+    frontier.assign(1, lc);
+    sorted_frontier.assign(1, lc);
+    sorted_prev_frontier.clear();
 
     for (auto i = 0; i < k; i++) {
+      candidates.clear();
       for (const auto& nlc : frontier) {
         for (EdgeIndex ei = 0; ei < 14; ei++) {
           auto nnlc = neighbor(nlc, ei);
-          if (visited.contains(nnlc)) {
-            continue;
+          if (second_extended_bbox().contains(position(nnlc))) {
+            candidates.push_back(nnlc);
           }
-          auto p = position(nnlc);
-          if (!second_extended_bbox().contains(p)) {
-            continue;
-          }
-          visited.insert(nnlc);
-          next_frontier.push_back(nnlc);
         }
       }
 
-      std::swap(frontier, next_frontier);
-      next_frontier.clear();
+      // A neighbor of a node in the frontier is in the previous frontier, the frontier
+      // or the next one. The first occurrence of each node in the next one is kept.
+      order.resize(candidates.size());
+      std::iota(order.begin(), order.end(), Index{0});
+      std::sort(order.begin(), order.end(), [&candidates](auto a, auto b) {
+        const auto& lca = candidates.at(a);
+        const auto& lcb = candidates.at(b);
+        return LatticeCoordinatesLess()(lca, lcb) || (lca == lcb && a < b);
+      });
+
+      std::size_t n_next{};
+      const LatticeCoordinates* last = nullptr;
+      for (auto j : order) {
+        const auto& nlc = candidates.at(j);
+        if (last != nullptr && nlc == *last) {
+          continue;
+        }
+        last = &nlc;
+        if (std::binary_search(sorted_prev_frontier.begin(), sorted_prev_frontier.end(), nlc,
+                               LatticeCoordinatesLess()) ||
+            std::binary_search(sorted_frontier.begin(), sorted_frontier.end(), nlc,
+                               LatticeCoordinatesLess())) {
+          continue;
+        }
+        order.at(n_next++) = j;
+      }
+      order.resize(n_next);
+      std::sort(order.begin(), order.end());
+
+      frontier.clear();
+      for (auto j : order) {
+        frontier.push_back(candidates.at(j));
+      }
+      std::swap(sorted_prev_frontier, sorted_frontier);
+      sorted_frontier.assign(frontier.begin(), frontier.end());
+      std::sort(sorted_frontier.begin(), sorted_frontier.end(), LatticeCoordinatesLess());
     }
 
     return frontier;
   }
 
-  static void refine_vertices(std::vector<Vertex>& vertices) {
-    using Mat = Mat3;
-    using Vec = Vec<3>;
+  // Tracks the surface from the seed by one step.
+  // Returns the edges from the seed to its neighbors with values of the opposite sign,
+  // and the seed to be tracked next, which is empty (k == 0) if the tracking ends.
+  std::pair<EdgeBitset, Seed> track_seed(const Seed& seed, KnnNodesBuffers& buffers,
+                                         std::vector<LatticeCoordinates>& nlcs) const {
+    const auto& lc = seed.lc;
+    const auto& corrector = seed.corrector;
+    auto k = seed.k;
+    const auto& n = node_list_.at(lc);
+
+    EdgeBitset pair_edge_set{};
+    nlcs.clear();
+    auto found_intersection = false;
+    auto reached_minimum = true;
+    for (const auto& nlc : knn_nodes(lc, k, buffers)) {
+      auto boundary_node = is_boundary_node(nlc);
+
+      const auto& nn = node_list_.at(nlc);
+      if (k == 1 && nn.value_sign() != n.value_sign()) {
+        // The following usage of the if statement maximizes the chances of successful
+        // surface tracking.
+        pair_edge_set |= 1 << edge_index(lc, nlc);
+        if (!boundary_node) {
+          found_intersection = true;
+          break;
+        }
+      }
 
-    for (auto& v : vertices) {
-      // Solve y = a x^2 + b x + c for a, b, c with (x, y) = (t0, v0), (t1, v1), (t2, v2).
-      Mat a;
-      a << v.t0 * v.t0, v.t0, 1.0, v.t1 * v.t1, v.t1, 1.0, v.t2 * v.t2, v.t2, 1.0;
-      Vec b(v.v0, v.v1, v.v2);
-      Eigen::ColPivHouseholderQR<Mat> qr_a(a);
-      qr_a.setThreshold(1e-10);
-      if (!qr_a.isInvertible()) {
-        continue;
+      if (std::abs(nn.value()) < std::abs(n.value())) {
+        // The gradient cannot be computed at a boundary node.
+        if (!boundary_node) {
+          nlcs.push_back(nlc);
+        }
+        reached_minimum = false;
       }
-      Vec c = qr_a.solve(b);
+    }
 
-      // Solve a x^2 + b x + c = 0 for x, where 0 < x < 1.
-      auto [s0, s1] = solve_quadratic(c(0), c(1), c(2));
-      auto s = v.t0 < s0 && s0 < v.t2 ? s0 : s1;
+    if (found_intersection) {
+      return {pair_edge_set, {}};
+    }
+
+    if (nlcs.empty()) {
+      if (k >= 10 || reached_minimum) {
+        // Give up.
+        return {pair_edge_set, {}};
+      }
+      return {pair_edge_set, {lc, corrector, k + 1}};
+    }
+
+    geometry::Vector3 neg_grad = -gradient(lc).normalized();
+
+    auto nlc_it = std::min_element(
+        nlcs.begin(), nlcs.end(),
+        [this, &n, &neg_grad, &corrector](const auto& lca, const auto& lcb) {
+          const auto& na = node_list_.at(lca);
+          const auto& nb = node_list_.at(lcb);
+          const auto& p = n.position();
+          const auto& pa = na.position();
+          const auto& pb = nb.position();
+          geometry::Vector3 va = pa - p;
+          geometry::Vector3 vb = pb - p;
+          geometry::Vector3 corrector_a = corrector + va - va.dot(neg_grad) * neg_grad;
+          geometry::Vector3 corrector_b = corrector + vb - vb.dot(neg_grad) * neg_grad;
+          return corrector_a.norm() < corrector_b.norm();
+        });
+
+    const auto& nlc = *nlc_it;
+    const auto& nn = node_list_.at(nlc);
+    geometry::Vector3 v = nn.position() - n.position();
+    return {pair_edge_set, {nlc, corrector + v - v.dot(neg_grad) * neg_grad, 1}};
+  }
+
+  // Refines the vertices with indices vi_begin or greater.
+  void refine_vertices(const FieldFunction& field_fn, double isovalue, int num_passes,
+                       Index vi_begin) {
+    if (num_passes <= 0) {
+      return;
+    }
 
-      if (s < v.t1) {
-        // (t0', t1', t2') = (t0, s, t1).
-        v.t2 = v.t1;
-        v.v2 = v.v1;
+    auto offset = vi_begin - vertex_offset_;
+    auto n = static_cast<Index>(vertices_.size()) - offset;
+    geometry::Points3 vertices(n, 3);
+
+    const auto* field_fn_with_grad = dynamic_cast<const FieldFunctionWithGradient*>(&field_fn);
+
+    for (auto pass = 0; pass < num_passes; pass++) {
+      for (Index i = 0; i < n; i++) {
+        const auto& v = vertices_.at(offset + i);
+        vertices.row(i) = v.position_unclamped(node_list_);
+      }
+
+      if (field_fn_with_grad != nullptr) {
+        auto [values, grads] = field_fn_with_grad->evaluate_with_gradient(vertices);
+
+#pragma omp parallel for
+        for (Index i = 0; i < n; i++) {
+          auto& v = vertices_.at(offset + i);
+          const auto& p0 = node_list_.at(v.node_lc).position();
+          const auto& p1 = node_list_.at(neighbor(v.node_lc, v.ei)).position();
+          v.v1 = values(i) - isovalue;
+          refine_vertex(v, grads.row(i).dot(p1 - p0));
+        }
       } else {
-        // (t0', t1', t2') = (t1, s, t2).
-        v.t0 = v.t1;
-        v.v0 = v.v1;
+        VecX vertex_values = field_fn(vertices).array() - isovalue;
+
+        for (Index i = 0; i < n; i++) {
+          auto& v = vertices_.at(offset + i);
+          v.v1 = vertex_values(i);
+          refine_vertex(v);
+        }
       }
+    }
 
-      v.t1 = s;
-      v.v1 = std::numeric_limits<double>::quiet_NaN();
+    for (Index i = 0; i < n; i++) {
+      const auto& v = vertices_.at(offset + i);
+      if (v.t1 >= 0.5) {
+        auto& node0 = node_list_.at(v.node_lc);
+        auto& node1 = node_list_.at(neighbor(v.node_lc, v.ei));
+        node0.remove_vertex(v.ei);
+        node1.insert_vertex(v.vi, kOppositeEdge.at(v.ei));
+      }
     }
   }
 
-  // Removes nodes without any intersections.
-  void remove_free_nodes(const std::vector<LatticeCoordinates>& node_lcs) {
-    for (const auto& lc : node_lcs) {
-      auto it = node_list_.find(lc);
-      if (it->second.is_free()) {
-        node_list_.erase(it->first);
+  // Refines the vertex with the value v1 and the derivative d1 along the edge at t1.
+  static void refine_vertex(Vertex& v, double d1) {
+    using Mat = Mat<4>;
+    using Vec = Vec<4>;
+
+    // Solve y = a x^3 + b x^2 + c x + d for a, b, c, d with
+    // (x, y) = (t0, v0), (t1, v1), (t2, v2) and (x, dy/dx) = (t1, d1).
+    Mat a;
+    a << v.t0 * v.t0 * v.t0, v.t0 * v.t0, v.t0, 1.0,  //
+        v.t1 * v.t1 * v.t1, v.t1 * v.t1, v.t1, 1.0,   //
+        v.t2 * v.t2 * v.t2, v.t2 * v.t2, v.t2, 1.0,   //
+        3.0 * v.t1 * v.t1, 2.0 * v.t1, 1.0, 0.0;
+    Vec b(v.v0, v.v1, v.v2, d1);
+    Eigen::ColPivHouseholderQR<Mat> qr_a(a);
+    qr_a.setThreshold(1e-10);
+    if (!qr_a.isInvertible()) {
+      refine_vertex(v);
+      return;
+    }
+    Vec c = qr_a.solve(b);
+
+    auto poly = [&c](double x) { return ((c(0) * x + c(1)) * x + c(2)) * x + c(3); };
+    auto dpoly = [&c](double x) { return (3.0 * c(0) * x + 2.0 * c(1)) * x + c(2); };
+
+    // Narrow the bracket (t0, t2) with t1.
+    if (sign(v.v1) == sign(v.v0)) {
+      v.t0 = v.t1;
+      v.v0 = v.v1;
+    } else {
+      v.t2 = v.t1;
+      v.v2 = v.v1;
+    }
+
+    // Solve the cubic equation in the bracket by Newton's method safeguarded by bisection.
+    auto lo = v.t0;
+    auto hi = v.t2;
+    auto sign_lo = sign(v.v0);
+    auto s = v.t0 - v.v0 * (v.t2 - v.t0) / (v.v2 - v.v0);
+    for (auto iter = 0; iter < 20; iter++) {
+      auto y = poly(s);
+      if (sign(y) == sign_lo) {
+        lo = s;
+      } else {
+        hi = s;
+      }
+
+      auto next_s = s - y / dpoly(s);
+      if (!(std::min(lo, hi) < next_s && next_s < std::max(lo, hi))) {
+        next_s = 0.5 * (lo + hi);
+      }
+
+      auto converged = std::abs(next_s - s) < 1e-12;
+      s = next_s;
+      if (converged) {
+        break;
       }
     }
+
+    v.t1 = s;
+    v.v1 = std::numeric_limits<double>::quiet_NaN();
+  }
+
+  static void refine_vertex(Vertex& v) {
+    using Mat = Mat3;
+    using Vec = Vec<3>;
+
+    // Solve y = a x^2 + b x + c for a, b, c with (x, y) = (t0, v0), (t1, v1), (t2, v2).
+    Mat a;
+    a << v.t0 * v.t0, v.t0, 1.0, v.t1 * v.t1, v.t1, 1.0, v.t2 * v.t2, v.t2, 1.0;
+    Vec b(v.v0, v.v1, v.v2);
+    Eigen::ColPivHouseholderQR<Mat> qr_a(a);
+    qr_a.setThreshold(1e-10);
+    if (!qr_a.isInvertible()) {
+      return;
+    }
+    Vec c = qr_a.solve(b);
+
+    // Solve a x^2 + b x + c = 0 for x, where 0 < x < 1.
+    auto [s0, s1] = solve_quadratic(c(0), c(1), c(2));
+    auto s = v.t0 < s0 && s0 < v.t2 ? s0 : s1;
+
+    if (s < v.t1) {
+      // (t0', t1', t2') = (t0, s, t1).
+      v.t2 = v.t1;
+      v.v2 = v.v1;
+    } else {
+      // (t0', t1', t2') = (t1, s, t2).
+      v.t0 = v.t1;
+      v.v0 = v.v1;
+    }
+
+    v.t1 = s;
+    v.v1 = std::numeric_limits<double>::quiet_NaN();
+  }
+
+  // Removes nodes without any intersections, also from node_lcs.
+  void remove_free_nodes(std::vector<LatticeCoordinates>& node_lcs) {
+    std::erase_if(node_lcs, [this](const auto& lc) {
+      if (node_list_.at(lc).is_free()) {
+        node_list_.erase(lc);
+        return true;
+      }
+      return false;
+    });
   }
 
   static std::pair<double, double> solve_quadratic(double a, double b, double c) {
@@ -715,9 +1619,13 @@ class Lattice : public PrimitiveLattice {
 
   NodeList node_list_;
   std::vector<LatticeCoordinates> nodes_to_evaluate_;
-  std::vector<Vertex> vertices_;
+  std::deque<Vertex> vertices_;
+  // The index of vertices_.front().
+  Index vertex_offset_{};
   std::unordered_map<Index, Index> cluster_map_;
-  std::vector<geometry::Point3> clustered_vertices_;
+  std::deque<geometry::Point3> clustered_vertices_;
+  // The number of clustered vertices released.
+  Index clustered_vertex_offset_{};
   std::optional<InterpolatedValue> value_at_arbitrary_point_;
 };
 
@@ -41,11 +41,13 @@ class Node {
  public:
   explicit Node(const geometry::Point3& position) : position_(position) {}
 
-  void cluster(const std::vector<geometry::Point3>& vertices,
+  // Clusters the vertices on each surface around the node that has a single hole.
+  // vertex_position(vi) returns the position of the vertex vi.
+  // The index of a clustered vertex is vi_offset + (its index in clustered_vertices).
+  template <class VertexPosition, class Container>
+  void cluster(VertexPosition vertex_position, Index vi_offset,
                std::unordered_map<Index, Index>& cluster_map,
-               std::vector<geometry::Point3>& clustered_vertices) const {
-    auto vi_offset = static_cast<Index>(vertices.size());
-
+               Container& clustered_vertices) const {
     auto surfaces = connected_components(intersections_);
     for (auto surface : surfaces) {
       auto holes = connected_components(surface ^ kEdgeSetMask);
@@ -62,7 +64,7 @@ class Node {
       while (surface != 0) {
         auto edge_idx = bit_pop(&surface);
         auto vi = vertex(edge_idx);
-        clustered += vertices.at(vi);
+        clustered += vertex_position(vi);
         cluster_map.emplace(vi, new_vi);
       }
       clustered /= static_cast<double>(n);
@@ -1,17 +1,220 @@
 #pragma once
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <polatory/common/macros.hpp>
 #include <polatory/isosurface/rmt/lattice_coordinates.hpp>
 #include <polatory/isosurface/rmt/node.hpp>
-#include <unordered_map>
+#include <polatory/types.hpp>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace polatory::isosurface::rmt {
 
-class NodeList : public std::unordered_map<LatticeCoordinates, Node, LatticeCoordinatesHash> {
+// A map from lattice coordinates to nodes.
+// The nodes are stored in a deque, so references to them remain valid on insertion.
+// They are indexed by an open-addressing hash table with linear probing,
+// which is keyed by the lattice coordinates packed into a 64-bit integer.
+// Erasing a node moves the last node into its place, so it invalidates references
+// to the erased node and to the last one.
+class NodeList {
+  using Entry = std::pair<LatticeCoordinates, Node>;
+  using Entries = std::deque<Entry>;
+
+  struct Slot {
+    std::uint64_t key{kEmptyKey};
+    Index index{};
+  };
+
+  static constexpr std::uint64_t kEmptyKey = ~std::uint64_t{0};
+  static constexpr int kCoordinateBits = 21;
+  static constexpr int kCoordinateBias = 1 << (kCoordinateBits - 1);
+  static constexpr std::size_t kMinCapacity = 1024;
+
  public:
+  using iterator = Entries::iterator;
+  using const_iterator = Entries::const_iterator;
+
+  // The range of each lattice coordinate that can be stored.
+  static constexpr int kMinCoordinate = -kCoordinateBias;
+  static constexpr int kMaxCoordinate = kCoordinateBias - 1;
+
+  Node& at(const LatticeCoordinates& lc) { return entries_[checked_index(lc)].second; }
+
+  const Node& at(const LatticeCoordinates& lc) const {
+    return entries_[checked_index(lc)].second;
+  }
+
+  iterator begin() { return entries_.begin(); }
+
+  const_iterator begin() const { return entries_.begin(); }
+
+  void clear() {
+    entries_.clear();
+    slots_.clear();
+    shift_ = 0;
+  }
+
+  bool contains(const LatticeCoordinates& lc) const { return find_index(lc) >= 0; }
+
+  std::pair<iterator, bool> emplace(const LatticeCoordinates& lc, Node&& node) {
+    if (2 * (entries_.size() + 1) > slots_.size()) {
+      rehash(std::max(kMinCapacity, 2 * slots_.size()));
+    }
+
+    auto key = pack(lc);
+    auto mask = slots_.size() - 1;
+    for (auto i = home_slot(key);; i = (i + 1) & mask) {
+      auto& slot = slots_.at(i);
+      if (slot.key == key) {
+        return {entries_.begin() + slot.index, false};
+      }
+      if (slot.key == kEmptyKey) {
+        slot.key = key;
+        slot.index = static_cast<Index>(entries_.size());
+        entries_.emplace_back(lc, std::move(node));
+        return {std::prev(entries_.end()), true};
+      }
+    }
+  }
+
+  bool empty() const { return entries_.empty(); }
+
+  iterator end() { return entries_.end(); }
+
+  const_iterator end() const { return entries_.end(); }
+
+  std::size_t erase(const LatticeCoordinates& lc) {
+    if (slots_.empty()) {
+      return 0;
+    }
+
+    auto key = pack(lc);
+    auto mask = slots_.size() - 1;
+    auto i = home_slot(key);
+    while (slots_.at(i).key != key) {
+      if (slots_.at(i).key == kEmptyKey) {
+        return 0;
+      }
+      i = (i + 1) & mask;
+    }
+
+    auto index = slots_.at(i).index;
+
+    // Backward-shift deletion, which keeps the probe sequences intact without tombstones.
+    for (auto j = (i + 1) & mask; slots_.at(j).key != kEmptyKey; j = (j + 1) & mask) {
+      auto home = home_slot(slots_.at(j).key);
+      // Move the slot j to i unless its home lies cyclically in (i, j].
+      auto stays = i <= j ? i < home && home <= j : i < home || home <= j;
+      if (!stays) {
+        slots_.at(i) = slots_.at(j);
+        i = j;
+      }
+    }
+    slots_.at(i) = Slot{};
+
+    // Keep the entries contiguous by moving the last one into the hole.
+    auto last = static_cast<Index>(entries_.size()) - 1;
+    if (index != last) {
+      entries_.at(index) = std::move(entries_.at(last));
+      slot_of(entries_.at(index).first).index = index;
+    }
+    entries_.pop_back();
+
+    return 1;
+  }
+
+  iterator find(const LatticeCoordinates& lc) {
+    auto index = find_index(lc);
+    return index >= 0 ? entries_.begin() + index : entries_.end();
+  }
+
+  const_iterator find(const LatticeCoordinates& lc) const {
+    auto index = find_index(lc);
+    return index >= 0 ? entries_.begin() + index : entries_.end();
+  }
+
   Node* node_ptr(const LatticeCoordinates& lc) {
-    auto it = find(lc);
-    return it != end() ? &it->second : nullptr;
+    auto index = find_index(lc);
+    return index >= 0 ? &entries_[index].second : nullptr;
+  }
+
+  std::size_t size() const { return entries_.size(); }
+
+ private:
+  static std::uint64_t pack(const LatticeCoordinates& lc) {
+    POLATORY_ASSERT((lc.array() >= -kCoordinateBias).all() &&
+                    (lc.array() < kCoordinateBias).all());
+
+    return static_cast<std::uint64_t>(lc(0) + kCoordinateBias) |
+           (static_cast<std::uint64_t>(lc(1) + kCoordinateBias) << kCoordinateBits) |
+           (static_cast<std::uint64_t>(lc(2) + kCoordinateBias) << (2 * kCoordinateBits));
+  }
+
+  Index checked_index(const LatticeCoordinates& lc) const {
+    auto index = find_index(lc);
+    if (index < 0) {
+      throw std::out_of_range("node not found");
+    }
+    return index;
   }
+
+  Index find_index(const LatticeCoordinates& lc) const {
+    if (slots_.empty()) {
+      return -1;
+    }
+
+    auto key = pack(lc);
+    auto mask = slots_.size() - 1;
+    for (auto i = home_slot(key);; i = (i + 1) & mask) {
+      const auto& slot = slots_[i];
+      if (slot.key == key) {
+        return slot.index;
+      }
+      if (slot.key == kEmptyKey) {
+        return -1;
+      }
+    }
+  }
+
+  // Fibonacci hashing.
+  std::size_t home_slot(std::uint64_t key) const {
+    return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15) >> shift_);
+  }
+
+  void rehash(std::size_t capacity) {
+    slots_.assign(capacity, Slot{});
+    shift_ = 64 - std::countr_zero(capacity);
+
+    auto mask = capacity - 1;
+    Index index = 0;
+    for (const auto& entry : entries_) {
+      auto key = pack(entry.first);
+      auto i = home_slot(key);
+      while (slots_[i].key != kEmptyKey) {
+        i = (i + 1) & mask;
+      }
+      slots_[i] = {key, index++};
+    }
+  }
+
+  Slot& slot_of(const LatticeCoordinates& lc) {
+    auto key = pack(lc);
+    auto mask = slots_.size() - 1;
+    auto i = home_slot(key);
+    while (slots_.at(i).key != key) {
+      i = (i + 1) & mask;
+    }
+    return slots_.at(i);
+  }
+
+  Entries entries_;
+  std::vector<Slot> slots_;
+  int shift_{};
 };
 
 }  // namespace polatory::isosurface::rmt
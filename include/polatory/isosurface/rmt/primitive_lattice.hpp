@@ -9,6 +9,7 @@
 #include <numbers>
 #include <polatory/common/macros.hpp>
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/isosurface/rmt/edge.hpp>
 #include <polatory/isosurface/rmt/lattice_coordinates.hpp>
@@ -91,6 +92,11 @@ class PrimitiveLattice {
       }
     }
 
+    if (vertices.empty()) {
+      // The plane does not intersect the bbox.
+      return {0, -1};
+    }
+
     auto min = std::numeric_limits<double>::infinity();
     auto max = -std::numeric_limits<double>::infinity();
     for (const auto& v : vertices) {
@@ -162,6 +168,22 @@ class PrimitiveLattice {
     return tet;
   }
 
+  // Returns the lattice points within the ranges of the lattice coordinates on the slabs
+  // lc2_begin <= lc2 < lc2_end, ordered by the third, the second and then the first coordinate.
+  geometry::GridPoints3 grid_points(int lc2_begin, int lc2_end) const {
+    geometry::GridPoints3 grid(lc_origin_, basis_);
+    for (auto lc2 = lc2_begin; lc2 < lc2_end; lc2++) {
+      auto [lc1_min, lc1_max] = second_lattice_coordinate_range(lc2);
+      for (auto lc1 = lc1_min; lc1 <= lc1_max; lc1++) {
+        auto [lc0_min, lc0_max] = first_lattice_coordinate_range(lc1, lc2);
+        if (lc0_min <= lc0_max) {
+          grid.add_run({lc0_min, lc1, lc2}, lc0_max - lc0_min + 1);
+        }
+      }
+    }
+    return grid;
+  }
+
   // Returns the bounding box that contains all nodes to be clustered.
   const geometry::Bbox3& first_extended_bbox() const { return first_ext_bbox_; }
 
@@ -170,11 +192,12 @@ class PrimitiveLattice {
   // Returns the bounding box that contains all nodes eligible to be added to the lattice.
   const geometry::Bbox3& second_extended_bbox() const { return second_ext_bbox_; }
 
- private:
+ protected:
   geometry::Vector3 lattice_coordinates_unrounded(const geometry::Point3& p) const {
     return p * basis_inv_ - lc_origin_;
   }
 
+ private:
   geometry::Vector3 compute_lattice_coordinates_origin() const {
     geometry::Point3 center = bbox_.center();
     return (center * basis_inv_).array().round();
@@ -1,48 +1,104 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <exception>
+#include <omp.h>
 #include <polatory/common/complementary_indices.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolant.hpp>
 #include <polatory/model.hpp>
 #include <polatory/types.hpp>
-#include <unordered_set>
+#include <stdexcept>
 #include <vector>
 
 namespace polatory::kriging {
 
+// Returns the predictions at the points of each set by the interpolant fitted to the rest.
+// Up to num_concurrent_sets sets are processed concurrently, and the threads are divided
+// evenly among them.
+// If warm_start is true, an interpolant is first fitted to all points, and the fitting of each
+// set starts from its weights. This pays off when there are many sets, each of which is small
+// compared to the rest.
 template <int Dim>
 VecX cross_validate(const Model<Dim>& model, const geometry::Points<Dim>& points,
                     const VecX& values, const Eigen::VectorXi& set_ids, double tolerance,
-                    int max_iter, double accuracy) {
+                    int max_iter, double accuracy, int num_concurrent_sets = 1,
+                    bool warm_start = false) {
+  if (num_concurrent_sets < 1) {
+    throw std::invalid_argument("num_concurrent_sets must be positive");
+  }
+
   auto n_points = points.rows();
   VecX predictions = VecX::Zero(n_points);
 
-  std::unordered_set<int> ids(set_ids.begin(), set_ids.end());
-  for (auto id : ids) {
-    std::vector<Index> test_set;
-    for (Index i = 0; i < n_points; i++) {
-      if (set_ids(i) == id) {
-        test_set.push_back(i);
+  std::vector<int> ids(set_ids.begin(), set_ids.end());
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  auto n_sets = static_cast<Index>(ids.size());
+
+  warm_start = warm_start && n_sets > 1;
+  Interpolant<Dim> full_interpolant(model);
+  if (warm_start) {
+    full_interpolant.fit(points, values, tolerance, max_iter, accuracy);
+  }
+
+  // Nested parallelism is needed for each set to use more than one thread.
+  auto max_threads = omp_get_max_threads();
+  auto n_outer_threads =
+      static_cast<int>(std::min({Index{num_concurrent_sets}, n_sets, Index{max_threads}}));
+  auto n_inner_threads = std::max(1, max_threads / std::max(1, n_outer_threads));
+  auto max_active_levels = omp_get_max_active_levels();
+  if (n_outer_threads > 1 && n_inner_threads > 1) {
+    omp_set_max_active_levels(std::max(2, max_active_levels));
+  }
+
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic) num_threads(std::max(1, n_outer_threads))
+  for (Index k = 0; k < n_sets; k++) {
+    try {
+      omp_set_num_threads(n_inner_threads);
+
+      auto id = ids.at(k);
+
+      std::vector<Index> test_set;
+      for (Index i = 0; i < n_points; i++) {
+        if (set_ids(i) == id) {
+          test_set.push_back(i);
+        }
       }
-    }
 
-    auto train_set = common::complementary_indices(test_set, n_points);
+      auto train_set = common::complementary_indices(test_set, n_points);
 
-    geometry::Points<Dim> train_points = points(train_set, Eigen::all);
-    geometry::Points<Dim> test_points = points(test_set, Eigen::all);
+      geometry::Points<Dim> train_points = points(train_set, Eigen::all);
+      geometry::Points<Dim> test_points = points(test_set, Eigen::all);
 
-    VecX train_values = values(train_set, Eigen::all);
+      VecX train_values = values(train_set, Eigen::all);
 
-    Interpolant<Dim> interpolant(model);
-    interpolant.fit(train_points, train_values, tolerance, max_iter, accuracy);
-    auto test_values_fit = interpolant.evaluate(test_points, accuracy);
+      Interpolant<Dim> interpolant(model);
+      interpolant.fit(train_points, train_values, tolerance, max_iter, accuracy,
+                      warm_start ? &full_interpolant : nullptr);
+      auto test_values_fit = interpolant.evaluate(test_points, accuracy);
 
-    for (Index j = 0; j < static_cast<Index>(test_set.size()); j++) {
-      predictions(test_set.at(j)) = test_values_fit(j);
+      // Each set writes to distinct elements.
+      for (Index j = 0; j < static_cast<Index>(test_set.size()); j++) {
+        predictions(test_set.at(j)) = test_values_fit(j);
+      }
+    } catch (...) {
+#pragma omp critical
+      if (!exception) {
+        exception = std::current_exception();
+      }
     }
   }
 
+  omp_set_max_active_levels(max_active_levels);
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+
   return predictions;
 }
 
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <exception>
+#include <numbers>
+#include <numeric>
+#include <optional>
+#include <polatory/kriging/variogram_fitting.hpp>
+#include <polatory/kriging/variogram_set.hpp>
+#include <polatory/kriging/weight_function.hpp>
+#include <polatory/model.hpp>
+#include <polatory/types.hpp>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace polatory::kriging {
+
+namespace internal {
+
+// Returns the i-th element of the Halton sequence in the given base.
+inline double radical_inverse(Index i, int base) {
+  auto inv_base = 1.0 / base;
+  auto f = inv_base;
+  auto x = 0.0;
+  while (i > 0) {
+    x += f * static_cast<double>(i % base);
+    i /= base;
+    f *= inv_base;
+  }
+  return x;
+}
+
+// Returns the parameters of the i-th starting point, which are drawn from a Halton design.
+// A parameter with finite bounds is sampled uniformly within them, and any other parameter
+// is sampled log-uniformly within a factor of 10 from the initial value.
+template <int Dim>
+std::vector<double> starting_parameters(const Model<Dim>& model, Index i) {
+  static constexpr std::array<int, 16> kPrimes{2,  3,  5,  7,  11, 13, 17, 19,
+                                               23, 29, 31, 37, 41, 43, 47, 53};
+
+  auto params = model.parameters();
+  if (i == 0) {
+    return params;
+  }
+
+  auto lbs = model.parameter_lower_bounds();
+  auto ubs = model.parameter_upper_bounds();
+  auto num_params = model.num_parameters();
+  for (Index j = 0; j < num_params; j++) {
+    auto u = radical_inverse(i, kPrimes.at(j % kPrimes.size()));
+    auto lb = lbs.at(j);
+    auto ub = ubs.at(j);
+    if (std::isfinite(lb) && std::isfinite(ub)) {
+      params.at(j) = lb + u * (ub - lb);
+    } else {
+      params.at(j) = std::clamp(params.at(j) * std::pow(10.0, 2.0 * u - 1.0), lb, ub);
+    }
+  }
+
+  return params;
+}
+
+// The type of the rotation of the anisotropy.
+template <int Dim>
+struct RotationType {
+  using type = typename VariogramFitting<Dim>::Rotation;
+};
+
+// The anisotropy is not fitted in 1D.
+template <>
+struct RotationType<1> {
+  using type = std::nullptr_t;
+};
+
+// Returns a rotation drawn uniformly at random.
+template <int Dim>
+typename RotationType<Dim>::type random_rotation(std::mt19937& engine) {
+  std::uniform_real_distribution<double> dist(0.0, 1.0);
+  if constexpr (Dim == 2) {
+    return Eigen::Rotation2Dd(std::numbers::pi * (2.0 * dist(engine) - 1.0));
+  } else {
+    static_assert(Dim == 3);
+    // Shoemake's method.
+    auto u1 = dist(engine);
+    auto u2 = 2.0 * std::numbers::pi * dist(engine);
+    auto u3 = 2.0 * std::numbers::pi * dist(engine);
+    return Eigen::Quaterniond(std::sqrt(u1) * std::cos(u3), std::sqrt(1.0 - u1) * std::sin(u2),
+                              std::sqrt(1.0 - u1) * std::cos(u2), std::sqrt(u1) * std::sin(u3));
+  }
+}
+
+}  // namespace internal
+
+// Fits the model to the variograms from num_starts starting points in parallel
+// and returns the fits in ascending order of the final cost.
+// The first starting point is the given model.
+// The starting points are generated deterministically, so the result does not depend
+// on the number of threads, and the best fit is at least as good as with fewer starts.
+template <int Dim>
+std::vector<VariogramFitting<Dim>> fit_variogram(
+    const VariogramSet<Dim>& variog_set, const Model<Dim>& model, Index num_starts,
+    const WeightFunction& weight_fn = WeightFunction::kNumPairsOverDistanceSquared,
+    bool fit_anisotropy = true) {
+  if (num_starts < 1) {
+    throw std::invalid_argument("num_starts must be positive");
+  }
+
+  static constexpr std::mt19937::result_type kSeed = 0;
+
+  // The starting points are generated serially.
+  std::vector<Model<Dim>> starts;
+  for (Index i = 0; i < num_starts; i++) {
+    auto& start = starts.emplace_back(model);
+    start.set_parameters(internal::starting_parameters(model, i));
+  }
+
+  std::mt19937 engine(kSeed);
+  std::vector<typename internal::RotationType<Dim>::type> rotations;
+  if constexpr (Dim > 1) {
+    for (Index i = 0; i < num_starts; i++) {
+      rotations.push_back(internal::random_rotation<Dim>(engine));
+    }
+  }
+
+  std::vector<std::optional<VariogramFitting<Dim>>> fits(num_starts);
+  std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+  for (Index i = 0; i < num_starts; i++) {
+    try {
+      if constexpr (Dim == 1) {
+        fits.at(i).emplace(variog_set, starts.at(i), weight_fn, fit_anisotropy);
+      } else {
+        fits.at(i).emplace(variog_set, starts.at(i), weight_fn, fit_anisotropy, rotations.at(i));
+      }
+    } catch (...) {
+#pragma omp critical
+      if (!exception) {
+        exception = std::current_exception();
+      }
+    }
+  }
+
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+
+  std::vector<Index> order(num_starts);
+  std::iota(order.begin(), order.end(), Index{0});
+  std::stable_sort(order.begin(), order.end(), [&](Index i, Index j) {
+    return fits.at(i)->final_cost() < fits.at(j)->final_cost();
+  });
+
+  std::vector<VariogramFitting<Dim>> result;
+  result.reserve(num_starts);
+  for (auto i : order) {
+    result.push_back(std::move(*fits.at(i)));
+  }
+
+  return result;
+}
+
+}  // namespace polatory::kriging
@@ -5,97 +5,153 @@
 #include <polatory/common/macros.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/kriging/variogram.hpp>
+#include <polatory/kriging/variogram_set.hpp>
 #include <polatory/types.hpp>
 #include <utility>
 #include <vector>
 
 namespace polatory::kriging {
 
+// The estimator of the semivariance at each lag.
+enum class VariogramEstimator {
+  // The classical estimator by Matheron, half the mean of the squared increments.
+  kMatheron,
+  // The robust estimator by Cressie and Hawkins, based on the mean of the square roots
+  // of the absolute increments.
+  kCressieHawkins,
+  // The madogram, half the mean of the absolute increments.
+  kMadogram,
+};
+
+// Accumulates pairs of points into the lag bins of all directions.
+// The bins are stored contiguously, ordered by direction and then by lag,
+// and hold the sums required by every estimator.
 template <int Dim>
 class VariogramBuilder {
   static constexpr int kDim = Dim;
-  using Point = geometry::Point<kDim>;
   using Variogram = Variogram<kDim>;
-  using Vector = geometry::Vector<Dim>;
+  using VariogramSet = VariogramSet<kDim>;
+  using Vectors = geometry::Vectors<kDim>;
+
+  struct Bin {
+    double distance{};
+    double squared_increment{};
+    double sqrt_abs_increment{};
+    double abs_increment{};
+    Index num_pairs{};
+  };
 
  public:
   VariogramBuilder(double lag_distance, double lag_tolerance, Index num_lags,
-                   const Vector& direction)
+                   const Vectors& directions)
       : lag_distance_(lag_distance),
         inv_lag_distance_(1.0 / lag_distance),
         lag_tolerance_(lag_tolerance),
         num_lags_(num_lags),
-        direction_(direction) {
-    bin_distance_.resize(num_lags);
-    bin_gamma_.resize(num_lags);
-    bin_num_pairs_.resize(num_lags);
-  }
+        directions_(directions),
+        bins_(directions.rows() * num_lags) {}
 
-  void add_pair(const Point& point_i, const Point& point_j, double value_i, double value_j) {
-    auto lag = point_j - point_i;
-    auto dist = lag.norm();
-    auto incr = value_j - value_i;
-    auto gamma = 0.5 * (incr * incr);
+  // Adds a pair of points in the direction k that are distance apart
+  // and whose values differ by increment.
+  void add_pair(Index k, double distance, double increment) {
+    POLATORY_ASSERT(k >= 0 && k < directions_.rows());
 
-    auto first = static_cast<Index>(std::ceil(inv_lag_distance_ * (dist - lag_tolerance_)));
-    auto last = static_cast<Index>(std::floor(inv_lag_distance_ * (dist + lag_tolerance_)));
+    auto first = static_cast<Index>(std::ceil(inv_lag_distance_ * (distance - lag_tolerance_)));
+    auto last = static_cast<Index>(std::floor(inv_lag_distance_ * (distance + lag_tolerance_)));
     first = std::max(first, Index{0});
     last = std::min(last, num_lags_ - 1);
+    if (first > last) {
+      return;
+    }
+
+    auto abs_increment = std::abs(increment);
+    auto squared_increment = increment * increment;
+    auto sqrt_abs_increment = std::sqrt(abs_increment);
 
-    for (Index bin = first; bin <= last; bin++) {
-      bin_distance_.at(bin) += dist;
-      bin_gamma_.at(bin) += gamma;
-      bin_num_pairs_.at(bin)++;
+    auto* bins = bins_.data() + k * num_lags_;
+    for (auto bin = first; bin <= last; bin++) {
+      auto& b = bins[bin];
+      b.distance += distance;
+      b.squared_increment += squared_increment;
+      b.sqrt_abs_increment += sqrt_abs_increment;
+      b.abs_increment += abs_increment;
+      b.num_pairs++;
     }
   }
 
-  Variogram into_variogram() {
-    auto d_it = bin_distance_.begin();
-    auto g_it = bin_gamma_.begin();
-    auto np_it = bin_num_pairs_.begin();
-    while (np_it != bin_num_pairs_.end()) {
-      auto np = *np_it;
-      if (np == 0) {
-        // Remove empty bin.
-        d_it = bin_distance_.erase(d_it);
-        g_it = bin_gamma_.erase(g_it);
-        np_it = bin_num_pairs_.erase(np_it);
-      } else {
-        *d_it /= static_cast<double>(np);
-        *g_it /= static_cast<double>(np);
-
-        ++d_it;
-        ++g_it;
-        ++np_it;
+  // Returns the variograms of the directions with at least one pair, without empty bins.
+  VariogramSet into_variogram_set(VariogramEstimator estimator) const {
+    std::vector<Variogram> variograms;
+    for (Index k = 0; k < directions_.rows(); k++) {
+      std::vector<double> bin_distance;
+      std::vector<double> bin_gamma;
+      std::vector<Index> bin_num_pairs;
+
+      for (Index bin = 0; bin < num_lags_; bin++) {
+        const auto& b = bins_.at(k * num_lags_ + bin);
+        if (b.num_pairs == 0) {
+          continue;
+        }
+
+        auto np = static_cast<double>(b.num_pairs);
+        bin_distance.push_back(b.distance / np);
+        bin_gamma.push_back(gamma(b, estimator));
+        bin_num_pairs.push_back(b.num_pairs);
       }
+
+      if (bin_num_pairs.empty()) {
+        continue;
+      }
+
+      variograms.emplace_back(std::move(bin_distance), std::move(bin_gamma),
+                              std::move(bin_num_pairs), directions_.row(k));
     }
 
-    return Variogram(std::move(bin_distance_), std::move(bin_gamma_), std::move(bin_num_pairs_),
-                     direction_);
+    return VariogramSet{std::move(variograms)};
   }
 
   void merge(const VariogramBuilder& other) {
     POLATORY_ASSERT(other.lag_distance_ == lag_distance_);
     POLATORY_ASSERT(other.lag_tolerance_ == lag_tolerance_);
     POLATORY_ASSERT(other.num_lags_ == num_lags_);
-    POLATORY_ASSERT(other.direction_ == direction_);
+    POLATORY_ASSERT(other.directions_ == directions_);
 
-    for (Index i = 0; i < num_lags_; i++) {
-      bin_distance_.at(i) += other.bin_distance_.at(i);
-      bin_gamma_.at(i) += other.bin_gamma_.at(i);
-      bin_num_pairs_.at(i) += other.bin_num_pairs_.at(i);
+    auto n = bins_.size();
+    for (std::size_t i = 0; i < n; i++) {
+      auto& b = bins_[i];
+      const auto& ob = other.bins_[i];
+      b.distance += ob.distance;
+      b.squared_increment += ob.squared_increment;
+      b.sqrt_abs_increment += ob.sqrt_abs_increment;
+      b.abs_increment += ob.abs_increment;
+      b.num_pairs += ob.num_pairs;
     }
   }
 
  private:
-  const double lag_distance_;
-  const double inv_lag_distance_;
-  const double lag_tolerance_;
-  const Index num_lags_;
-  const Vector direction_;
-  std::vector<double> bin_distance_;
-  std::vector<double> bin_gamma_;
-  std::vector<Index> bin_num_pairs_;
+  static double gamma(const Bin& b, VariogramEstimator estimator) {
+    auto np = static_cast<double>(b.num_pairs);
+
+    switch (estimator) {
+      case VariogramEstimator::kMatheron:
+        return 0.5 * b.squared_increment / np;
+      case VariogramEstimator::kCressieHawkins:
+        return 0.5 * std::pow(b.sqrt_abs_increment / np, 4.0) /
+               (0.457 + 0.494 / np + 0.045 / (np * np));
+      case VariogramEstimator::kMadogram:
+        return 0.5 * b.abs_increment / np;
+      default:
+        POLATORY_UNREACHABLE();
+        return 0.0;
+    }
+  }
+
+  double lag_distance_;
+  double inv_lag_distance_;
+  double lag_tolerance_;
+  Index num_lags_;
+  Vectors directions_;
+  std::vector<Bin> bins_;
 };
 
-}  // namespace polatory::kriging
\ No newline at end of file
+}  // namespace polatory::kriging
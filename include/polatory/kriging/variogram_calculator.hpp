@@ -1,13 +1,18 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <iterator>
 #include <numbers>
+#include <numeric>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/kriging/variogram.hpp>
 #include <polatory/kriging/variogram_builder.hpp>
 #include <polatory/kriging/variogram_set.hpp>
 #include <polatory/types.hpp>
 #include <stdexcept>
+#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -16,12 +21,102 @@ namespace polatory::kriging {
 template <int Dim>
 class VariogramCalculator {
   static constexpr int kDim = Dim;
+  using Point = geometry::Point<kDim>;
   using Points = geometry::Points<kDim>;
-  using Variogram = Variogram<kDim>;
   using VariogramBuilder = VariogramBuilder<kDim>;
   using VariogramSet = VariogramSet<kDim>;
   using Vector = geometry::Vector<kDim>;
   using Vectors = geometry::Vectors<kDim>;
+  using Cell = std::array<Index, kDim>;
+
+  // The points sorted by the cells of a uniform grid that contain them.
+  class CellGrid {
+    static constexpr double kMaxCellsPerDimension = 1e15;
+
+   public:
+    CellGrid(const Points& points, double cell_size) {
+      auto num_points = points.rows();
+      if (num_points == 0) {
+        return;
+      }
+
+      Point min = points.colwise().minCoeff();
+      Point max = points.colwise().maxCoeff();
+      std::vector<Cell> point_cells(num_points);
+
+      // If cell_size is zero or too small for the cells to be indexed,
+      // all points are put in a single cell.
+      auto single_cell = !((max - min).maxCoeff() / cell_size < kMaxCellsPerDimension);
+      for (Index i = 0; i < num_points && !single_cell; i++) {
+        for (auto d = 0; d < kDim; d++) {
+          point_cells.at(i).at(d) =
+              static_cast<Index>(std::floor((points(i, d) - min(d)) / cell_size));
+        }
+      }
+
+      point_indices_.resize(num_points);
+      std::iota(point_indices_.begin(), point_indices_.end(), Index{0});
+      std::sort(point_indices_.begin(), point_indices_.end(), [&](auto i, auto j) {
+        return std::tie(point_cells.at(i), i) < std::tie(point_cells.at(j), j);
+      });
+
+      for (Index i = 0; i < num_points; i++) {
+        const auto& cell = point_cells.at(point_indices_.at(i));
+        if (cells_.empty() || cells_.back() != cell) {
+          cells_.push_back(cell);
+          cell_begins_.push_back(i);
+        }
+      }
+      cell_begins_.push_back(num_points);
+    }
+
+    const Cell& cell(Index c) const { return cells_.at(c); }
+
+    // Returns the index of the first point in the cell c in the sorted order.
+    Index cell_begin(Index c) const { return cell_begins_.at(c); }
+
+    Index cell_end(Index c) const { return cell_begins_.at(c + 1); }
+
+    // Returns the index of the cell, or -1 if it does not contain any points.
+    Index find_cell(const Cell& cell) const {
+      auto it = std::lower_bound(cells_.begin(), cells_.end(), cell);
+      return it != cells_.end() && *it == cell ? std::distance(cells_.begin(), it) : -1;
+    }
+
+    Index num_cells() const { return static_cast<Index>(cells_.size()); }
+
+    // Returns the indices of the points in the sorted order.
+    const std::vector<Index>& point_indices() const { return point_indices_; }
+
+    // Returns the zero offset followed by the offsets to the adjacent cells that come after
+    // a cell in the lexicographic order, so that each pair of cells is visited once.
+    static std::vector<Cell> forward_neighbor_offsets() {
+      std::vector<Cell> offsets{Cell{}};
+      Cell offset;
+      offset.fill(-1);
+      while (true) {
+        if (offset > Cell{}) {
+          offsets.push_back(offset);
+        }
+
+        auto d = kDim - 1;
+        while (d >= 0 && offset.at(d) == 1) {
+          offset.at(d) = -1;
+          d--;
+        }
+        if (d < 0) {
+          break;
+        }
+        offset.at(d)++;
+      }
+      return offsets;
+    }
+
+   private:
+    std::vector<Cell> cells_;
+    std::vector<Index> cell_begins_;
+    std::vector<Index> point_indices_;
+  };
 
  public:
   // Non-constexpr for the sake of Python bindings.
@@ -37,75 +132,26 @@ class VariogramCalculator {
   double angle_tolerance() const { return angle_tolerance_; }
 
   VariogramSet calculate(const Points& points, const VecX& values) const {
-    auto num_directions = directions_.rows();
-    auto num_points = points.rows();
-    auto lag_tolerance =
-        lag_tolerance_ == kAutomaticLagTolerance ? 0.5 * lag_distance_ : lag_tolerance_;
-    auto squared_cos_angle_tolerance = angle_tolerance_ == kAutomaticAngleTolerance
-                                           ? 0.0
-                                           : std::pow(std::cos(angle_tolerance_), 2);
-
-    std::vector<VariogramBuilder> builders;
-    for (Index k = 0; k < num_directions; k++) {
-      builders.emplace_back(lag_distance_, lag_tolerance, num_lags_, directions_.row(k));
-    }
-
-#pragma omp parallel
-    {
-      std::vector<VariogramBuilder> local_builders;
-      for (Index k = 0; k < num_directions; k++) {
-        local_builders.emplace_back(lag_distance_, lag_tolerance, num_lags_, directions_.row(k));
-      }
-
-      VecX squared_dots;
-
-#pragma omp for schedule(guided)
-      for (Index i = 0; i < num_points - 1; i++) {
-        auto point_i = points.row(i);
-        auto value_i = values(i);
-
-        for (Index j = i + 1; j < num_points; j++) {
-          auto point_j = points.row(j);
-          auto value_j = values(j);
-
-          // Do not normalize the direction to avoid division for performance.
-          Vector dir = point_j - point_i;
-          squared_dots = (dir * directions_.transpose()).array().square();
-
-          if (angle_tolerance_ == kAutomaticAngleTolerance) {
-            Index k{};
-            squared_dots.maxCoeff(&k);
-            local_builders.at(k).add_pair(point_i, point_j, value_i, value_j);
-          } else {
-            auto threshold = dir.squaredNorm() * squared_cos_angle_tolerance;
-            for (Index k = 0; k < num_directions; k++) {
-              if (squared_dots(k) >= threshold) {
-                local_builders.at(k).add_pair(point_i, point_j, value_i, value_j);
-              }
-            }
-          }
-        }
-      }
+    return accumulate(points, values).into_variogram_set(estimator_);
+  }
 
-#pragma omp critical
-      for (Index k = 0; k < num_directions; k++) {
-        builders.at(k).merge(local_builders.at(k));
-      }
-    }
+  // Returns the variograms by each of the estimators, computed in a single pass over the pairs.
+  std::vector<VariogramSet> calculate_multiple(
+      const Points& points, const VecX& values,
+      const std::vector<VariogramEstimator>& estimators) const {
+    auto builder = accumulate(points, values);
 
-    std::vector<Variogram> variograms;
-    for (auto& builder : builders) {
-      auto variogram = builder.into_variogram();
-      if (variogram.num_pairs() != 0) {
-        variograms.push_back(std::move(variogram));
-      }
+    std::vector<VariogramSet> variog_sets;
+    for (auto estimator : estimators) {
+      variog_sets.push_back(builder.into_variogram_set(estimator));
     }
-
-    return VariogramSet{std::move(variograms)};
+    return variog_sets;
   }
 
   const Vectors& directions() const { return directions_; }
 
+  VariogramEstimator estimator() const { return estimator_; }
+
   double lag_tolerance() const { return lag_tolerance_; }
 
   void set_angle_tolerance(double angle_tolerance) {
@@ -124,6 +170,8 @@ class VariogramCalculator {
     directions_ = directions.rowwise().normalized();
   }
 
+  void set_estimator(VariogramEstimator estimator) { estimator_ = estimator; }
+
   void set_lag_tolerance(double lag_tolerance) {
     if (lag_tolerance != kAutomaticLagTolerance && !(lag_tolerance > 0.0)) {
       throw std::invalid_argument("lag_tolerance must be positive");
@@ -133,11 +181,121 @@ class VariogramCalculator {
   }
 
  private:
+  // Adds all pairs of the points to the bins.
+  VariogramBuilder accumulate(const Points& points, const VecX& values) const {
+    auto num_directions = directions_.rows();
+    auto num_points = points.rows();
+    auto lag_tolerance =
+        lag_tolerance_ == kAutomaticLagTolerance ? 0.5 * lag_distance_ : lag_tolerance_;
+    auto squared_cos_angle_tolerance = angle_tolerance_ == kAutomaticAngleTolerance
+                                           ? 0.0
+                                           : std::pow(std::cos(angle_tolerance_), 2);
+
+    // Pairs farther apart than max_distance do not fall in any bin. The margin is added
+    // as the bins of each pair are determined by VariogramBuilder.
+    auto max_distance =
+        (1.0 + 1e-10) * (static_cast<double>(num_lags_ - 1) * lag_distance_ + lag_tolerance);
+    auto squared_max_distance = max_distance * max_distance;
+
+    // Only the pairs in the same or adjacent cells of the grid are examined.
+    CellGrid grid(points, max_distance);
+    auto num_cells = grid.num_cells();
+    auto neighbor_offsets = CellGrid::forward_neighbor_offsets();
+
+    Points sorted_points(num_points, kDim);
+    VecX sorted_values(num_points);
+    for (Index i = 0; i < num_points; i++) {
+      auto index = grid.point_indices().at(i);
+      sorted_points.row(i) = points.row(index);
+      sorted_values(i) = values(index);
+    }
+
+    std::vector<VariogramBuilder> builders;
+
+#pragma omp parallel
+    {
+      VariogramBuilder local_builder(lag_distance_, lag_tolerance, num_lags_, directions_);
+
+#pragma omp for schedule(guided)
+      for (Index c = 0; c < num_cells; c++) {
+        const auto& cell = grid.cell(c);
+
+        for (const auto& offset : neighbor_offsets) {
+          auto nc = c;
+          if (offset != Cell{}) {
+            Cell neigh_cell;
+            for (auto d = 0; d < kDim; d++) {
+              neigh_cell.at(d) = cell.at(d) + offset.at(d);
+            }
+            nc = grid.find_cell(neigh_cell);
+            if (nc < 0) {
+              continue;
+            }
+          }
+
+          for (auto i = grid.cell_begin(c); i < grid.cell_end(c); i++) {
+            Point point_i = sorted_points.row(i);
+            auto value_i = sorted_values(i);
+
+            for (auto j = nc == c ? i + 1 : grid.cell_begin(nc); j < grid.cell_end(nc); j++) {
+              // Do not normalize the direction to avoid division for performance.
+              Vector dir = sorted_points.row(j) - point_i;
+              auto squared_norm = dir.squaredNorm();
+              if (squared_norm > squared_max_distance) {
+                continue;
+              }
+
+              auto distance = std::sqrt(squared_norm);
+              auto increment = sorted_values(j) - value_i;
+
+              if (angle_tolerance_ == kAutomaticAngleTolerance) {
+                // Find the closest direction.
+                Index closest_k{};
+                auto max_squared_dot = 0.0;
+                for (Index k = 0; k < num_directions; k++) {
+                  auto dot = directions_.row(k).dot(dir);
+                  if (dot * dot > max_squared_dot) {
+                    closest_k = k;
+                    max_squared_dot = dot * dot;
+                  }
+                }
+                local_builder.add_pair(closest_k, distance, increment);
+              } else {
+                auto threshold = squared_norm * squared_cos_angle_tolerance;
+                for (Index k = 0; k < num_directions; k++) {
+                  auto dot = directions_.row(k).dot(dir);
+                  if (dot * dot >= threshold) {
+                    local_builder.add_pair(k, distance, increment);
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+
+#pragma omp critical
+      builders.push_back(std::move(local_builder));
+    }
+
+    // Merge the builders of the threads pairwise.
+    auto num_builders = builders.size();
+    for (std::size_t stride = 1; stride < num_builders; stride *= 2) {
+#pragma omp parallel for
+      for (std::size_t i = 0; i < num_builders - stride; i += 2 * stride) {
+        builders.at(i).merge(builders.at(i + stride));
+      }
+    }
+
+    return std::move(builders.front());
+  }
+
   double lag_distance_;
   Index num_lags_;
   double lag_tolerance_{kAutomaticLagTolerance};
   Vectors directions_{kIsotropicDirections};
   double angle_tolerance_{kAutomaticAngleTolerance};
+  VariogramEstimator estimator_{VariogramEstimator::kMatheron};
 };
 
 // Defining these constants here (inline) somehow leads to STATUS_HEAP_CORRUPTION on Windows.
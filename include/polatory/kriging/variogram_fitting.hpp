@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/kriging/variogram.hpp>
+#include <polatory/kriging/variogram_set.hpp>
 #include <polatory/kriging/weight_function.hpp>
 #include <polatory/model.hpp>
 #include <polatory/types.hpp>
@@ -24,30 +25,37 @@ void clamp_parameters(std::vector<double>& params, const Model<Dim>& model) {
   }
 }
 
+// Computes the residuals at all bins of all variograms, in the order of the variograms.
 template <int Dim>
-bool compute_residuals(const Model<Dim>& model, const Variogram<Dim>& variog,
+bool compute_residuals(const Model<Dim>& model, const VariogramSet<Dim>& variog_set,
                        const WeightFunction& weight_fn, double* residuals) {
+  std::vector<double> sills;
   for (const auto& rbf : model.rbfs()) {
     auto range = rbf.parameters().at(1);
     if (range == 0.0) {
       return false;
     }
+    sills.push_back(rbf.evaluate(geometry::Vector<Dim>::Zero()));
   }
 
-  const auto& dir = variog.direction();
-  auto num_bins = variog.num_bins();
-  for (Index i = 0; i < num_bins; i++) {
-    auto dist = variog.bin_distance().at(i);
-    auto gamma = variog.bin_gamma().at(i);
-    auto num_pairs = variog.bin_num_pairs().at(i);
+  auto num_rbfs = model.num_rbfs();
+  for (const auto& variog : variog_set.variograms()) {
+    const auto& dir = variog.direction();
+    auto num_bins = variog.num_bins();
+    for (Index i = 0; i < num_bins; i++) {
+      auto dist = variog.bin_distance().at(i);
+      auto gamma = variog.bin_gamma().at(i);
+      auto num_pairs = variog.bin_num_pairs().at(i);
 
-    auto model_gamma = model.nugget();
-    for (const auto& rbf : model.rbfs()) {
-      model_gamma += rbf.evaluate(geometry::Vector<Dim>::Zero()) - rbf.evaluate(dist * dir);
-    }
+      auto model_gamma = model.nugget();
+      for (Index k = 0; k < num_rbfs; k++) {
+        model_gamma += sills.at(k) - model.rbfs().at(k).evaluate(dist * dir);
+      }
 
-    auto weight = weight_fn(dist, model_gamma, num_pairs);
-    residuals[i] = weight * (gamma - model_gamma);
+      auto weight = weight_fn(dist, model_gamma, num_pairs);
+      residuals[i] = weight * (gamma - model_gamma);
+    }
+    residuals += num_bins;
   }
 
   return true;
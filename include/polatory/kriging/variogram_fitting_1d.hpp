@@ -19,7 +19,6 @@ template <>
 class VariogramFitting<1> {
   using Mat = Mat1;
   using Model = Model<1>;
-  using Variogram = Variogram<1>;
   using VariogramSet = VariogramSet<1>;
 
  public:
@@ -44,11 +43,18 @@ class VariogramFitting<1> {
       problem.SetParameterUpperBound(params_.data(), i, ubs.at(i));
     }
 
+    // All bins of all variograms are evaluated by a single residual block,
+    // so that the model is built once per evaluation.
+    Index num_residuals{};
     for (const auto& variog : variog_set.variograms()) {
+      num_residuals += variog.num_bins();
+    }
+
+    if (num_residuals > 0) {
       auto* cost_fn = new ceres::DynamicNumericDiffCostFunction(
-          new Residual(model_template_, variog, weight_fn));
+          new Residual(model_template_, variog_set, weight_fn));
       cost_fn->AddParameterBlock(num_params_);
-      cost_fn->SetNumResiduals(variog.num_bins());
+      cost_fn->SetNumResiduals(num_residuals);
       problem.AddResidualBlock(cost_fn, nullptr, params_.data());
     }
 
@@ -75,8 +81,9 @@ class VariogramFitting<1> {
 
  private:
   struct Residual {
-    Residual(const Model& model_template, const Variogram& variog, const WeightFunction& weight_fn)
-        : model_template_(model_template), variog_(variog), weight_fn_(weight_fn) {}
+    Residual(const Model& model_template, const VariogramSet& variog_set,
+             const WeightFunction& weight_fn)
+        : model_template_(model_template), variog_set_(variog_set), weight_fn_(weight_fn) {}
 
     bool operator()(const double* const* param_blocks, double* residuals) const {
       const auto* params = param_blocks[0];
@@ -87,12 +94,12 @@ class VariogramFitting<1> {
       internal::clamp_parameters(clamped_params, model);
       model.set_parameters(clamped_params);
 
-      return internal::compute_residuals(model, variog_, weight_fn_, residuals);
+      return internal::compute_residuals(model, variog_set_, weight_fn_, residuals);
     }
 
    private:
     const Model& model_template_;
-    const Variogram& variog_;
+    const VariogramSet& variog_set_;
     const WeightFunction& weight_fn_;
   };
 
@@ -21,18 +21,23 @@ template <>
 class VariogramFitting<2> {
   using Mat = Mat2;
   using Model = Model<2>;
-  using Variogram = Variogram<2>;
   using VariogramSet = VariogramSet<2>;
 
  public:
+  using Rotation = Eigen::Rotation2Dd;
+
+  // initial_rotation is the starting point of the rotation of the anisotropy.
   VariogramFitting(const VariogramSet& variog_set, const Model& model,
                    const WeightFunction& weight_fn = WeightFunction::kNumPairsOverDistanceSquared,
-                   bool fit_anisotropy = true)
+                   bool fit_anisotropy = true,
+                   const Rotation& initial_rotation = Rotation(std::numbers::pi *
+                                                               Mat1::Random()(0)))
       : model_template_(model),
         fit_anisotropy_(fit_anisotropy && variog_set.num_variograms() >= 2),
         num_params_(model.num_parameters()),
         num_rbfs_(model.num_rbfs()),
-        params_(model.parameters()) {
+        params_(model.parameters()),
+        r_(initial_rotation) {
     for (auto& rbf : model_template_.rbfs()) {
       rbf.set_anisotropy(Mat::Identity());
     }
@@ -59,15 +64,22 @@ class VariogramFitting<2> {
       }
     }
 
+    // All bins of all variograms are evaluated by a single residual block,
+    // so that the model is built once per evaluation.
+    Index num_residuals{};
     for (const auto& variog : variog_set.variograms()) {
+      num_residuals += variog.num_bins();
+    }
+
+    if (num_residuals > 0) {
       auto* cost_fn = new ceres::DynamicNumericDiffCostFunction(
-          new Residual(model_template_, variog, weight_fn, fit_anisotropy_));
+          new Residual(model_template_, variog_set, weight_fn, fit_anisotropy_));
       cost_fn->AddParameterBlock(num_params_);
       if (fit_anisotropy_) {
         cost_fn->AddParameterBlock(1);
         cost_fn->AddParameterBlock(num_rbfs_);
       }
-      cost_fn->SetNumResiduals(variog.num_bins());
+      cost_fn->SetNumResiduals(num_residuals);
       if (fit_anisotropy_) {
         problem.AddResidualBlock(cost_fn, nullptr, params_.data(), &r_.angle(), inv_minor_.data());
       } else {
@@ -111,10 +123,10 @@ class VariogramFitting<2> {
 
  private:
   struct Residual {
-    Residual(const Model& model_template, const Variogram& variog, const WeightFunction& weight_fn,
-             bool fit_anisotropy)
+    Residual(const Model& model_template, const VariogramSet& variog_set,
+             const WeightFunction& weight_fn, bool fit_anisotropy)
         : model_template_(model_template),
-          variog_(variog),
+          variog_set_(variog_set),
           weight_fn_(weight_fn),
           fit_anisotropy_(fit_anisotropy) {}
 
@@ -145,12 +157,12 @@ class VariogramFitting<2> {
         }
       }
 
-      return internal::compute_residuals(model, variog_, weight_fn_, residuals);
+      return internal::compute_residuals(model, variog_set_, weight_fn_, residuals);
     }
 
    private:
     const Model& model_template_;
-    const Variogram& variog_;
+    const VariogramSet& variog_set_;
     const WeightFunction& weight_fn_;
     bool fit_anisotropy_;
   };
@@ -160,7 +172,7 @@ class VariogramFitting<2> {
   Index num_params_;
   Index num_rbfs_;
   std::vector<double> params_;
-  Eigen::Rotation2Dd r_{std::numbers::pi * Mat1::Random()(0)};
+  Rotation r_;
   std::vector<double> inv_minor_;
   ceres::Solver::Summary summary_;
 };
@@ -1,10 +1,10 @@
 #pragma once
 
 #include <polatory/krylov/gmres.hpp>
+#include <polatory/krylov/krylov_basis.hpp>
 #include <polatory/krylov/linear_operator.hpp>
 #include <polatory/types.hpp>
 #include <stdexcept>
-#include <vector>
 
 namespace polatory::krylov {
 
@@ -16,13 +16,15 @@ class Fgmres : public Gmres {
     throw std::runtime_error("set_left_preconditioner is not supported");
   }
 
+  void setup() override;
+
   VecX solution_vector() const override;
 
  private:
   void add_preconditioned_krylov_basis(const VecX& z) override;
 
   // zs[i] := right_preconditioned(vs[i - 1]).
-  std::vector<VecX> zs_;
+  KrylovBasis zs_;
 };
 
 }  // namespace polatory::krylov
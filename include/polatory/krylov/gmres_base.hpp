@@ -1,8 +1,8 @@
 #pragma once
 
+#include <polatory/krylov/krylov_basis.hpp>
 #include <polatory/krylov/linear_operator.hpp>
 #include <polatory/types.hpp>
-#include <vector>
 
 namespace polatory::krylov {
 
@@ -31,6 +31,10 @@ class GmresBase {
 
   void set_initial_solution(const VecX& x0);
 
+  // Stores the Krylov basis vectors in memory-mapped temporary files.
+  // Must be called before setup().
+  void set_out_of_core(bool out_of_core);
+
   virtual void set_right_preconditioner(const LinearOperator& right_preconditioner);
 
   virtual void setup();
@@ -72,8 +76,11 @@ class GmresBase {
   // L2 norm of rhs.
   double rhs_norm_;
 
+  // Whether to store the Krylov basis vectors out of core.
+  bool out_of_core_{};
+
   // Orthonormal basis vectors for the Krylov subspace.
-  std::vector<VecX> vs_;
+  KrylovBasis vs_;
 
   // Upper triangular matrix of QR decomposition.
   MatX r_;
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <memory>
+#include <polatory/common/mapped_file.hpp>
+#include <polatory/types.hpp>
+#include <vector>
+
+namespace polatory::krylov {
+
+// Storage for the basis vectors of a Krylov subspace.
+// In the out-of-core mode, the vectors are stored in a memory-mapped temporary file
+// so that the OS can write them back and evict them from memory instead of swapping.
+class KrylovBasis {
+ public:
+  KrylovBasis();
+
+  KrylovBasis(Index dim, Index capacity, bool out_of_core);
+
+  ~KrylovBasis();
+
+  KrylovBasis(const KrylovBasis&) = delete;
+  KrylovBasis(KrylovBasis&&) noexcept;
+  KrylovBasis& operator=(const KrylovBasis&) = delete;
+  KrylovBasis& operator=(KrylovBasis&&) noexcept;
+
+  Eigen::Map<VecX> at(Index i);
+
+  Eigen::Map<const VecX> at(Index i) const;
+
+  void push_back(const VecX& v);
+
+  Index size() const;
+
+ private:
+  Index dim_{};
+  Index capacity_{};
+  Index size_{};
+  std::vector<VecX> vectors_;
+  std::unique_ptr<common::MappedFile> file_;
+};
+
+}  // namespace polatory::krylov
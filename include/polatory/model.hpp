@@ -20,6 +20,9 @@ namespace polatory {
 template <int Dim>
 class Interpolant;
 
+template <int Dim>
+class PartitionOfUnityInterpolant;
+
 template <int Dim>
 class Model {
   static constexpr int kDim = Dim;
@@ -174,6 +177,9 @@ class Model {
   // For deserialization of an Interpolant<Dim>.
   friend class Interpolant<Dim>;
 
+  // For deserialization of a PartitionOfUnityInterpolant<Dim>.
+  friend class PartitionOfUnityInterpolant<Dim>;
+
   // For deserialization.
   Model() = default;
 
@@ -0,0 +1,613 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <polatory/common/io.hpp>
+#include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/interpolant.hpp>
+#include <polatory/interpolation/evaluator.hpp>
+#include <polatory/model.hpp>
+#include <polatory/types.hpp>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace polatory {
+
+// An interpolant that consists of local interpolants fitted independently on overlapping patches,
+// which are blended with a smooth partition of unity.
+// The patches are obtained by recursively bisecting the points at the median, so that each patch
+// (before extension by the overlap) contains at most patch_size points.
+// This is much cheaper than fitting a global interpolant if the covariance function is short-range.
+// Note that if the model has a polynomial part, each local interpolant has its own trend.
+template <int Dim>
+class PartitionOfUnityInterpolant {
+  static constexpr int kDim = Dim;
+  static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+  using Bbox = geometry::Bbox<kDim>;
+  using Evaluator = interpolation::Evaluator<kDim>;
+  using Interpolant = Interpolant<kDim>;
+  using Model = Model<kDim>;
+  using Point = geometry::Point<kDim>;
+  using Points = geometry::Points<kDim>;
+  using Vector = geometry::Vector<kDim>;
+  using Vectors = geometry::Vectors<kDim>;
+
+ public:
+  static constexpr Index kDefaultPatchSize = 4096;
+  static constexpr double kDefaultOverlap = 0.25;
+
+  // overlap: The amount by which each patch is extended on each side,
+  // relative to the longest side of the patch.
+  explicit PartitionOfUnityInterpolant(const Model& model, Index patch_size = kDefaultPatchSize,
+                                       double overlap = kDefaultOverlap)
+      : model_(model), patch_size_(patch_size), overlap_(overlap) {
+    if (patch_size <= 0) {
+      throw std::invalid_argument("patch_size must be positive");
+    }
+
+    if (!(overlap > 0.0)) {
+      throw std::invalid_argument("overlap must be positive");
+    }
+  }
+
+  const Bbox& bbox() const {
+    throw_if_not_fitted();
+
+    return bbox_;
+  }
+
+  VecX evaluate(const Points& points, double accuracy = kInfinity) const {
+    return evaluate(points, Points(0, kDim), accuracy, kInfinity);
+  }
+
+  VecX evaluate(const Points& points, const Points& grad_points, double accuracy = kInfinity,
+                double grad_accuracy = kInfinity) const {
+    throw_if_not_fitted();
+
+    if (!(accuracy > 0.0)) {
+      throw std::invalid_argument("accuracy must be positive");
+    }
+
+    if (!(grad_accuracy > 0.0)) {
+      throw std::invalid_argument("grad_accuracy must be positive");
+    }
+
+    auto mu = points.rows();
+    auto sigma = grad_points.rows();
+    auto n_patches = num_patches();
+
+    // Bucket the points by the patches that cover them.
+    // Indices >= mu refer to grad points.
+    std::vector<Index> offsets;
+    std::vector<Index> targets;
+    {
+      std::vector<std::pair<Index, Index>> pairs;
+
+#pragma omp parallel
+      {
+        std::vector<std::pair<Index, Index>> local_pairs;
+        std::vector<Index> patches;
+
+#pragma omp for schedule(static)
+        for (Index i = 0; i < mu + sigma; i++) {
+          Point p = i < mu ? points.row(i) : grad_points.row(i - mu);
+          find_patches(p, patches);
+          for (auto patch : patches) {
+            local_pairs.emplace_back(patch, i);
+          }
+        }
+
+#pragma omp critical
+        pairs.insert(pairs.end(), local_pairs.begin(), local_pairs.end());
+      }
+
+      offsets.resize(n_patches + 1);
+      for (const auto& [patch, i] : pairs) {
+        offsets.at(patch + 1)++;
+      }
+      for (Index patch = 0; patch < n_patches; patch++) {
+        offsets.at(patch + 1) += offsets.at(patch);
+      }
+
+      auto next = offsets;
+      targets.resize(pairs.size());
+      for (const auto& [patch, i] : pairs) {
+        targets.at(next.at(patch)++) = i;
+      }
+    }
+
+    // Evaluate the local interpolants and their weights.
+    auto n_entries = static_cast<Index>(targets.size());
+    VecX weight(n_entries);
+    VecX weighted_value(n_entries);
+    Vectors weight_grad = Vectors::Zero(n_entries, kDim);
+    Vectors weighted_grad = Vectors::Zero(n_entries, kDim);
+
+    std::exception_ptr exception;
+
+#pragma omp parallel for schedule(dynamic)
+    for (Index patch = 0; patch < n_patches; patch++) {
+      auto begin = offsets.at(patch);
+      auto end = offsets.at(patch + 1);
+      if (begin == end) {
+        continue;
+      }
+
+      try {
+        // Sort the bucket so that the points precede the grad points.
+        std::sort(targets.begin() + begin, targets.begin() + end);
+        auto grad_begin = static_cast<Index>(
+            std::distance(targets.begin(),
+                          std::lower_bound(targets.begin() + begin, targets.begin() + end, mu)));
+
+        Points trg_points(end - begin, kDim);
+        for (auto k = begin; k < end; k++) {
+          auto i = targets.at(k);
+          trg_points.row(k - begin) = i < mu ? points.row(i) : grad_points.row(i - mu);
+        }
+        Points trg_grad_points = trg_points.bottomRows(end - grad_begin);
+
+        const auto& inter = interpolants_.at(patch);
+        Evaluator eval(model_, inter.centers(), inter.grad_centers(),
+                       inter.bbox().convex_hull(Bbox::from_points(trg_points)), accuracy,
+                       grad_accuracy);
+        eval.set_weights(inter.weights());
+        VecX values = eval.evaluate(trg_points, trg_grad_points);
+
+        for (auto k = begin; k < end; k++) {
+          Point p = trg_points.row(k - begin);
+          auto w = patch_weight(patch, p);
+          weight(k) = w;
+          weighted_value(k) = w * values(k - begin);
+
+          if (k >= grad_begin) {
+            auto g = values.segment<kDim>(end - begin + kDim * (k - grad_begin)).transpose();
+            Vector grad_w = patch_weight_gradient(patch, p);
+            weight_grad.row(k) = grad_w;
+            weighted_grad.row(k) = grad_w * values(k - begin) + w * g;
+          }
+        }
+      } catch (...) {
+#pragma omp critical
+        if (!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+
+    // Blend the local values.
+    VecX sum_weight = VecX::Zero(mu + sigma);
+    VecX sum_weighted_value = VecX::Zero(mu + sigma);
+    Vectors sum_weight_grad = Vectors::Zero(sigma, kDim);
+    Vectors sum_weighted_grad = Vectors::Zero(sigma, kDim);
+    for (Index k = 0; k < n_entries; k++) {
+      auto i = targets.at(k);
+      sum_weight(i) += weight(k);
+      sum_weighted_value(i) += weighted_value(k);
+      if (i >= mu) {
+        sum_weight_grad.row(i - mu) += weight_grad.row(k);
+        sum_weighted_grad.row(i - mu) += weighted_grad.row(k);
+      }
+    }
+
+    VecX y(mu + kDim * sigma);
+    y.head(mu) = sum_weighted_value.head(mu).cwiseQuotient(sum_weight.head(mu));
+    for (Index i = 0; i < sigma; i++) {
+      auto w = sum_weight(mu + i);
+      auto value = sum_weighted_value(mu + i) / w;
+      y.segment<kDim>(mu + kDim * i) =
+          ((sum_weighted_grad.row(i) - value * sum_weight_grad.row(i)) / w).transpose();
+    }
+
+    return y;
+  }
+
+  void fit(const Points& points, const VecX& values, double tolerance, int max_iter = 100,
+           double accuracy = kInfinity) {
+    fit(points, Points(0, kDim), values, tolerance, kInfinity, max_iter, accuracy, kInfinity);
+  }
+
+  void fit(const Points& points, const Points& grad_points, const VecX& values, double tolerance,
+           double grad_tolerance, int max_iter = 100, double accuracy = kInfinity,
+           double grad_accuracy = kInfinity) {
+    auto mu = points.rows();
+    auto sigma = grad_points.rows();
+
+    if (mu + sigma == 0) {
+      throw std::invalid_argument("points must not be empty");
+    }
+
+    auto n_rhs = mu + kDim * sigma;
+    if (values.rows() != n_rhs) {
+      throw std::invalid_argument(std::format("values.rows() must be equal to {}", n_rhs));
+    }
+
+    clear();
+
+    bbox_ = Bbox::from_points(points).convex_hull(Bbox::from_points(grad_points));
+
+    // Indices >= mu refer to grad points.
+    std::vector<Index> idcs(mu + sigma);
+    std::iota(idcs.begin(), idcs.end(), 0);
+    std::vector<Bbox> node_cells;
+    std::vector<std::pair<Index, Index>> leaf_ranges;
+    divide(points, grad_points, idcs, 0, mu + sigma, bbox_, node_cells, leaf_ranges);
+
+    auto l = model_.poly_basis_size();
+    auto n_patches = num_patches();
+
+    interpolants_.reserve(n_patches);
+    for (Index patch = 0; patch < n_patches; patch++) {
+      interpolants_.emplace_back(model_);
+    }
+
+    std::exception_ptr exception;
+
+    // Each local fit runs on a single thread, as nested parallelism is disabled by default.
+#pragma omp parallel for schedule(dynamic)
+    for (Index patch = 0; patch < n_patches; patch++) {
+      try {
+        // Enlarge the region from which the points are taken
+        // until it contains enough points to determine the polynomial part.
+        std::vector<Index> local_idcs;
+        Index local_mu{};
+        for (auto scale = 1.0;; scale *= 2.0) {
+          auto region = patch_region(patch, scale);
+          local_idcs.clear();
+          collect(points, grad_points, idcs, region, node_cells, leaf_ranges, local_idcs);
+          std::sort(local_idcs.begin(), local_idcs.end());
+
+          local_mu = static_cast<Index>(std::distance(
+              local_idcs.begin(), std::lower_bound(local_idcs.begin(), local_idcs.end(), mu)));
+          if (local_mu >= l || (region.contains(bbox_.min()) && region.contains(bbox_.max()))) {
+            break;
+          }
+        }
+
+        auto local_sigma = static_cast<Index>(local_idcs.size()) - local_mu;
+
+        Points local_points(local_mu, kDim);
+        Points local_grad_points(local_sigma, kDim);
+        VecX local_values(local_mu + kDim * local_sigma);
+        for (Index k = 0; k < local_mu; k++) {
+          auto i = local_idcs.at(k);
+          local_points.row(k) = points.row(i);
+          local_values(k) = values(i);
+        }
+        for (Index k = 0; k < local_sigma; k++) {
+          auto i = local_idcs.at(local_mu + k) - mu;
+          local_grad_points.row(k) = grad_points.row(i);
+          local_values.segment<kDim>(local_mu + kDim * k) = values.segment<kDim>(mu + kDim * i);
+        }
+
+        interpolants_.at(patch).fit(local_points, local_grad_points, local_values, tolerance,
+                                    grad_tolerance, max_iter, accuracy, grad_accuracy);
+      } catch (...) {
+#pragma omp critical
+        if (!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+
+    if (exception) {
+      clear();
+      std::rethrow_exception(exception);
+    }
+
+    fitted_ = true;
+  }
+
+  const Model& model() const { return model_; }
+
+  Index num_patches() const { return static_cast<Index>(cells_.size()); }
+
+  double overlap() const { return overlap_; }
+
+  Index patch_size() const { return patch_size_; }
+
+  POLATORY_IMPLEMENT_LOAD_SAVE(PartitionOfUnityInterpolant);
+
+ private:
+  POLATORY_FRIEND_READ_WRITE;
+
+  struct Node {
+    // The union of the supports of the weight functions of the patches in the subtree.
+    Bbox reach;
+    Index left{-1};
+    Index right{-1};
+    Index patch{-1};
+  };
+
+  // For deserialization.
+  PartitionOfUnityInterpolant() = default;
+
+  void clear() {
+    fitted_ = false;
+    bbox_ = Bbox();
+    cells_.clear();
+    nodes_.clear();
+    interpolants_.clear();
+  }
+
+  void collect(const Points& points, const Points& grad_points, const std::vector<Index>& idcs,
+               const Bbox& region, const std::vector<Bbox>& node_cells,
+               const std::vector<std::pair<Index, Index>>& leaf_ranges,
+               std::vector<Index>& result) const {
+    auto mu = points.rows();
+
+    std::vector<Index> stack{0};
+    while (!stack.empty()) {
+      auto node = stack.back();
+      stack.pop_back();
+
+      const auto& cell = node_cells.at(node);
+      if ((cell.max().array() < region.min().array()).any() ||
+          (cell.min().array() > region.max().array()).any()) {
+        continue;
+      }
+
+      const auto& n = nodes_.at(node);
+      if (n.patch < 0) {
+        stack.push_back(n.left);
+        stack.push_back(n.right);
+        continue;
+      }
+
+      auto [begin, end] = leaf_ranges.at(n.patch);
+      for (auto k = begin; k < end; k++) {
+        auto i = idcs.at(k);
+        Point p = i < mu ? points.row(i) : grad_points.row(i - mu);
+        if (region.contains(p)) {
+          result.push_back(i);
+        }
+      }
+    }
+  }
+
+  Index divide(const Points& points, const Points& grad_points, std::vector<Index>& idcs,
+               Index begin, Index end, const Bbox& cell, std::vector<Bbox>& node_cells,
+               std::vector<std::pair<Index, Index>>& leaf_ranges) {
+    auto node = static_cast<Index>(nodes_.size());
+    nodes_.emplace_back();
+    node_cells.push_back(cell);
+
+    if (end - begin <= patch_size_) {
+      auto patch = num_patches();
+      cells_.push_back(cell);
+      leaf_ranges.emplace_back(begin, end);
+      nodes_.at(node).patch = patch;
+      nodes_.at(node).reach = patch_support(patch);
+      return node;
+    }
+
+    auto mu = points.rows();
+    auto coord = [&](Index i, int axis) {
+      return i < mu ? points(i, axis) : grad_points(i - mu, axis);
+    };
+
+    int axis{};
+    cell.width().maxCoeff(&axis);
+    auto mid = begin + (end - begin) / 2;
+    std::nth_element(idcs.begin() + begin, idcs.begin() + mid, idcs.begin() + end,
+                     [&](Index i, Index j) { return coord(i, axis) < coord(j, axis); });
+    auto split = coord(idcs.at(mid), axis);
+
+    Point left_max = cell.max();
+    left_max(axis) = split;
+    Point right_min = cell.min();
+    right_min(axis) = split;
+
+    auto left = divide(points, grad_points, idcs, begin, mid, Bbox(cell.min(), left_max),
+                       node_cells, leaf_ranges);
+    auto right = divide(points, grad_points, idcs, mid, end, Bbox(right_min, cell.max()),
+                        node_cells, leaf_ranges);
+
+    auto& n = nodes_.at(node);
+    n.left = left;
+    n.right = right;
+    n.reach = nodes_.at(left).reach.convex_hull(nodes_.at(right).reach);
+    return node;
+  }
+
+  void find_patches(const Point& p, std::vector<Index>& patches) const {
+    patches.clear();
+
+    std::vector<Index> stack{0};
+    while (!stack.empty()) {
+      auto node = stack.back();
+      stack.pop_back();
+
+      const auto& n = nodes_.at(node);
+      if (!n.reach.contains(p)) {
+        continue;
+      }
+
+      if (n.patch < 0) {
+        stack.push_back(n.left);
+        stack.push_back(n.right);
+      } else if (patch_weight(n.patch, p) > 0.0) {
+        patches.push_back(n.patch);
+      }
+    }
+  }
+
+  Vector half_width(Index patch) const {
+    Vector width = cells_.at(patch).width();
+    Vector r = width / 2.0 + Vector::Constant(overlap_ * width.maxCoeff());
+    return r.cwiseMax(std::numeric_limits<double>::min());
+  }
+
+  // Returns the region from which the points for fitting the local interpolant are taken.
+  Bbox patch_region(Index patch, double scale) const {
+    Point center = cells_.at(patch).center();
+    Vector r = scale * half_width(patch);
+    return {(center - r).cwiseMax(bbox_.min()), (center + r).cwiseMin(bbox_.max())};
+  }
+
+  // Returns the support of the weight function.
+  // A patch on the boundary of the root bbox extends infinitely outward,
+  // so that the evaluation points outside the bbox are also covered.
+  Bbox patch_support(Index patch) const {
+    const auto& cell = cells_.at(patch);
+    Point center = cell.center();
+    Vector r = half_width(patch);
+    Point min = center - r;
+    Point max = center + r;
+    for (auto i = 0; i < kDim; i++) {
+      if (cell.min()(i) == bbox_.min()(i)) {
+        min(i) = -kInfinity;
+      }
+      if (cell.max()(i) == bbox_.max()(i)) {
+        max(i) = kInfinity;
+      }
+    }
+    return {min, max};
+  }
+
+  // Returns the normalized coordinates of p within the support of the weight function.
+  Vector patch_coordinates(Index patch, const Point& p) const {
+    const auto& cell = cells_.at(patch);
+    Vector t = (p - cell.center()).cwiseQuotient(half_width(patch));
+    for (auto i = 0; i < kDim; i++) {
+      if ((t(i) < 0.0 && cell.min()(i) == bbox_.min()(i)) ||
+          (t(i) > 0.0 && cell.max()(i) == bbox_.max()(i))) {
+        t(i) = 0.0;
+      }
+    }
+    return t;
+  }
+
+  double patch_weight(Index patch, const Point& p) const {
+    Vector t = patch_coordinates(patch, p);
+
+    auto w = 1.0;
+    for (auto i = 0; i < kDim; i++) {
+      w *= wendland(t(i));
+    }
+    return w;
+  }
+
+  Vector patch_weight_gradient(Index patch, const Point& p) const {
+    Vector t = patch_coordinates(patch, p);
+    Vector r = half_width(patch);
+
+    Vector grad;
+    for (auto i = 0; i < kDim; i++) {
+      grad(i) = wendland_derivative(t(i)) / r(i);
+      for (auto j = 0; j < kDim; j++) {
+        if (j != i) {
+          grad(i) *= wendland(t(j));
+        }
+      }
+    }
+    return grad;
+  }
+
+  void throw_if_not_fitted() const {
+    if (!fitted_) {
+      throw std::runtime_error("interpolant has not been fitted");
+    }
+  }
+
+  // Wendland's C2 function.
+  static double wendland(double t) {
+    auto a = std::abs(t);
+    if (a >= 1.0) {
+      return 0.0;
+    }
+    return std::pow(1.0 - a, 4.0) * (4.0 * a + 1.0);
+  }
+
+  static double wendland_derivative(double t) {
+    auto a = std::abs(t);
+    if (a >= 1.0) {
+      return 0.0;
+    }
+    return -20.0 * t * std::pow(1.0 - a, 3.0);
+  }
+
+  Model model_;
+  Index patch_size_{};
+  double overlap_{};
+  bool fitted_{};
+  Bbox bbox_;
+  std::vector<Bbox> cells_;
+  std::vector<Node> nodes_;
+  std::vector<Interpolant> interpolants_;
+};
+
+}  // namespace polatory
+
+namespace polatory::common {
+
+template <int Dim>
+struct Read<PartitionOfUnityInterpolant<Dim>> {
+  void operator()(std::istream& is, PartitionOfUnityInterpolant<Dim>& t) {
+    read(is, t.model_);
+    read(is, t.patch_size_);
+    read(is, t.overlap_);
+    read(is, t.fitted_);
+    read(is, t.bbox_);
+    read(is, t.cells_);
+
+    std::size_t n_nodes{};
+    read(is, n_nodes);
+    t.nodes_.resize(n_nodes);
+    for (auto& node : t.nodes_) {
+      read(is, node.reach);
+      read(is, node.left);
+      read(is, node.right);
+      read(is, node.patch);
+    }
+
+    std::size_t n_patches{};
+    read(is, n_patches);
+    t.interpolants_.clear();
+    t.interpolants_.reserve(n_patches);
+    for (std::size_t i = 0; i < n_patches; i++) {
+      Interpolant<Dim> interpolant(t.model_);
+      read(is, interpolant);
+      t.interpolants_.push_back(std::move(interpolant));
+    }
+  }
+};
+
+template <int Dim>
+struct Write<PartitionOfUnityInterpolant<Dim>> {
+  void operator()(std::ostream& os, const PartitionOfUnityInterpolant<Dim>& t) {
+    write(os, t.model_);
+    write(os, t.patch_size_);
+    write(os, t.overlap_);
+    write(os, t.fitted_);
+    write(os, t.bbox_);
+    write(os, t.cells_);
+
+    write(os, t.nodes_.size());
+    for (const auto& node : t.nodes_) {
+      write(os, node.reach);
+      write(os, node.left);
+      write(os, node.right);
+      write(os, node.patch);
+    }
+
+    write(os, t.interpolants_.size());
+    for (const auto& interpolant : t.interpolants_) {
+      write(os, interpolant);
+    }
+  }
+};
+
+}  // namespace polatory::common
@@ -1,25 +1,207 @@
 #pragma once
 
 #include <Eigen/Core>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
 #include <numeric>
 #include <polatory/geometry/point3d.hpp>
-#include <polatory/point_cloud/kdtree.hpp>
 #include <polatory/types.hpp>
 #include <stdexcept>
 #include <tuple>
-#include <unordered_set>
 #include <utility>
 #include <vector>
 
 namespace polatory::point_cloud {
 
+// Filters points so that no two of the filtered points are within a given distance.
+// The points are visited in the given order, and each point is kept unless it is within
+// the distance from a point that has been kept before.
+// The points are bucketed into a hashed uniform grid, and the points are decided in parallel
+// chunk by chunk in the order: a point is decided once all the preceding points within
+// the distance have been decided, and the undecided points are revisited in the next round.
+// Once a round decides only a small fraction of the points, the rest are decided sequentially.
+// The result is that of the sequential visit, regardless of the number of threads.
 template <int Dim>
 class DistanceFilter {
   using Point = geometry::Point<Dim>;
   using Points = geometry::Points<Dim>;
 
+  enum State : std::uint8_t { kUndecided, kKept, kRemoved };
+
+  // A uniform grid whose cells are indexed by an open-addressing hash table
+  // keyed by the cell coordinates packed into a 64-bit integer.
+  // The points in each cell are stored contiguously in ascending order of their indices.
+  class Grid {
+    static constexpr int kCoordinateBits = std::min(63 / Dim, 32);
+    static constexpr std::uint64_t kEmptyKey = ~std::uint64_t{0};
+
+    struct Slot {
+      std::uint64_t key{kEmptyKey};
+      Index cell{};
+    };
+
+   public:
+    Grid(const Points& points, double cell_size) {
+      auto n_points = points.rows();
+      if (n_points == 0) {
+        return;
+      }
+
+      // Cells larger than cell_size are used if necessary to fit the coordinates in the keys.
+      // The coordinates are biased by one so that the adjacent cells are representable.
+      min_ = points.colwise().minCoeff();
+      Point max = points.colwise().maxCoeff();
+      auto max_cells = static_cast<double>((std::uint64_t{1} << kCoordinateBits) - 3);
+      cell_size_ = std::max(cell_size, (max - min_).maxCoeff() / max_cells);
+      if (!(cell_size_ > 0.0)) {
+        cell_size_ = 1.0;
+      }
+
+      keys_.resize(n_points);
+#pragma omp parallel for schedule(static)
+      for (Index i = 0; i < n_points; i++) {
+        std::uint64_t key{};
+        for (auto d = 0; d < Dim; d++) {
+          auto c = static_cast<std::uint64_t>((points(i, d) - min_(d)) / cell_size_) + 1;
+          key |= c << (kCoordinateBits * d);
+        }
+        keys_.at(i) = key;
+      }
+
+      std::vector<Index> point_cells(n_points);
+      for (Index i = 0; i < n_points; i++) {
+        auto c = insert_cell(keys_.at(i));
+        if (c == static_cast<Index>(cell_begins_.size())) {
+          cell_begins_.push_back(0);
+        }
+        cell_begins_.at(c)++;
+        point_cells.at(i) = c;
+      }
+
+      // Convert the counts into the offsets.
+      Index offset{};
+      for (auto& begin : cell_begins_) {
+        offset += std::exchange(begin, offset);
+      }
+      cell_begins_.push_back(n_points);
+
+      std::vector<Index> ends(cell_begins_.begin(), cell_begins_.end() - 1);
+      point_indices_.resize(n_points);
+      sorted_points_.resize(n_points, Dim);
+      for (Index i = 0; i < n_points; i++) {
+        auto j = ends.at(point_cells.at(i))++;
+        point_indices_.at(j) = i;
+        sorted_points_.row(j) = points.row(i);
+      }
+    }
+
+    Index cell_begin(Index c) const { return cell_begins_[c]; }
+
+    Index cell_end(Index c) const { return cell_begins_[c + 1]; }
+
+    // Returns the index of the cell, or -1 if it does not contain any points.
+    Index find_cell(std::uint64_t key) const {
+      auto mask = slots_.size() - 1;
+      for (auto i = home_slot(key);; i = (i + 1) & mask) {
+        const auto& slot = slots_[i];
+        if (slot.key == key) {
+          return slot.cell;
+        }
+        if (slot.key == kEmptyKey) {
+          return -1;
+        }
+      }
+    }
+
+    // Computes the keys of the cells that can contain points within the distance
+    // from the i-th point p, including its own cell.
+    void neighbor_keys(Index i, const Point& p, double distance,
+                       std::vector<std::uint64_t>& keys) const {
+      // Allow for the rounding errors in the cell coordinates.
+      auto margin = 1e-5 * cell_size_;
+
+      keys.clear();
+      keys.push_back(keys_[i]);
+      for (auto d = 0; d < Dim; d++) {
+        auto t = (p(d) - min_(d)) / cell_size_;
+        auto lower = (t - std::floor(t)) * cell_size_ <= distance + margin;
+        auto upper = (std::floor(t) + 1.0 - t) * cell_size_ <= distance + margin;
+        auto unit = std::uint64_t{1} << (kCoordinateBits * d);
+
+        auto n_keys = keys.size();
+        for (std::size_t k = 0; k < n_keys; k++) {
+          if (lower) {
+            keys.push_back(keys.at(k) - unit);
+          }
+          if (upper) {
+            keys.push_back(keys.at(k) + unit);
+          }
+        }
+      }
+    }
+
+    // Returns the index of the point at the position in the sorted order.
+    Index point_index(Index j) const { return point_indices_[j]; }
+
+    const Points& sorted_points() const { return sorted_points_; }
+
+   private:
+    // Fibonacci hashing.
+    std::size_t home_slot(std::uint64_t key) const {
+      return static_cast<std::size_t>((key * 0x9e3779b97f4a7c15) >> shift_);
+    }
+
+    Index insert_cell(std::uint64_t key) {
+      if (2 * (num_cells_ + 1) > static_cast<Index>(slots_.size())) {
+        rehash(std::max(std::size_t{1024}, 2 * slots_.size()));
+      }
+
+      auto mask = slots_.size() - 1;
+      for (auto i = home_slot(key);; i = (i + 1) & mask) {
+        auto& slot = slots_[i];
+        if (slot.key == key) {
+          return slot.cell;
+        }
+        if (slot.key == kEmptyKey) {
+          slot = {key, num_cells_};
+          return num_cells_++;
+        }
+      }
+    }
+
+    void rehash(std::size_t capacity) {
+      std::vector<Slot> old_slots(capacity);
+      std::swap(slots_, old_slots);
+      shift_ = 64 - std::countr_zero(capacity);
+
+      auto mask = capacity - 1;
+      for (const auto& slot : old_slots) {
+        if (slot.key == kEmptyKey) {
+          continue;
+        }
+        auto i = home_slot(slot.key);
+        while (slots_[i].key != kEmptyKey) {
+          i = (i + 1) & mask;
+        }
+        slots_[i] = slot;
+      }
+    }
+
+    Point min_;
+    double cell_size_{};
+    std::vector<std::uint64_t> keys_;
+    Index num_cells_{};
+    std::vector<Index> cell_begins_;
+    std::vector<Slot> slots_;
+    int shift_{};
+    std::vector<Index> point_indices_;
+    Points sorted_points_;
+  };
+
  public:
-  explicit DistanceFilter(const Points& points) : points_(points), tree_(points) {}
+  explicit DistanceFilter(const Points& points) : points_(points) {}
 
   DistanceFilter& filter(double distance) {
     return filter(distance, trivial_indices(points_.rows()));
@@ -30,28 +212,21 @@ class DistanceFilter {
       throw std::invalid_argument("distance must be non-negative");
     }
 
-    std::unordered_set<Index> indices_to_remove;
-
-    std::vector<Index> nn_indices;
-    std::vector<double> nn_distances;
+    // The points are ranked by their first occurrences in indices.
+    std::vector<Index> ranks(points_.rows(), -1);
+    std::vector<Index> ranked_indices;
     for (auto i : indices) {
-      if (indices_to_remove.contains(i)) {
-        continue;
-      }
-
-      auto p = points_.row(i);
-      tree_.radius_search(p, distance, nn_indices, nn_distances);
-
-      for (auto j : nn_indices) {
-        if (j != i) {
-          indices_to_remove.insert(j);
-        }
+      if (ranks.at(i) < 0) {
+        ranks.at(i) = static_cast<Index>(ranked_indices.size());
+        ranked_indices.push_back(i);
       }
     }
 
+    auto states = greedy_filter(points_(ranked_indices, Eigen::all), distance);
+
     filtered_indices_.clear();
     for (auto i : indices) {
-      if (!indices_to_remove.contains(i)) {
+      if (states.at(ranks.at(i)) == kKept) {
         filtered_indices_.push_back(i);
       }
     }
@@ -91,6 +266,125 @@ class DistanceFilter {
     }
   }
 
+  // Returns the states of the points, which are visited in order.
+  static std::vector<std::uint8_t> greedy_filter(const Points& points, double distance) {
+    static constexpr Index kChunkSize = 4096;
+    // A round must decide at least this fraction of the undecided points, otherwise
+    // the rest are decided by a sequential sweep. This happens when the points are
+    // spatially ordered, in which case each chunk waits for the preceding one.
+    static constexpr double kMinDecidedFraction = 0.25;
+
+    auto n_points = points.rows();
+    // Cells twice as large as the distance reduce the number of cells to look up,
+    // as only the adjacent cells within the distance from a point are looked up.
+    Grid grid(points, 2.0 * distance);
+    auto distance_sq = distance * distance;
+
+    std::vector<std::uint8_t> states(n_points, kUndecided);
+
+    // Returns kUndecided if the state depends on the points that have not been decided yet.
+    auto decide = [&](Index i, std::vector<std::uint64_t>& neighbor_keys) {
+      auto result = kKept;
+      Point p = points.row(i);
+      grid.neighbor_keys(i, p, distance, neighbor_keys);
+      for (auto key : neighbor_keys) {
+        auto c = grid.find_cell(key);
+        if (c < 0) {
+          continue;
+        }
+
+        for (auto j = grid.cell_begin(c); j < grid.cell_end(c); j++) {
+          auto other = grid.point_index(j);
+          if (other >= i) {
+            break;
+          }
+
+          if ((grid.sorted_points().row(j) - p).squaredNorm() > distance_sq) {
+            continue;
+          }
+
+          // The states of the points in the other chunks can be updated concurrently.
+          std::uint8_t other_state{};
+#pragma omp atomic read
+          other_state = states.at(other);
+
+          if (other_state == kKept) {
+            return kRemoved;
+          }
+          if (other_state == kUndecided) {
+            result = kUndecided;
+          }
+        }
+      }
+      return result;
+    };
+
+    auto n_chunks = (n_points + kChunkSize - 1) / kChunkSize;
+    std::vector<Index> pending_chunks(n_chunks);
+    std::iota(pending_chunks.begin(), pending_chunks.end(), Index{0});
+    auto n_undecided = n_points;
+
+    while (!pending_chunks.empty()) {
+      auto n_pending_chunks = static_cast<Index>(pending_chunks.size());
+
+#pragma omp parallel
+      {
+        std::vector<std::uint64_t> neighbor_keys;
+
+#pragma omp for schedule(dynamic)
+        for (Index k = 0; k < n_pending_chunks; k++) {
+          auto begin = pending_chunks.at(k) * kChunkSize;
+          auto end = std::min(begin + kChunkSize, n_points);
+
+          for (auto i = begin; i < end; i++) {
+            if (states.at(i) != kUndecided) {
+              continue;
+            }
+
+            auto state = decide(i, neighbor_keys);
+
+#pragma omp atomic write
+            states.at(i) = state;
+          }
+        }
+      }
+
+      std::vector<Index> new_pending_chunks;
+      Index new_n_undecided{};
+      for (auto chunk : pending_chunks) {
+        auto begin = chunk * kChunkSize;
+        auto end = std::min(begin + kChunkSize, n_points);
+        auto n = std::count(states.begin() + begin, states.begin() + end, kUndecided);
+        if (n > 0) {
+          new_pending_chunks.push_back(chunk);
+          new_n_undecided += n;
+        }
+      }
+      pending_chunks = std::move(new_pending_chunks);
+
+      auto n_decided = n_undecided - new_n_undecided;
+      auto few_decided = static_cast<double>(n_decided) <
+                         kMinDecidedFraction * static_cast<double>(n_undecided);
+      n_undecided = new_n_undecided;
+      if (n_undecided > 0 && few_decided) {
+        // All the preceding points have been decided when a point is visited in order.
+        std::vector<std::uint64_t> neighbor_keys;
+        for (auto chunk : pending_chunks) {
+          auto begin = chunk * kChunkSize;
+          auto end = std::min(begin + kChunkSize, n_points);
+          for (auto i = begin; i < end; i++) {
+            if (states.at(i) == kUndecided) {
+              states.at(i) = decide(i, neighbor_keys);
+            }
+          }
+        }
+        break;
+      }
+    }
+
+    return states;
+  }
+
   static std::vector<Index> trivial_indices(Index n_points) {
     std::vector<Index> indices(n_points);
     std::iota(indices.begin(), indices.end(), Index{0});
@@ -98,7 +392,6 @@ class DistanceFilter {
   }
 
   const Points& points_;
-  const KdTree<Dim> tree_;
   bool filtered_{};
   std::vector<Index> filtered_indices_;
 };
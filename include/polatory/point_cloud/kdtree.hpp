@@ -22,12 +22,24 @@ class KdTree {
   KdTree& operator=(const KdTree&) = delete;
   KdTree& operator=(KdTree&&) = delete;
 
+  // Finds the k nearest neighbors of the point, sorted by distance.
   void knn_search(const Point& point, Index k, std::vector<Index>& indices,
                   std::vector<double>& distances) const;
 
+  // Finds the k nearest neighbors of each of the points in parallel.
+  // The results for the i-th point are stored in indices.at(i) and distances.at(i).
+  void knn_search_batch(const Points& points, Index k, std::vector<std::vector<Index>>& indices,
+                        std::vector<std::vector<double>>& distances) const;
+
   void radius_search(const Point& point, double radius, std::vector<Index>& indices,
                      std::vector<double>& distances) const;
 
+  // Finds the neighbors within the radius of each of the points in parallel.
+  // The results for the i-th point are stored in indices.at(i) and distances.at(i).
+  void radius_search_batch(const Points& points, double radius,
+                           std::vector<std::vector<Index>>& indices,
+                           std::vector<std::vector<double>>& distances) const;
+
  private:
   class Impl;
 
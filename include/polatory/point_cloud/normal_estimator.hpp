@@ -71,6 +71,15 @@ class NormalEstimator {
     return std::move(orient_closed_surface(k));
   }
 
+  // Same as orient_closed_surface, but orients spatial patches of at most patch_size points
+  // in parallel and then makes the orientations of the patches consistent.
+  NormalEstimator& orient_closed_surface_by_patches(Index k = 100, Index patch_size = 100000) &;
+
+  NormalEstimator&& orient_closed_surface_by_patches(Index k = 100,
+                                                     Index patch_size = 100000) && {
+    return std::move(orient_closed_surface_by_patches(k, patch_size));
+  }
+
   const VecX& plane_factors() const& {
     throw_if_not_estimated();
 
@@ -78,6 +87,8 @@ class NormalEstimator {
   }
 
  private:
+  static constexpr Index kBatchSize = 65536;
+
   void throw_if_not_estimated() const {
     if (!estimated_) {
       throw std::runtime_error("normals have not been estimated");
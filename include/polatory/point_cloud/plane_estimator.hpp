@@ -11,6 +11,10 @@ class PlaneEstimator {
  public:
   explicit PlaneEstimator(const geometry::Points3& points);
 
+  // Estimates from the scatter matrix of n_points points, the sum of the outer products
+  // of the points relative to their barycenter, by a closed-form eigendecomposition.
+  PlaneEstimator(const Mat3& scatter, Index n_points);
+
   double line_error() const;
 
   double plane_factor() const;
@@ -24,6 +28,8 @@ class PlaneEstimator {
  private:
   static Eigen::JacobiSVD<geometry::Points3> pca_svd(const geometry::Points3& points);
 
+  void set_errors(double s0, double s1, double s2, Index n_points);
+
   Mat3 basis_;
 
   double point_err_;
@@ -3,6 +3,7 @@
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/types.hpp>
 #include <utility>
+#include <vector>
 
 namespace polatory::point_cloud {
 
@@ -15,14 +16,20 @@ class SdfDataGenerator {
   SdfDataGenerator(const geometry::Points3& points, const geometry::Vectors3& normals,
                    double min_distance, double max_distance, const Mat3& aniso);
 
+  // Generates off-surface points at up to max_distances.size() distances
+  // on each side of each point, in a single pass.
+  SdfDataGenerator(const geometry::Points3& points, const geometry::Vectors3& normals,
+                   double min_distance, const std::vector<double>& max_distances,
+                   const Mat3& aniso = Mat3::Identity());
+
   const geometry::Points3& sdf_points() const;
 
   const VecX& sdf_values() const;
 
  private:
-  static std::pair<geometry::Points3, VecX> estimate_impl(const geometry::Points3& points,
-                                                          const geometry::Vectors3& normals,
-                                                          double min_distance, double max_distance);
+  static std::pair<geometry::Points3, VecX> estimate_impl(
+      const geometry::Points3& points, const geometry::Vectors3& normals, double min_distance,
+      const std::vector<double>& max_distances);
 
   geometry::Points3 sdf_points_;
   VecX sdf_values_;
@@ -3,6 +3,7 @@
 #include <polatory/common/concatenate.hpp>
 #include <polatory/common/io.hpp>
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolant.hpp>
 #include <polatory/interpolation/direct_evaluator.hpp>
@@ -12,6 +13,7 @@
 #include <polatory/model.hpp>
 #include <polatory/numeric/conv.hpp>
 #include <polatory/numeric/error.hpp>
+#include <polatory/partition_of_unity_interpolant.hpp>
 #include <polatory/point_cloud/distance_filter.hpp>
 #include <polatory/point_cloud/normal_estimator.hpp>
 #include <polatory/point_cloud/sdf_data_generator.hpp>
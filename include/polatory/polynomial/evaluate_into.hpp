@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <polatory/common/macros.hpp>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/types.hpp>
+
+namespace polatory::polynomial {
+
+// Evaluates the basis at the points and the gradient points into result chunk by chunk,
+// so that no temporary of the size of result is created.
+template <class Basis, class DerivedPoints, class DerivedGradPoints>
+void evaluate_into(const Basis& basis, const Eigen::MatrixBase<DerivedPoints>& points,
+                   const Eigen::MatrixBase<DerivedGradPoints>& grad_points,
+                   Eigen::Ref<MatX> result) {
+  static constexpr int kDim = Basis::kDim;
+  static constexpr Index kChunkSize = 65536;
+  using Points = geometry::Points<kDim>;
+
+  auto mu = points.rows();
+  auto sigma = grad_points.rows();
+  POLATORY_ASSERT(result.rows() == mu + kDim * sigma);
+  POLATORY_ASSERT(result.cols() == basis.basis_size());
+
+  for (Index i = 0; i < mu; i += kChunkSize) {
+    auto n = std::min(kChunkSize, mu - i);
+    result.middleRows(i, n) = basis.evaluate(points.middleRows(i, n), Points(0, kDim));
+  }
+
+  for (Index i = 0; i < sigma; i += kChunkSize) {
+    auto n = std::min(kChunkSize, sigma - i);
+    result.middleRows(mu + kDim * i, kDim * n) =
+        basis.evaluate(Points(0, kDim), grad_points.middleRows(i, n));
+  }
+}
+
+}  // namespace polatory::polynomial
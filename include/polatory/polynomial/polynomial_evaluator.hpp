@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <optional>
 #include <polatory/common/macros.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/types.hpp>
 
@@ -9,6 +12,7 @@ namespace polatory::polynomial {
 template <class Basis>
 class PolynomialEvaluator {
   static constexpr int kDim = Basis::kDim;
+  using GridPoints = geometry::GridPoints<kDim>;
   using Points = geometry::Points<kDim>;
 
  public:
@@ -16,14 +20,33 @@ class PolynomialEvaluator {
       : basis_(degree), weights_(VecX::Zero(basis_.basis_size())) {}
 
   VecX evaluate() const {
-    auto p = basis_.evaluate(points_, grad_points_);
+    if (!grid_) {
+      auto p = basis_.evaluate(points_, grad_points_);
 
-    return p * weights_;
+      return p * weights_;
+    }
+
+    auto n_points = grid_->rows();
+    VecX y(n_points);
+    for (Index begin = 0; begin < n_points; begin += kGridBlockSize) {
+      auto end = std::min(begin + kGridBlockSize, n_points);
+      auto p = basis_.evaluate(grid_->points(begin, end), Points(0, kDim));
+      y.segment(begin, end - begin) = p * weights_;
+    }
+
+    return y;
   }
 
   void set_target_points(const Points& points, const Points& grad_points) {
     points_ = points;
     grad_points_ = grad_points;
+    grid_.reset();
+  }
+
+  void set_target_points(const GridPoints& points) {
+    points_ = Points(0, kDim);
+    grad_points_ = Points(0, kDim);
+    grid_.emplace(points);
   }
 
   void set_weights(const VecX& weights) {
@@ -33,10 +56,14 @@ class PolynomialEvaluator {
   }
 
  private:
+  // The maximum number of grid points evaluated at once.
+  static constexpr Index kGridBlockSize = Index{1} << 16;
+
   const Basis basis_;
 
   Points points_;
   Points grad_points_;
+  std::optional<GridPoints> grid_;
   VecX weights_;
 };
 
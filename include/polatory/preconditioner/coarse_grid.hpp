@@ -38,7 +38,7 @@ class CoarseGrid {
   }
 
   void setup(const Points& points_full, const Points& grad_points_full,
-             const MatX& lagrange_p_full) {
+             const Eigen::Ref<const MatX>& lagrange_p_full) {
     Points points = points_full(point_idcs_, Eigen::all);
     Points grad_points = grad_points_full(grad_point_idcs_, Eigen::all);
 
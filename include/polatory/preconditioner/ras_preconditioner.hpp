@@ -10,6 +10,7 @@
 #include <memory>
 #include <numeric>
 #include <polatory/common/macros.hpp>
+#include <polatory/common/matrix_storage.hpp>
 #include <polatory/common/orthonormalize.hpp>
 #include <polatory/geometry/bbox3d.hpp>
 #include <polatory/geometry/point3d.hpp>
@@ -17,6 +18,7 @@
 #include <polatory/interpolation/symmetric_evaluator.hpp>
 #include <polatory/krylov/linear_operator.hpp>
 #include <polatory/model.hpp>
+#include <polatory/polynomial/evaluate_into.hpp>
 #include <polatory/polynomial/lagrange_basis.hpp>
 #include <polatory/polynomial/monomial_basis.hpp>
 #include <polatory/polynomial/unisolvent_point_set.hpp>
@@ -53,7 +55,10 @@ class RasPreconditioner : public krylov::LinearOperator {
   static constexpr Index kNCoarsestPoints = 2048;
 
  public:
-  RasPreconditioner(const Model& model, const Points& points, const Points& grad_points)
+  // In the out-of-core mode, the dense matrices of size O(N) are stored
+  // in memory-mapped temporary files.
+  RasPreconditioner(const Model& model, const Points& points, const Points& grad_points,
+                    bool out_of_core = false)
       : model_(model),
         l_(model.poly_basis_size()),
         mu_(points.rows()),
@@ -73,6 +78,8 @@ class RasPreconditioner : public krylov::LinearOperator {
     point_idcs_.resize(n_levels_);
     grad_point_idcs_.resize(n_levels_);
 
+    // The Lagrange basis is only needed for setting up the grids.
+    common::MatrixStorage lagrange_p;
     std::vector<Index> poly_point_idcs;
     {
       auto level = n_levels_ - 1;
@@ -82,13 +89,15 @@ class RasPreconditioner : public krylov::LinearOperator {
           // The special case.
           poly_point_idcs = {0};
           LagrangeBasis lagrange_basis(model.poly_degree(), points_, grad_points_.topRows(1));
-          lagrange_p_ = lagrange_basis.evaluate(points_, grad_points_);
+          lagrange_p = common::MatrixStorage(mu_ + kDim * sigma_, l_, out_of_core);
+          polynomial::evaluate_into(lagrange_basis, points_, grad_points_, lagrange_p.matrix());
         } else {
           // The ordinary case.
           UnisolventPointSet ups(points_, model.poly_degree());
           poly_point_idcs = ups.point_indices();
           LagrangeBasis lagrange_basis(model.poly_degree(), points_(poly_point_idcs, Eigen::all));
-          lagrange_p_ = lagrange_basis.evaluate(points_, grad_points_);
+          lagrange_p = common::MatrixStorage(mu_ + kDim * sigma_, l_, out_of_core);
+          polynomial::evaluate_into(lagrange_basis, points_, grad_points_, lagrange_p.matrix());
         }
 
         point_idcs_.at(level) = poly_point_idcs;
@@ -146,7 +155,7 @@ class RasPreconditioner : public krylov::LinearOperator {
 #pragma omp parallel for schedule(dynamic)
       for (Index i = 0; i < n_grids; i++) {
         auto& fine = fine_grids_.at(level).at(i);
-        fine.setup(points_, grad_points_, lagrange_p_);
+        fine.setup(points_, grad_points_, lagrange_p.matrix());
       }
 
       std::cout << std::format("{:>8}{:>16}{:>16}{:>16}", level, n_grids, mu, sigma) << std::endl;
@@ -161,7 +170,7 @@ class RasPreconditioner : public krylov::LinearOperator {
       coarse_domain.grad_point_indices = grad_point_idcs_.at(0);
 
       coarse_ = std::make_unique<CoarseGrid>(model, std::move(coarse_domain));
-      coarse_->setup(points_, grad_points_, lagrange_p_);
+      coarse_->setup(points_, grad_points_, lagrange_p.matrix());
 
       std::cout << std::format("{:>8}{:>16}{:>16}{:>16}", 0, 1, mu, sigma) << std::endl;
     }
@@ -172,18 +181,20 @@ class RasPreconditioner : public krylov::LinearOperator {
 
     if (l_ > 0) {
       MonomialBasis poly(model.poly_degree());
-      p_ = poly.evaluate(points_, grad_points_);
-      common::orthonormalize_cols(p_);
+      p_ = common::MatrixStorage(mu_ + kDim * sigma_, l_, out_of_core);
+      auto p = p_.matrix();
+      polynomial::evaluate_into(poly, points_, grad_points_, p);
+      common::orthonormalize_cols(p);
 
-      ap_ = MatX(p_.rows(), p_.cols());
+      ap_ = common::MatrixStorage(mu_ + kDim * sigma_, l_, out_of_core);
+      auto ap = ap_.matrix();
 
       auto finest_evaluator = SymmetricEvaluator(model, points_, grad_points_);
       VecX weights = VecX::Zero(mu_ + kDim * sigma_ + l_);
-      auto n_cols = p_.cols();
-      for (Index i = 0; i < n_cols; i++) {
-        weights.head(mu_ + kDim * sigma_) = p_.col(i);
+      for (Index i = 0; i < l_; i++) {
+        weights.head(mu_ + kDim * sigma_) = p.col(i);
         finest_evaluator.set_weights(weights);
-        ap_.col(i) = finest_evaluator.evaluate();
+        ap.col(i) = finest_evaluator.evaluate();
       }
     }
   }
@@ -271,9 +282,10 @@ class RasPreconditioner : public krylov::LinearOperator {
   void orthogonalize(VecX& weights, VecX& residuals) const {
     if (l_ > 0) {
       // Orthogonalize weights against P.
-      VecX dot = p_.transpose() * weights.head(mu_ + kDim * sigma_);
-      weights.head(mu_ + kDim * sigma_) -= p_ * dot;
-      residuals += ap_ * dot;
+      auto p = p_.matrix();
+      VecX dot = p.transpose() * weights.head(mu_ + kDim * sigma_);
+      weights.head(mu_ + kDim * sigma_) -= p * dot;
+      residuals += ap_.matrix() * dot;
     }
   }
 
@@ -351,15 +363,14 @@ class RasPreconditioner : public krylov::LinearOperator {
   const Bbox bbox_;
   const std::unique_ptr<SymmetricEvaluator> finest_evaluator_;
 
-  MatX lagrange_p_;
   int n_levels_;
   std::vector<std::vector<Index>> point_idcs_;
   std::vector<std::vector<Index>> grad_point_idcs_;
   mutable std::vector<std::vector<FineGrid>> fine_grids_;
   std::unique_ptr<CoarseGrid> coarse_;
   mutable std::map<std::pair<int, int>, Evaluator> evaluator_;
-  MatX p_;
-  MatX ap_;
+  common::MatrixStorage p_;
+  common::MatrixStorage ap_;
   BinaryCache cache_;
 };
 
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <Eigen/Core>
-#include <boost/algorithm/string.hpp>
 #include <format>
 #include <fstream>
 #include <iostream>
@@ -13,51 +12,10 @@
 
 namespace polatory {
 
-inline MatX read_table(const std::string& filename, const char* delimiters = " \t,") {
-  std::ifstream ifs(filename);
-  if (!ifs) {
-    throw std::runtime_error(std::format("cannot open file '{}'", filename));
-  }
-
-  std::vector<double> buffer;
-
-  std::string line;
-  auto n_cols = Index{0};
-  auto line_no = 0;
-  while (std::getline(ifs, line)) {
-    line_no++;
-
-    if (boost::starts_with(line, "#")) {
-      continue;
-    }
-
-    std::vector<std::string> row;
-    boost::split(row, line, boost::is_any_of(delimiters));
-
-    auto row_size = static_cast<Index>(row.size());
-    if (n_cols == 0) {
-      n_cols = row_size;
-    } else if (row_size != n_cols) {
-      std::cerr << std::format("warning: skipping line {} with a different number of columns",
-                               line_no)
-                << std::endl;
-      continue;
-    }
-
-    for (const auto& cell : row) {
-      // On Unix platforms, std::getline() keeps the \r if the line ends with \r\n.
-      // Use boost::trim_copy() to remove it.
-      buffer.push_back(numeric::to_double(boost::trim_copy(cell)));
-    }
-  }
-
-  if (n_cols == 0) {
-    throw std::runtime_error(std::format("file '{}' is empty", filename));
-  }
-
-  auto n_rows = static_cast<Index>(buffer.size() / n_cols);
-  return MatX::Map(buffer.data(), n_rows, n_cols);
-}
+// Reads a table of numbers from a text file, one row per line, with the cells separated
+// by any of the delimiters. Lines starting with # are ignored, and lines with a different
+// number of cells than the first one are skipped with a warning.
+MatX read_table(const std::string& filename, const char* delimiters = " \t,");
 
 template <class Derived>
 void write_table(const std::string& filename, const Eigen::MatrixBase<Derived>& table,
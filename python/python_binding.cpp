@@ -36,6 +36,7 @@ void define_module(py::module& m) {
   using DistanceFilter = point_cloud::DistanceFilter<Dim>;
   using Interpolant = Interpolant<Dim>;
   using Model = Model<Dim>;
+  using PartitionOfUnityInterpolant = PartitionOfUnityInterpolant<Dim>;
   using Points = geometry::Points<Dim>;
   using Rbf = rbf::Rbf<Dim>;
   using Variogram = kriging::Variogram<Dim>;
@@ -133,9 +134,42 @@ void define_module(py::module& m) {
                              double, const Interpolant*>(&Interpolant::fit_inequality),
            "points"_a, "values"_a, "values_lb"_a, "values_ub"_a, "tolerance"_a, "max_iter"_a = 100,
            "accuracy"_a = kInfinity, "initial"_a = nullptr)
+      .def("query", &Interpolant::query, "points"_a)
+      .def("set_operator_type", &Interpolant::set_operator_type, "op_type"_a)
+      .def("set_out_of_core", &Interpolant::set_out_of_core, "out_of_core"_a)
+      .def("set_query_bbox", &Interpolant::set_query_bbox, "bbox"_a, "accuracy"_a = kInfinity)
       .def_static("load", &Interpolant::load, "filename"_a)
       .def("save", &Interpolant::save, "filename"_a);
 
+  py::class_<PartitionOfUnityInterpolant>(m, "PartitionOfUnityInterpolant")
+      .def(py::init<const Model&, Index, double>(), "model"_a,
+           "patch_size"_a = PartitionOfUnityInterpolant::kDefaultPatchSize,
+           "overlap"_a = PartitionOfUnityInterpolant::kDefaultOverlap)
+      .def_property_readonly("bbox", &PartitionOfUnityInterpolant::bbox)
+      .def_property_readonly("model", &PartitionOfUnityInterpolant::model)
+      .def_property_readonly("num_patches", &PartitionOfUnityInterpolant::num_patches)
+      .def_property_readonly("overlap", &PartitionOfUnityInterpolant::overlap)
+      .def_property_readonly("patch_size", &PartitionOfUnityInterpolant::patch_size)
+      .def("evaluate",
+           py::overload_cast<const Points&, double>(&PartitionOfUnityInterpolant::evaluate,
+                                                    py::const_),
+           "points"_a, "accuracy"_a = kInfinity)
+      .def("evaluate",
+           py::overload_cast<const Points&, const Points&, double, double>(
+               &PartitionOfUnityInterpolant::evaluate, py::const_),
+           "points"_a, "grad_points"_a, "accuracy"_a = kInfinity, "grad_accuracy"_a = kInfinity)
+      .def("fit",
+           py::overload_cast<const Points&, const VecX&, double, int, double>(
+               &PartitionOfUnityInterpolant::fit),
+           "points"_a, "values"_a, "tolerance"_a, "max_iter"_a = 100, "accuracy"_a = kInfinity)
+      .def("fit",
+           py::overload_cast<const Points&, const Points&, const VecX&, double, double, int, double,
+                             double>(&PartitionOfUnityInterpolant::fit),
+           "points"_a, "grad_points"_a, "values"_a, "tolerance"_a, "grad_tolerance"_a,
+           "max_iter"_a = 100, "accuracy"_a = kInfinity, "grad_accuracy"_a = kInfinity)
+      .def_static("load", &PartitionOfUnityInterpolant::load, "filename"_a)
+      .def("save", &PartitionOfUnityInterpolant::save, "filename"_a);
+
   py::class_<DistanceFilter>(m, "DistanceFilter")
       .def(py::init<const Points&>(), "points"_a)
       .def_property_readonly("filtered_indices", &DistanceFilter::filtered_indices)
@@ -161,9 +195,13 @@ void define_module(py::module& m) {
                     &VariogramCalculator::set_angle_tolerance)
       .def_property("directions", &VariogramCalculator::directions,
                     &VariogramCalculator::set_directions)
+      .def_property("estimator", &VariogramCalculator::estimator,
+                    &VariogramCalculator::set_estimator)
       .def_property("lag_tolerance", &VariogramCalculator::lag_tolerance,
                     &VariogramCalculator::set_lag_tolerance)
-      .def("calculate", &VariogramCalculator::calculate, "points"_a, "values"_a);
+      .def("calculate", &VariogramCalculator::calculate, "points"_a, "values"_a)
+      .def("calculate_multiple", &VariogramCalculator::calculate_multiple, "points"_a, "values"_a,
+           "estimators"_a);
 
   py::class_<VariogramFitting>(m, "VariogramFitting")
       .def(py::init<const VariogramSet&, const Model&, const kriging::WeightFunction&, bool>(),
@@ -184,7 +222,12 @@ void define_module(py::module& m) {
       .def("save", &VariogramSet::save, "filename"_a);
 
   m.def("cross_validate", &kriging::cross_validate<Dim>, "model"_a, "points"_a, "values"_a,
-        "set_ids"_a, "tolerance"_a, "max_iter"_a = 100, "accuracy"_a = kInfinity);
+        "set_ids"_a, "tolerance"_a, "max_iter"_a = 100, "accuracy"_a = kInfinity,
+        "num_concurrent_sets"_a = 1, "warm_start"_a = false);
+
+  m.def("fit_variogram", &kriging::fit_variogram<Dim>, "variog_set"_a, "model"_a, "num_starts"_a,
+        "weight_fn"_a = kriging::WeightFunction::kNumPairsOverDistanceSquared,
+        "fit_anisotropy"_a = true);
 
   m.def("detrend", &kriging::detrend<Dim>, "points"_a, "values"_a, "degree"_a);
 }
@@ -194,6 +237,15 @@ PYBIND11_MODULE(_core, m) {
   using Mat = Mat3;
   using NormalEstimator = point_cloud::NormalEstimator;
 
+  py::enum_<interpolation::OperatorType>(m, "OperatorType")
+      .value("FMM", interpolation::OperatorType::kFmm)
+      .value("HMATRIX", interpolation::OperatorType::kHMatrix);
+
+  py::enum_<kriging::VariogramEstimator>(m, "VariogramEstimator")
+      .value("MATHERON", kriging::VariogramEstimator::kMatheron)
+      .value("CRESSIE_HAWKINS", kriging::VariogramEstimator::kCressieHawkins)
+      .value("MADOGRAM", kriging::VariogramEstimator::kMadogram);
+
   py::class_<NormalEstimator>(m, "NormalEstimator")
       .def(py::init<const geometry::Points3&>(), "points"_a)
       .def_property_readonly("normals", &NormalEstimator::normals)
@@ -229,12 +281,20 @@ PYBIND11_MODULE(_core, m) {
       .def("orient_closed_surface",
            static_cast<NormalEstimator& (NormalEstimator::*)(Index)&>(
                &NormalEstimator::orient_closed_surface),
-           "k"_a = 100);
+           "k"_a = 100)
+      .def("orient_closed_surface_by_patches",
+           static_cast<NormalEstimator& (NormalEstimator::*)(Index, Index)&>(
+               &NormalEstimator::orient_closed_surface_by_patches),
+           "k"_a = 100, "patch_size"_a = 100000);
 
   py::class_<point_cloud::SdfDataGenerator>(m, "SdfDataGenerator")
       .def(py::init<const geometry::Points3&, const geometry::Vectors3&, double, double,
                     const Mat&>(),
            "points"_a, "normals"_a, "min_distance"_a, "max_distance"_a, "aniso"_a = Mat::Identity())
+      .def(py::init<const geometry::Points3&, const geometry::Vectors3&, double,
+                    const std::vector<double>&, const Mat&>(),
+           "points"_a, "normals"_a, "min_distance"_a, "max_distances"_a,
+           "aniso"_a = Mat::Identity())
       .def_property_readonly("sdf_points", &point_cloud::SdfDataGenerator::sdf_points)
       .def_property_readonly("sdf_values", &point_cloud::SdfDataGenerator::sdf_values);
 
@@ -244,20 +304,35 @@ PYBIND11_MODULE(_core, m) {
       .def(py::init<Interpolant<3>&, double, double>(), "interpolant"_a, "accuracy"_a = kInfinity,
            "grad_accuracy"_a = kInfinity);
 
+  py::class_<isosurface::RbfFieldFunctionWithGradient, isosurface::FieldFunction>(
+      m, "RbfFieldFunctionWithGradient")
+      .def(py::init<Interpolant<3>&, double, double>(), "interpolant"_a, "accuracy"_a = kInfinity,
+           "grad_accuracy"_a = kInfinity);
+
   py::class_<isosurface::RbfFieldFunction25D, isosurface::FieldFunction>(m, "RbfFieldFunction25D")
       .def(py::init<Interpolant<2>&, double, double>(), "interpolant"_a, "accuracy"_a = kInfinity,
            "grad_accuracy"_a = kInfinity);
 
+  py::class_<isosurface::RbfFieldFunction25DWithGradient, isosurface::FieldFunction>(
+      m, "RbfFieldFunction25DWithGradient")
+      .def(py::init<Interpolant<2>&, double, double>(), "interpolant"_a, "accuracy"_a = kInfinity,
+           "grad_accuracy"_a = kInfinity);
+
   py::class_<isosurface::Isosurface>(m, "Isosurface")
       .def(py::init<const Bbox&, double, const Mat&>(), "bbox"_a, "resolution"_a,
            "aniso"_a = Mat::Identity())
       .def("generate", &isosurface::Isosurface::generate, "field_fn"_a, "isovalue"_a = 0.0,
            "refine"_a = 1)
+      .def("generate_multiple", &isosurface::Isosurface::generate_multiple, "field_fn"_a,
+           "isovalues"_a, "refine"_a = 1)
       .def("generate_from_seed_points", &isosurface::Isosurface::generate_from_seed_points,
            "seed_points"_a, "field_fn"_a, "isovalue"_a = 0.0, "refine"_a = 1);
 
   py::class_<isosurface::Mesh>(m, "Mesh")
+      .def("export_file", &isosurface::Mesh::export_file, "filename"_a)
       .def("export_obj", &isosurface::Mesh::export_obj, "filename"_a)
+      .def("export_ply", &isosurface::Mesh::export_ply, "filename"_a)
+      .def("export_stl", &isosurface::Mesh::export_stl, "filename"_a)
       .def_property_readonly("faces", &isosurface::Mesh::faces)
       .def_property_readonly("vertices", &isosurface::Mesh::vertices);
 
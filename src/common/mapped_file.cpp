@@ -0,0 +1,91 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <boost/filesystem.hpp>
+#include <cstdlib>
+#include <format>
+#include <polatory/common/mapped_file.hpp>
+#include <stdexcept>
+
+namespace polatory::common {
+
+namespace {
+
+boost::filesystem::path temp_directory_path() {
+  // NOLINTNEXTLINE(concurrency-mt-unsafe)
+  const auto* dir = std::getenv("POLATORY_TMPDIR");
+  if (dir != nullptr && *dir != '\0') {
+    return dir;
+  }
+
+  return boost::filesystem::temp_directory_path();
+}
+
+}  // namespace
+
+MappedFile::MappedFile(std::size_t size) : size_(size) {
+  auto filename = temp_directory_path() / boost::filesystem::unique_path();
+
+#ifdef _WIN32
+  file_ = ::CreateFileW(filename.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_NEW,
+                        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    throw std::runtime_error(
+        std::format("failed to open a temporary file '{}'", filename.string()));
+  }
+
+  LARGE_INTEGER li;
+  li.QuadPart = static_cast<LONGLONG>(size_);
+  mapping_ =
+      ::CreateFileMappingW(file_, nullptr, PAGE_READWRITE, li.HighPart, li.LowPart, nullptr);
+  if (mapping_ == nullptr) {
+    ::CloseHandle(file_);
+    throw std::runtime_error("failed to map a temporary file");
+  }
+
+  data_ = ::MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, size_);
+  if (data_ == nullptr) {
+    ::CloseHandle(mapping_);
+    ::CloseHandle(file_);
+    throw std::runtime_error("failed to map a temporary file");
+  }
+#else
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  file_ = ::open(filename.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+  if (file_ == -1) {
+    throw std::runtime_error(
+        std::format("failed to open a temporary file '{}'", filename.string()));
+  }
+  ::unlink(filename.c_str());
+
+  // The file is sparse; disk space is consumed only as the data are written.
+  if (::ftruncate(file_, static_cast<::off_t>(size_)) == -1) {
+    ::close(file_);
+    throw std::runtime_error("failed to resize a temporary file");
+  }
+
+  data_ = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, file_, 0);
+  if (data_ == MAP_FAILED) {
+    ::close(file_);
+    throw std::runtime_error("failed to map a temporary file");
+  }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#ifdef _WIN32
+  ::UnmapViewOfFile(data_);
+  ::CloseHandle(mapping_);
+  ::CloseHandle(file_);
+#else
+  ::munmap(data_, size_);
+  ::close(file_);
+#endif
+}
+
+}  // namespace polatory::common
@@ -3,7 +3,9 @@
 #include <Eigen/Core>
 #include <algorithm>
 #include <limits>
+#include <map>
 #include <memory>
+#include <optional>
 #include <polatory/common/macros.hpp>
 #include <polatory/fmm/fmm_evaluator.hpp>
 #include <polatory/types.hpp>
@@ -19,7 +21,7 @@
 #include <scalfmm/tree/leaf_view.hpp>
 #include <scalfmm/utils/sort.hpp>
 #include <tuple>
-#include <unordered_map>
+#include <utility>
 
 #include "fmm_accuracy_estimator.hpp"
 #include "full_direct.hpp"
@@ -33,6 +35,7 @@ template <class Kernel>
 class FmmGenericEvaluator<Kernel>::Impl {
   static constexpr int kDim{Kernel::kDim};
   using Bbox = geometry::Bbox<kDim>;
+  using GridPoints = geometry::GridPoints<kDim>;
   using Points = geometry::Points<kDim>;
 
   static constexpr int km{Kernel::km};
@@ -75,47 +78,32 @@ class FmmGenericEvaluator<Kernel>::Impl {
         near_field_(kernel_, false) {}
 
   VecX evaluate() const {
-    using namespace scalfmm::algorithms;
-
-    prepare();
-
-    if (config_.tree_height > 0) {
-      if (multipole_dirty_) {
-        src_tree_->reset_multipoles();
-        scalfmm::algorithms::fmm[scalfmm::options::_s(scalfmm::options::omp)]  //
-            (*src_tree_, *fmm_operator_, p2m | m2m);
-        multipole_dirty_ = false;
-      }
-
-      trg_tree_->reset_locals();
-      trg_tree_->reset_outputs();
-      if (!trg_tree_->is_interaction_m2l_lists_built()) {
-        scalfmm::list::omp::build_m2l_interaction_list(*src_tree_, *trg_tree_, 1);
-      }
-      if (!trg_tree_->is_interaction_p2p_lists_built()) {
-        scalfmm::list::omp::build_p2p_interaction_list(*src_tree_, *trg_tree_, 1, false);
-      }
-      scalfmm::algorithms::fmm[scalfmm::options::_s(scalfmm::options::omp)]  //
-          (*src_tree_, *trg_tree_, *fmm_operator_, m2l | l2l | l2p | p2p);
-    } else {
-      trg_particles_.reset_outputs();
-      full_direct(src_particles_, trg_particles_, kernel_);
+    if (!trg_grid_) {
+      auto result = evaluate_impl();
+      release_trees();
+      return result;
     }
 
-    auto result = potentials();
-
-    // Release memory held by the trees.
-    src_tree_.reset(nullptr);
-    trg_tree_.reset(nullptr);
+    // Explicit target particles and a target tree are built for each block of the grid,
+    // so that at most kGridBlockSize of them exist at a time.
+    // The source tree and its multipoles are built only once for all blocks.
+    const auto& grid = *trg_grid_;
+    auto n_points = grid.rows();
+    VecX result(kn * n_points);
+    for (Index begin = 0; begin < n_points; begin += kGridBlockSize) {
+      auto end = std::min(begin + kGridBlockSize, n_points);
+      set_target_particles(end - begin, [&](auto fn) { grid.for_each_point(begin, end, fn); },
+                           begin);
+      result.segment(kn * begin, kn * (end - begin)) = evaluate_impl();
+    }
+    release_trees();
 
     return result;
   }
 
-  void set_accuracy(double accuracy) {
-    accuracy_ = accuracy;
-
-    best_config_.clear();
-  }
+  // The best configurations found are kept per accuracy,
+  // so that switching between accuracies does not require finding them again.
+  void set_accuracy(double accuracy) { accuracy_ = accuracy; }
 
   void set_source_points(const Points& points) {
     n_src_points_ = points.rows();
@@ -138,20 +126,22 @@ class FmmGenericEvaluator<Kernel>::Impl {
   }
 
   void set_target_points(const Points& points) {
-    n_trg_points_ = points.rows();
-
-    trg_particles_.resize(n_trg_points_);
-
-    auto a = rbf_.anisotropy();
-    for (Index idx = 0; idx < n_trg_points_; idx++) {
-      auto p = trg_particles_.at(idx);
-      auto ap = geometry::transform_point<kDim>(a, points.row(idx));
-      for (auto i = 0; i < kDim; i++) {
-        p.position(i) = ap(i);
-      }
-      p.variables(idx);
-    }
+    trg_grid_.reset();
+    set_target_particles(
+        points.rows(),
+        [&](auto fn) {
+          for (Index idx = 0; idx < points.rows(); idx++) {
+            fn(idx, points.row(idx));
+          }
+        },
+        0);
+  }
 
+  void set_target_points(const GridPoints& points) {
+    // The particles are generated from the grid block by block on evaluation.
+    trg_grid_.emplace(points);
+    n_trg_points_ = 0;
+    trg_particles_.resize(0);
     trg_sorted_level_ = 0;
     trg_tree_.reset(nullptr);
   }
@@ -159,15 +149,16 @@ class FmmGenericEvaluator<Kernel>::Impl {
   void set_weights(const Eigen::Ref<const VecX>& weights) {
     POLATORY_ASSERT(weights.rows() == km * n_src_points_);
 
-    if (!src_tree_) {
-      for (Index idx = 0; idx < n_src_points_; idx++) {
-        auto p = src_particles_.at(idx);
-        auto orig_idx = std::get<0>(p.variables());
-        for (auto i = 0; i < km; i++) {
-          p.inputs(i) = weights(km * orig_idx + i);
-        }
+    // The particles are updated even if the tree exists, as it can be rebuilt from them.
+    for (Index idx = 0; idx < n_src_points_; idx++) {
+      auto p = src_particles_.at(idx);
+      auto orig_idx = std::get<0>(p.variables());
+      for (auto i = 0; i < km; i++) {
+        p.inputs(i) = weights(km * orig_idx + i);
       }
-    } else {
+    }
+
+    if (src_tree_) {
       scalfmm::component::for_each_leaf(std::begin(*src_tree_), std::end(*src_tree_),
                                         [&](const auto& leaf) {
                                           for (auto p_ref : leaf) {
@@ -185,8 +176,70 @@ class FmmGenericEvaluator<Kernel>::Impl {
   }
 
  private:
+  // The maximum number of grid points evaluated at once.
+  static constexpr Index kGridBlockSize = Index{1} << 20;
+
+  VecX evaluate_impl() const {
+    using namespace scalfmm::algorithms;
+
+    prepare();
+
+    if (config_.tree_height > 0) {
+      if (multipole_dirty_) {
+        src_tree_->reset_multipoles();
+        scalfmm::algorithms::fmm[scalfmm::options::_s(scalfmm::options::omp)]  //
+            (*src_tree_, *fmm_operator_, p2m | m2m);
+        multipole_dirty_ = false;
+      }
+
+      trg_tree_->reset_locals();
+      trg_tree_->reset_outputs();
+      if (!trg_tree_->is_interaction_m2l_lists_built()) {
+        scalfmm::list::omp::build_m2l_interaction_list(*src_tree_, *trg_tree_, 1);
+      }
+      if (!trg_tree_->is_interaction_p2p_lists_built()) {
+        scalfmm::list::omp::build_p2p_interaction_list(*src_tree_, *trg_tree_, 1, false);
+      }
+      scalfmm::algorithms::fmm[scalfmm::options::_s(scalfmm::options::omp)]  //
+          (*src_tree_, *trg_tree_, *fmm_operator_, m2l | l2l | l2p | p2p);
+    } else {
+      trg_particles_.reset_outputs();
+      full_direct(src_particles_, trg_particles_, kernel_);
+    }
+
+    return potentials();
+  }
+
+  // Releases the memory held by the trees.
+  void release_trees() const {
+    src_tree_.reset(nullptr);
+    trg_tree_.reset(nullptr);
+  }
+
+  // Sets the target particles from n points enumerated by for_each_point(fn),
+  // which calls fn(idx, p) for each point p, where idx - idx_offset is the index of the particle.
+  template <class ForEachPoint>
+  void set_target_particles(Index n, ForEachPoint for_each_point, Index idx_offset) const {
+    n_trg_points_ = n;
+
+    trg_particles_.resize(n_trg_points_);
+
+    auto a = rbf_.anisotropy();
+    for_each_point([&](Index idx, const auto& point) {
+      auto p = trg_particles_.at(idx - idx_offset);
+      auto ap = geometry::transform_point<kDim>(a, point);
+      for (auto i = 0; i < kDim; i++) {
+        p.position(i) = ap(i);
+      }
+      p.variables(idx - idx_offset);
+    });
+
+    trg_sorted_level_ = 0;
+    trg_tree_.reset(nullptr);
+  }
+
   InterpolatorConfiguration find_best_configuration(int tree_height) const {
-    auto [it, inserted] = best_config_.try_emplace(tree_height);
+    auto [it, inserted] = best_config_.try_emplace({accuracy_, tree_height});
     if (inserted) {
       auto config = FmmAccuracyEstimator<Kernel>::find_best_configuration(
           rbf_, accuracy_, src_particles_, box_, tree_height);
@@ -224,7 +277,10 @@ class FmmGenericEvaluator<Kernel>::Impl {
   }
 
   void prepare() const {
-    if (n_src_points_ * n_trg_points_ < 1024 * 1024) {
+    // For a grid, the total number of points is used so that all blocks share the source tree.
+    auto n_trg_points = trg_grid_ ? trg_grid_->rows() : n_trg_points_;
+
+    if (n_src_points_ * n_trg_points < 1024 * 1024) {
       far_field_.reset(nullptr);
       fmm_operator_.reset(nullptr);
       src_tree_.reset(nullptr);
@@ -233,7 +289,7 @@ class FmmGenericEvaluator<Kernel>::Impl {
       return;
     }
 
-    auto tree_height = fmm_tree_height<kDim>(std::max(n_src_points_, n_trg_points_));
+    auto tree_height = fmm_tree_height<kDim>(std::max(n_src_points_, n_trg_points));
 
     if (src_sorted_level_ < tree_height - 1) {
       scalfmm::utils::sort_container(box_, tree_height - 1, src_particles_);
@@ -277,7 +333,8 @@ class FmmGenericEvaluator<Kernel>::Impl {
 
   double accuracy_{std::numeric_limits<double>::infinity()};
   Index n_src_points_{};
-  Index n_trg_points_{};
+  mutable Index n_trg_points_{};
+  std::optional<GridPoints> trg_grid_;
   mutable SourceContainer src_particles_;
   mutable TargetContainer trg_particles_;
   mutable int src_sorted_level_{};
@@ -288,7 +345,7 @@ class FmmGenericEvaluator<Kernel>::Impl {
   mutable std::unique_ptr<FmmOperator> fmm_operator_;
   mutable std::unique_ptr<SourceTree> src_tree_;
   mutable std::unique_ptr<TargetTree> trg_tree_;
-  mutable std::unordered_map<int, InterpolatorConfiguration> best_config_;
+  mutable std::map<std::pair<double, int>, InterpolatorConfiguration> best_config_;
   mutable LruCache<InterpolatorConfiguration, Interpolator> interpolator_cache_{2};
 };
 
@@ -319,6 +376,11 @@ void FmmGenericEvaluator<Kernel>::set_target_points(const Points& points) {
   impl_->set_target_points(points);
 }
 
+template <class Kernel>
+void FmmGenericEvaluator<Kernel>::set_target_points(const GridPoints& points) {
+  impl_->set_target_points(points);
+}
+
 template <class Kernel>
 void FmmGenericEvaluator<Kernel>::set_weights(const Eigen::Ref<const VecX>& weights) {
   impl_->set_weights(weights);
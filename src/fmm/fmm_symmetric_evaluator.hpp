@@ -2,6 +2,7 @@
 
 #include <Eigen/Core>
 #include <limits>
+#include <map>
 #include <memory>
 #include <polatory/common/macros.hpp>
 #include <polatory/fmm/fmm_symmetric_evaluator.hpp>
@@ -18,11 +19,12 @@
 #include <scalfmm/tree/leaf_view.hpp>
 #include <scalfmm/utils/sort.hpp>
 #include <tuple>
-#include <unordered_map>
+#include <utility>
 
 #include "fmm_accuracy_estimator.hpp"
 #include "full_direct.hpp"
 #include "interpolator_configuration.hpp"
+#include "lru_cache.hpp"
 #include "utility.hpp"
 
 namespace polatory::fmm {
@@ -95,11 +97,9 @@ class FmmGenericSymmetricEvaluator<Kernel>::Impl {
     return result;
   }
 
-  void set_accuracy(double accuracy) {
-    accuracy_ = accuracy;
-
-    best_config_.clear();
-  }
+  // The best configurations found are kept per accuracy,
+  // so that switching between accuracies does not require finding them again.
+  void set_accuracy(double accuracy) { accuracy_ = accuracy; }
 
   void set_points(const Points& points) {
     n_points_ = points.rows();
@@ -150,7 +150,7 @@ class FmmGenericSymmetricEvaluator<Kernel>::Impl {
 
  private:
   InterpolatorConfiguration find_best_configuration(int tree_height) const {
-    auto [it, inserted] = best_config_.try_emplace(tree_height);
+    auto [it, inserted] = best_config_.try_emplace({accuracy_, tree_height});
     if (inserted) {
       auto config = FmmAccuracyEstimator<Kernel>::find_best_configuration(
           rbf_, accuracy_, particles_, box_, tree_height);
@@ -221,7 +221,6 @@ class FmmGenericSymmetricEvaluator<Kernel>::Impl {
 
   void prepare() const {
     if (n_points_ < 1024) {
-      interpolator_.reset(nullptr);
       far_field_.reset(nullptr);
       fmm_operator_.reset(nullptr);
       tree_.reset(nullptr);
@@ -238,9 +237,11 @@ class FmmGenericSymmetricEvaluator<Kernel>::Impl {
 
     auto config = find_best_configuration(tree_height);
     if (config != config_) {
-      interpolator_ = std::make_unique<Interpolator>(kernel_, config.order, tree_height,
-                                                     box_.width(0), config.d);
-      far_field_ = std::make_unique<FarField>(*interpolator_);
+      auto [it, inserted] = interpolator_cache_.try_emplace(config, kernel_, config.order,
+                                                            tree_height, box_.width(0), config.d);
+      interpolator_cache_.touch(it);
+
+      far_field_ = std::make_unique<FarField>(it->second);
       fmm_operator_ = std::make_unique<FmmOperator>(near_field_, *far_field_);
       tree_.reset(nullptr);
       config_ = config;
@@ -262,11 +263,11 @@ class FmmGenericSymmetricEvaluator<Kernel>::Impl {
   mutable Container particles_;
   mutable int sorted_level_{};
   mutable InterpolatorConfiguration config_{};
-  mutable std::unique_ptr<Interpolator> interpolator_;
   mutable std::unique_ptr<FarField> far_field_;
   mutable std::unique_ptr<FmmOperator> fmm_operator_;
   mutable std::unique_ptr<Tree> tree_;
-  mutable std::unordered_map<int, InterpolatorConfiguration> best_config_;
+  mutable std::map<std::pair<double, int>, InterpolatorConfiguration> best_config_;
+  mutable LruCache<InterpolatorConfiguration, Interpolator> interpolator_cache_{2};
 };
 
 template <class Kernel>
@@ -4,11 +4,15 @@
 #include <polatory/isosurface/dense_undirected_graph.hpp>
 #include <polatory/isosurface/mesh_defects_finder.hpp>
 #include <unordered_map>
+#include <vector>
 
 namespace polatory::isosurface {
 
 MeshDefectsFinder::MeshDefectsFinder(const Mesh& mesh)
-    : vertices_(mesh.vertices()), faces_(mesh.faces()), vf_map_(vertices_.rows()) {
+    : MeshDefectsFinder(mesh.vertices(), mesh.faces()) {}
+
+MeshDefectsFinder::MeshDefectsFinder(const Points& vertices, const Faces& faces)
+    : vertices_(vertices), faces_(faces), vf_map_(vertices_.rows()) {
   auto n_faces = faces_.rows();
   for (Index fi = 0; fi < n_faces; fi++) {
     auto f = faces_.row(fi);
@@ -18,7 +22,6 @@ MeshDefectsFinder::MeshDefectsFinder(const Mesh& mesh)
   }
 }
 
-// Currently, only intersections between faces that share a single vertex are checked.
 std::vector<Index> MeshDefectsFinder::intersecting_faces() const {
   std::vector<Index> result;
 
@@ -29,30 +32,31 @@ std::vector<Index> MeshDefectsFinder::intersecting_faces() const {
 
 #pragma omp for schedule(guided)
     for (Index vi = 0; vi < n_vertices; vi++) {
-      const auto& fis = vf_map_.at(vi);
-
-      auto n_faces = static_cast<Index>(fis.size());
-      for (Index i = 0; i < n_faces - 1; i++) {
-        auto fi = fis.at(i);
-        auto a = next_vertex(fi, vi);
-        auto b = prev_vertex(fi, vi);
-        for (Index j = i + 1; j < n_faces; j++) {
-          auto fj = fis.at(j);
-          auto c = next_vertex(fj, vi);
-          auto d = prev_vertex(fj, vi);
-
-          if (b == c || a == d || a == c || b == d) {
-            // Skip pairs of adjacent faces.
-            // The last two conditions are included for handling faces around non-manifold edges.
-            continue;
-          }
-
-          if (edge_face_intersect(a, b, fj) || edge_face_intersect(c, d, fi)) {
-            local_result.push_back(fi);
-            local_result.push_back(fj);
-          }
-        }
-      }
+      find_intersecting_faces_around(vi, local_result);
+    }
+
+#pragma omp critical
+    result.insert(result.end(), local_result.begin(), local_result.end());
+  }
+
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+
+  return result;
+}
+
+std::vector<Index> MeshDefectsFinder::intersecting_faces(const std::vector<Index>& vis) const {
+  std::vector<Index> result;
+
+  auto vis_to_check = neighborhood(vis);
+  auto n_vertices = static_cast<Index>(vis_to_check.size());
+#pragma omp parallel
+  {
+    std::vector<Index> local_result;
+
+#pragma omp for schedule(guided)
+    for (Index i = 0; i < n_vertices; i++) {
+      find_intersecting_faces_around(vis_to_check.at(i), local_result);
     }
 
 #pragma omp critical
@@ -75,33 +79,31 @@ std::vector<Index> MeshDefectsFinder::singular_vertices() const {
 
 #pragma omp for schedule(guided)
     for (Index vi = 0; vi < n_vertices; vi++) {
-      const auto& fis = vf_map_.at(vi);
-
-      if (fis.empty()) {
-        // An isolated vertex.
-        continue;
+      if (is_singular(vi)) {
+        local_result.push_back(vi);
       }
+    }
 
-      std::unordered_map<Index, Index> to_local_vi;
-      for (auto fi : fis) {
-        to_local_vi.emplace(next_vertex(fi, vi), to_local_vi.size());
-        to_local_vi.emplace(prev_vertex(fi, vi), to_local_vi.size());
-      }
+#pragma omp critical
+    result.insert(result.end(), local_result.begin(), local_result.end());
+  }
 
-      auto order = static_cast<Index>(to_local_vi.size());
+  return result;
+}
 
-      // The graph that represents the link complex of the vertex.
-      DenseUndirectedGraph g(order);
+std::vector<Index> MeshDefectsFinder::singular_vertices(const std::vector<Index>& vis) const {
+  std::vector<Index> result;
 
-      for (auto fi : fis) {
-        auto i = to_local_vi.at(next_vertex(fi, vi));
-        auto j = to_local_vi.at(prev_vertex(fi, vi));
-        g.add_edge(i, j);
-      }
+  auto vis_to_check = neighborhood(vis);
+  auto n_vertices = static_cast<Index>(vis_to_check.size());
+#pragma omp parallel
+  {
+    std::vector<Index> local_result;
 
-      // Check if the graph is a cycle or a path (in case of a boundary vertex).
-      // NOLINTNEXTLINE(readability-simplify-boolean-expr)
-      if (!(g.is_simple() && g.is_connected() && g.max_degree() <= 2)) {
+#pragma omp for schedule(guided)
+    for (Index i = 0; i < n_vertices; i++) {
+      auto vi = vis_to_check.at(i);
+      if (is_singular(vi)) {
         local_result.push_back(vi);
       }
     }
@@ -113,6 +115,80 @@ std::vector<Index> MeshDefectsFinder::singular_vertices() const {
   return result;
 }
 
+// Currently, only intersections between faces that share a single vertex are checked.
+void MeshDefectsFinder::find_intersecting_faces_around(Index vi, std::vector<Index>& result) const {
+  const auto& fis = vf_map_.at(vi);
+
+  auto n_faces = static_cast<Index>(fis.size());
+  for (Index i = 0; i < n_faces - 1; i++) {
+    auto fi = fis.at(i);
+    auto a = next_vertex(fi, vi);
+    auto b = prev_vertex(fi, vi);
+    for (Index j = i + 1; j < n_faces; j++) {
+      auto fj = fis.at(j);
+      auto c = next_vertex(fj, vi);
+      auto d = prev_vertex(fj, vi);
+
+      if (b == c || a == d || a == c || b == d) {
+        // Skip pairs of adjacent faces.
+        // The last two conditions are included for handling faces around non-manifold edges.
+        continue;
+      }
+
+      if (edge_face_intersect(a, b, fj) || edge_face_intersect(c, d, fi)) {
+        result.push_back(fi);
+        result.push_back(fj);
+      }
+    }
+  }
+}
+
+bool MeshDefectsFinder::is_singular(Index vi) const {
+  const auto& fis = vf_map_.at(vi);
+
+  if (fis.empty()) {
+    // An isolated vertex.
+    return false;
+  }
+
+  std::unordered_map<Index, Index> to_local_vi;
+  for (auto fi : fis) {
+    to_local_vi.emplace(next_vertex(fi, vi), to_local_vi.size());
+    to_local_vi.emplace(prev_vertex(fi, vi), to_local_vi.size());
+  }
+
+  auto order = static_cast<Index>(to_local_vi.size());
+
+  // The graph that represents the link complex of the vertex.
+  DenseUndirectedGraph g(order);
+
+  for (auto fi : fis) {
+    auto i = to_local_vi.at(next_vertex(fi, vi));
+    auto j = to_local_vi.at(prev_vertex(fi, vi));
+    g.add_edge(i, j);
+  }
+
+  // Check if the graph is a cycle or a path (in case of a boundary vertex).
+  // NOLINTNEXTLINE(readability-simplify-boolean-expr)
+  return !(g.is_simple() && g.is_connected() && g.max_degree() <= 2);
+}
+
+// Returns the vertices in vis and the ones that share a face with them, in ascending order.
+std::vector<Index> MeshDefectsFinder::neighborhood(const std::vector<Index>& vis) const {
+  std::vector<Index> result(vis);
+  for (auto vi : vis) {
+    for (auto fi : vf_map_.at(vi)) {
+      auto f = faces_.row(fi);
+      result.insert(result.end(), f.begin(), f.end());
+    }
+  }
+
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+
+  return result;
+}
+
 Index MeshDefectsFinder::next_vertex(Index fi, Index vi) const {
   auto f = faces_.row(fi);
   if (f(0) == vi) {
@@ -5,6 +5,12 @@ namespace polatory::krylov {
 Fgmres::Fgmres(const LinearOperator& op, const VecX& rhs, Index max_iter)
     : Gmres(op, rhs, max_iter) {}
 
+void Fgmres::setup() {
+  zs_ = KrylovBasis(m_, max_iter_, out_of_core_);
+
+  Gmres::setup();
+}
+
 VecX Fgmres::solution_vector() const {
   // r is an upper triangular matrix.
   // Perform backward substitution to solve r y == g for y.
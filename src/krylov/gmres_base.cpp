@@ -26,6 +26,8 @@ void GmresBase::set_initial_solution(const VecX& x0) {
   x0_ = x0;
 }
 
+void GmresBase::set_out_of_core(bool out_of_core) { out_of_core_ = out_of_core; }
+
 void GmresBase::set_right_preconditioner(const LinearOperator& right_preconditioner) {
   POLATORY_ASSERT(right_preconditioner.size() == m_);
 
@@ -38,10 +40,12 @@ void GmresBase::setup() {
 
   g_ = VecX::Zero(max_iter_ + 1);
 
+  vs_ = KrylovBasis(m_, max_iter_ + 1, out_of_core_);
+
   VecX r0 = x0_.isZero() ? rhs_ : rhs_ - op_(x0_);
   r0 = left_preconditioned(r0);
   g_(0) = r0.norm();
-  vs_.emplace_back(r0 / g_(0));
+  vs_.push_back(r0 / g_(0));
 
   r_ = MatX::Zero(max_iter_ + 1, max_iter_);
 }
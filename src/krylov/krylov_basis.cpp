@@ -0,0 +1,60 @@
+#include <polatory/common/macros.hpp>
+#include <polatory/krylov/krylov_basis.hpp>
+#include <stdexcept>
+
+namespace polatory::krylov {
+
+KrylovBasis::KrylovBasis() = default;
+
+KrylovBasis::KrylovBasis(Index dim, Index capacity, bool out_of_core)
+    : dim_(dim), capacity_(capacity) {
+  if (out_of_core && dim > 0 && capacity > 0) {
+    file_ = std::make_unique<common::MappedFile>(sizeof(double) * dim * capacity);
+  }
+}
+
+KrylovBasis::~KrylovBasis() = default;
+
+KrylovBasis::KrylovBasis(KrylovBasis&&) noexcept = default;
+
+KrylovBasis& KrylovBasis::operator=(KrylovBasis&&) noexcept = default;
+
+Eigen::Map<VecX> KrylovBasis::at(Index i) {
+  POLATORY_ASSERT(i >= 0 && i < size_);
+
+  if (file_) {
+    return {static_cast<double*>(file_->data()) + dim_ * i, dim_};
+  }
+
+  return {vectors_.at(i).data(), dim_};
+}
+
+Eigen::Map<const VecX> KrylovBasis::at(Index i) const {
+  POLATORY_ASSERT(i >= 0 && i < size_);
+
+  if (file_) {
+    return {static_cast<double*>(file_->data()) + dim_ * i, dim_};
+  }
+
+  return {vectors_.at(i).data(), dim_};
+}
+
+void KrylovBasis::push_back(const VecX& v) {
+  POLATORY_ASSERT(v.rows() == dim_);
+
+  if (size_ == capacity_) {
+    throw std::runtime_error("the capacity of the Krylov basis is exceeded");
+  }
+
+  if (file_) {
+    size_++;
+    at(size_ - 1) = v;
+  } else {
+    vectors_.push_back(v);
+    size_++;
+  }
+}
+
+Index KrylovBasis::size() const { return size_; }
+
+}  // namespace polatory::krylov
@@ -1,73 +1,270 @@
-// https://github.com/flann-lib/flann/issues/386
-using pop_t = unsigned long long;
-
 #include <algorithm>
+#include <array>
 #include <cmath>
-#include <flann/flann.hpp>
+#include <limits>
+#include <numeric>
+#include <polatory/common/macros.hpp>
 #include <polatory/point_cloud/kdtree.hpp>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace polatory::point_cloud {
 
+// An implicit k-d tree. The points are split at the median of the coordinate
+// with the largest spread until each leaf has at most kMaxLeafSize points.
+// The point range of each node is determined by its level and position,
+// so the nodes only hold the splitting planes.
+// The coordinates are stored per dimension in the tree order, so that each leaf
+// is scanned with contiguous loads.
 template <int Dim>
 class KdTree<Dim>::Impl {
-  using FlannIndex = flann::Index<flann::L2<double>>;
-  using Point = geometry::Point<Dim>;
-  using Points = geometry::Points<Dim>;
+  static constexpr Index kMaxLeafSize = 16;
+  static constexpr double kInfinity = std::numeric_limits<double>::infinity();
+  using Offsets = std::array<double, Dim>;
+
+  // The neighbors found so far, sorted by distance, stored in the output buffers.
+  struct Neighbors {
+    Index* indices;
+    double* distances;
+    Index capacity;
+    Index size;
+    double max_distance_sq;
+  };
 
  public:
-  explicit Impl(const Points& points) {
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-    flann::Matrix<double> points_mat(const_cast<double*>(points.data()), points.rows(), Dim);
+  explicit Impl(const Points& points) : n_points_(points.rows()) {
+    while (((n_points_ + (Index{1} << depth_) - 1) >> depth_) > kMaxLeafSize) {
+      depth_++;
+    }
+
+    // The points are partitioned in place together with their indices.
+    std::vector<std::pair<Point, Index>> entries;
+    entries.reserve(n_points_);
+    for (Index i = 0; i < n_points_; i++) {
+      entries.emplace_back(points.row(i), i);
+    }
+
+    auto n_internal_nodes = (Index{1} << depth_) - 1;
+    split_dims_.resize(n_internal_nodes);
+    split_values_.resize(n_internal_nodes);
+
+    for (auto level = 0; level < depth_; level++) {
+      auto n_nodes = Index{1} << level;
+
+#pragma omp parallel for schedule(dynamic)
+      for (Index j = 0; j < n_nodes; j++) {
+        auto begin = entries.begin() + range_begin(level, j);
+        auto end = entries.begin() + range_begin(level, j + 1);
+        auto mid = entries.begin() + range_begin(level + 1, 2 * j + 1);
+
+        Point min = begin->first;
+        Point max = min;
+        for (auto it = begin + 1; it < end; ++it) {
+          min = min.cwiseMin(it->first);
+          max = max.cwiseMax(it->first);
+        }
+
+        int dim{};
+        (max - min).maxCoeff(&dim);
 
-    flann_index_ = std::make_unique<FlannIndex>(points_mat, flann::KDTreeSingleIndexParams());
-    flann_index_->buildIndex();
+        std::nth_element(begin, mid, end, [dim](const auto& a, const auto& b) {
+          return a.first(dim) < b.first(dim);
+        });
 
-    search_params_.checks = flann::FLANN_CHECKS_UNLIMITED;
-    search_params_.sorted = false;
+        auto node = n_nodes - 1 + j;
+        split_dims_.at(node) = dim;
+        split_values_.at(node) = mid->first(dim);
+      }
+    }
+
+    indices_.resize(n_points_);
+    for (auto d = 0; d < Dim; d++) {
+      coords_.at(d).resize(n_points_);
+    }
+    for (Index i = 0; i < n_points_; i++) {
+      const auto& [p, index] = entries.at(i);
+      indices_.at(i) = index;
+      for (auto d = 0; d < Dim; d++) {
+        coords_.at(d).at(i) = p(d);
+      }
+    }
+  }
+
+  // Returns the order in which the points should be queried for locality,
+  // which is the order of the leaves containing them.
+  std::vector<Index> query_order(const Points& points) const {
+    auto n_points = points.rows();
+    auto n_leaves = Index{1} << depth_;
+
+    std::vector<Index> leaves(n_points);
+#pragma omp parallel for schedule(static)
+    for (Index i = 0; i < n_points; i++) {
+      Index node = 0;
+      for (auto level = 0; level < depth_; level++) {
+        auto diff = points(i, split_dims_[node]) - split_values_[node];
+        node = 2 * node + (diff < 0.0 ? 1 : 2);
+      }
+      leaves.at(i) = node - (n_leaves - 1);
+    }
+
+    std::vector<Index> offsets(n_leaves + 1);
+    for (auto leaf : leaves) {
+      offsets.at(leaf + 1)++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    std::vector<Index> order(n_points);
+    for (Index i = 0; i < n_points; i++) {
+      order.at(offsets.at(leaves.at(i))++) = i;
+    }
+
+    return order;
   }
 
   void knn_search(const Point& point, Index k, std::vector<Index>& indices,
                   std::vector<double>& distances) const {
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-    flann::Matrix<double> point_mat(const_cast<double*>(point.data()), 1, Dim);
+    k = std::min(k, n_points_);
+    indices.resize(k);
+    distances.resize(k);
 
-    (void)flann_index_->knnSearch(point_mat, indices_v_, distances_v_, k, search_params_);
+    Neighbors nbrs{indices.data(), distances.data(), k, 0, kInfinity};
+    Offsets offsets{};
+    search(point, 0, 0, 0.0, offsets, nbrs);
 
-    indices.resize(indices_v_[0].size());
-    distances.resize(distances_v_[0].size());
+    for (auto& d : distances) {
+      d = std::sqrt(d);
+    }
+  }
 
-    std::transform(indices_v_[0].begin(), indices_v_[0].end(), indices.begin(),
-                   [](auto i) { return static_cast<Index>(i); });
+  void radius_search(const Point& point, double radius, std::vector<Index>& indices,
+                     std::vector<double>& distances) const {
+    indices.clear();
+    distances.clear();
 
-    std::transform(distances_v_[0].begin(), distances_v_[0].end(), distances.begin(),
-                   [](auto d) { return std::sqrt(d); });
+    auto radius_sq = radius * radius;
+    Offsets offsets{};
+    search_radius(point, 0, 0, 0.0, offsets, radius_sq, indices, distances);
+
+    for (auto& d : distances) {
+      d = std::sqrt(d);
+    }
   }
 
-  void radius_search(const Point& point, double radius, std::vector<Index>& indices,
+ private:
+  // Returns the beginning of the point range of the j-th node at the level.
+  Index range_begin(int level, Index j) const { return (j * n_points_) >> level; }
+
+  // Computes the squared distances from the point to the points in the leaf.
+  Index scan_leaf(const Point& point, Index node, double* distances_sq, Index& begin) const {
+    auto j = node - ((Index{1} << depth_) - 1);
+    begin = range_begin(depth_, j);
+    auto size = range_begin(depth_, j + 1) - begin;
+    POLATORY_ASSERT(size <= kMaxLeafSize);
+
+    std::fill(distances_sq, distances_sq + size, 0.0);
+    for (auto d = 0; d < Dim; d++) {
+      const auto* coords = coords_[d].data() + begin;
+      auto x = point(d);
+      for (Index i = 0; i < size; i++) {
+        auto diff = coords[i] - x;
+        distances_sq[i] += diff * diff;
+      }
+    }
+
+    return size;
+  }
+
+  // offsets holds the signed distances from the point to the cell of the node along each axis,
+  // and distance_sq is their squared sum.
+  void search(const Point& point, Index node, int level, double distance_sq, Offsets& offsets,
+              Neighbors& nbrs) const {
+    if (level == depth_) {
+      std::array<double, kMaxLeafSize> distances_sq;
+      Index begin{};
+      auto size = scan_leaf(point, node, distances_sq.data(), begin);
+      for (Index i = 0; i < size; i++) {
+        if (distances_sq.at(i) < nbrs.max_distance_sq) {
+          insert(nbrs, indices_[begin + i], distances_sq.at(i));
+        }
+      }
+      return;
+    }
+
+    auto dim = split_dims_[node];
+    auto diff = point(dim) - split_values_[node];
+    auto near = 2 * node + (diff < 0.0 ? 1 : 2);
+    auto far = 2 * node + (diff < 0.0 ? 2 : 1);
+
+    search(point, near, level + 1, distance_sq, offsets, nbrs);
+
+    auto old_offset = offsets.at(dim);
+    auto far_distance_sq = distance_sq - old_offset * old_offset + diff * diff;
+    if (far_distance_sq < nbrs.max_distance_sq) {
+      offsets.at(dim) = diff;
+      search(point, far, level + 1, far_distance_sq, offsets, nbrs);
+      offsets.at(dim) = old_offset;
+    }
+  }
+
+  void search_radius(const Point& point, Index node, int level, double distance_sq,
+                     Offsets& offsets, double radius_sq, std::vector<Index>& indices,
                      std::vector<double>& distances) const {
-    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
-    flann::Matrix<double> point_mat(const_cast<double*>(point.data()), 1, Dim);
+    if (level == depth_) {
+      std::array<double, kMaxLeafSize> distances_sq;
+      Index begin{};
+      auto size = scan_leaf(point, node, distances_sq.data(), begin);
+      for (Index i = 0; i < size; i++) {
+        if (distances_sq.at(i) <= radius_sq) {
+          indices.push_back(indices_[begin + i]);
+          distances.push_back(distances_sq.at(i));
+        }
+      }
+      return;
+    }
 
-    auto radius_sq = static_cast<float>(radius * radius);
-    (void)flann_index_->radiusSearch(point_mat, indices_v_, distances_v_, radius_sq,
-                                     search_params_);
+    auto dim = split_dims_[node];
+    auto diff = point(dim) - split_values_[node];
+    auto near = 2 * node + (diff < 0.0 ? 1 : 2);
+    auto far = 2 * node + (diff < 0.0 ? 2 : 1);
 
-    indices.resize(indices_v_[0].size());
-    distances.resize(distances_v_[0].size());
+    search_radius(point, near, level + 1, distance_sq, offsets, radius_sq, indices, distances);
 
-    std::transform(indices_v_[0].begin(), indices_v_[0].end(), indices.begin(),
-                   [](auto i) { return static_cast<Index>(i); });
+    auto old_offset = offsets.at(dim);
+    auto far_distance_sq = distance_sq - old_offset * old_offset + diff * diff;
+    if (far_distance_sq <= radius_sq) {
+      offsets.at(dim) = diff;
+      search_radius(point, far, level + 1, far_distance_sq, offsets, radius_sq, indices,
+                    distances);
+      offsets.at(dim) = old_offset;
+    }
+  }
+
+  // Inserts a neighbor, dropping the farthest one if full.
+  static void insert(Neighbors& nbrs, Index index, double distance_sq) {
+    auto i = std::min(nbrs.size, nbrs.capacity - 1);
+    while (i > 0 && nbrs.distances[i - 1] > distance_sq) {
+      nbrs.indices[i] = nbrs.indices[i - 1];
+      nbrs.distances[i] = nbrs.distances[i - 1];
+      i--;
+    }
+    nbrs.indices[i] = index;
+    nbrs.distances[i] = distance_sq;
 
-    std::transform(distances_v_[0].begin(), distances_v_[0].end(), distances.begin(),
-                   [](auto d) { return std::sqrt(d); });
+    if (nbrs.size < nbrs.capacity) {
+      nbrs.size++;
+    }
+    if (nbrs.size == nbrs.capacity) {
+      nbrs.max_distance_sq = nbrs.distances[nbrs.capacity - 1];
+    }
   }
 
- private:
-  static thread_local inline std::vector<std::vector<std::size_t>> indices_v_;
-  static thread_local inline std::vector<std::vector<double>> distances_v_;
-  flann::SearchParams search_params_;
-  std::unique_ptr<FlannIndex> flann_index_;
+  Index n_points_;
+  int depth_{};
+  std::vector<int> split_dims_;
+  std::vector<double> split_values_;
+  std::vector<Index> indices_;
+  std::array<std::vector<double>, Dim> coords_;
 };
 
 template <int Dim>
@@ -85,12 +282,43 @@ void KdTree<Dim>::knn_search(const Point& point, Index k, std::vector<Index>& in
   }
 
   if (!impl_) {
+    indices.clear();
+    distances.clear();
     return;
   }
 
   impl_->knn_search(point, k, indices, distances);
 }
 
+template <int Dim>
+void KdTree<Dim>::knn_search_batch(const Points& points, Index k,
+                                   std::vector<std::vector<Index>>& indices,
+                                   std::vector<std::vector<double>>& distances) const {
+  if (k <= 0) {
+    throw std::invalid_argument("k must be positive");
+  }
+
+  auto n_points = points.rows();
+  indices.resize(n_points);
+  distances.resize(n_points);
+
+  if (!impl_) {
+    for (Index i = 0; i < n_points; i++) {
+      indices.at(i).clear();
+      distances.at(i).clear();
+    }
+    return;
+  }
+
+  auto order = impl_->query_order(points);
+
+#pragma omp parallel for schedule(guided)
+  for (Index j = 0; j < n_points; j++) {
+    auto i = order.at(j);
+    impl_->knn_search(points.row(i), k, indices.at(i), distances.at(i));
+  }
+}
+
 template <int Dim>
 void KdTree<Dim>::radius_search(const Point& point, double radius, std::vector<Index>& indices,
                                 std::vector<double>& distances) const {
@@ -99,12 +327,43 @@ void KdTree<Dim>::radius_search(const Point& point, double radius, std::vector<I
   }
 
   if (!impl_) {
+    indices.clear();
+    distances.clear();
     return;
   }
 
   impl_->radius_search(point, radius, indices, distances);
 }
 
+template <int Dim>
+void KdTree<Dim>::radius_search_batch(const Points& points, double radius,
+                                      std::vector<std::vector<Index>>& indices,
+                                      std::vector<std::vector<double>>& distances) const {
+  if (!(radius >= 0.0)) {
+    throw std::invalid_argument("radius must be non-negative");
+  }
+
+  auto n_points = points.rows();
+  indices.resize(n_points);
+  distances.resize(n_points);
+
+  if (!impl_) {
+    for (Index i = 0; i < n_points; i++) {
+      indices.at(i).clear();
+      distances.at(i).clear();
+    }
+    return;
+  }
+
+  auto order = impl_->query_order(points);
+
+#pragma omp parallel for schedule(guided)
+  for (Index j = 0; j < n_points; j++) {
+    auto i = order.at(j);
+    impl_->radius_search(points.row(i), radius, indices.at(i), distances.at(i));
+  }
+}
+
 template class KdTree<1>;
 template class KdTree<2>;
 template class KdTree<3>;
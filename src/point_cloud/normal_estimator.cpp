@@ -9,6 +9,9 @@
 #include <polatory/point_cloud/plane_estimator.hpp>
 #include <queue>
 #include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace polatory::point_cloud {
 
@@ -36,36 +39,55 @@ NormalEstimator& NormalEstimator::estimate_with_knn(const std::vector<Index>& ks
     return *this;
   }
 
-  std::vector<Index> nn_indices;
-  std::vector<double> nn_distances;
+  std::vector<std::vector<Index>> nn_indices;
+  std::vector<std::vector<double>> nn_distances;
 
   std::vector<Index> ks_sorted(ks);
-  std::sort(ks_sorted.rbegin(), ks_sorted.rend());
-  auto k_max = ks_sorted.front();
+  std::sort(ks_sorted.begin(), ks_sorted.end());
+  auto k_max = ks_sorted.back();
 
   std::vector<double> plane_factors;
   std::vector<geometry::Vector3> plane_normals;
 
-#pragma omp parallel for schedule(guided) private(nn_indices, nn_distances, plane_factors, \
-                                                      plane_normals)
-  for (Index i = 0; i < n_points_; i++) {
-    geometry::Point3 p = points_.row(i);
-    tree_.knn_search(p, k_max, nn_indices, nn_distances);
-
-    plane_factors.clear();
-    plane_normals.clear();
-    for (auto k : ks_sorted) {
-      nn_indices.resize(k);
-      PlaneEstimator est(points_(nn_indices, Eigen::all));
-      plane_factors.push_back(est.plane_factor());
-      plane_normals.push_back(est.plane_normal());
-    }
+  // The neighbors are searched in batches to bound the memory usage.
+  for (Index begin = 0; begin < n_points_; begin += kBatchSize) {
+    auto end = std::min(begin + kBatchSize, n_points_);
+    tree_.knn_search_batch(points_.middleRows(begin, end - begin), k_max, nn_indices,
+                           nn_distances);
+
+#pragma omp parallel for schedule(guided) private(plane_factors, plane_normals)
+    for (Index i = begin; i < end; i++) {
+      geometry::Point3 p = points_.row(i);
+      const auto& nn_idcs = nn_indices.at(i - begin);
+      auto n_nn = static_cast<Index>(nn_idcs.size());
+
+      // The neighbors are sorted by distance, so the moments for all ks
+      // are accumulated in a single pass.
+      geometry::Vector3 sum = geometry::Vector3::Zero();
+      Mat3 sum_sq = Mat3::Zero();
+      Index n{};
+
+      plane_factors.clear();
+      plane_normals.clear();
+      for (auto k : ks_sorted) {
+        for (; n < std::min(k, n_nn); n++) {
+          geometry::Vector3 d = points_.row(nn_idcs.at(n)) - p;
+          sum += d;
+          sum_sq += d.transpose() * d;
+        }
+        PlaneEstimator est(sum_sq - sum.transpose() * sum / static_cast<double>(n), n);
+        plane_factors.push_back(est.plane_factor());
+        plane_normals.push_back(est.plane_normal());
+      }
 
-    auto best = std::distance(plane_factors.begin(),
-                              std::max_element(plane_factors.begin(), plane_factors.end()));
+      // Ties are resolved in favor of the largest k.
+      auto best = std::distance(std::max_element(plane_factors.rbegin(), plane_factors.rend()),
+                                plane_factors.rend()) -
+                  1;
 
-    normals_.row(i) = plane_normals.at(best);
-    plane_factors_(i) = plane_factors.at(best);
+      normals_.row(i) = plane_normals.at(best);
+      plane_factors_(i) = plane_factors.at(best);
+    }
   }
 
   estimated_ = true;
@@ -88,46 +110,66 @@ NormalEstimator& NormalEstimator::estimate_with_radius(const std::vector<double>
   normals_ = geometry::Points3::Zero(n_points_, 3);
   plane_factors_ = VecX::Zero(n_points_);
 
-  std::vector<Index> nn_indices;
-  std::vector<double> nn_distances;
+  std::vector<std::vector<Index>> nn_indices;
+  std::vector<std::vector<double>> nn_distances;
 
   std::vector<double> radii_sorted(radii);
-  std::sort(radii_sorted.rbegin(), radii_sorted.rend());
-  auto radius_max = radii_sorted.front();
+  std::sort(radii_sorted.begin(), radii_sorted.end());
+  auto radius_max = radii_sorted.back();
 
   std::vector<double> plane_factors;
   std::vector<geometry::Vector3> plane_normals;
 
-#pragma omp parallel for schedule(guided) private(nn_indices, nn_distances, plane_factors, \
-                                                      plane_normals)
-  for (Index i = 0; i < n_points_; i++) {
-    geometry::Point3 p = points_.row(i);
-    tree_.radius_search(p, radius_max, nn_indices, nn_distances);
+  // The neighbors are searched in batches to bound the memory usage.
+  for (Index begin = 0; begin < n_points_; begin += kBatchSize) {
+    auto end = std::min(begin + kBatchSize, n_points_);
+    tree_.radius_search_batch(points_.middleRows(begin, end - begin), radius_max, nn_indices,
+                              nn_distances);
 
-    if (nn_indices.size() < 3) {
-      continue;
-    }
+#pragma omp parallel for schedule(guided) private(plane_factors, plane_normals)
+    for (Index i = begin; i < end; i++) {
+      geometry::Point3 p = points_.row(i);
+      auto& nn_idcs = nn_indices.at(i - begin);
+      auto& nn_dists = nn_distances.at(i - begin);
 
-    common::zip_sort(nn_indices.begin(), nn_indices.end(), nn_distances.begin(),
-                     [](const auto& a, const auto& b) { return a.second < b.second; });
-
-    plane_factors.clear();
-    plane_normals.clear();
-    for (auto radius : radii_sorted) {
-      auto it = std::upper_bound(nn_distances.begin(), nn_distances.end(), radius);
-      auto k = std::distance(nn_distances.begin(), it);
-      nn_indices.resize(k);
-      nn_distances.resize(k);
-      PlaneEstimator est(points_(nn_indices, Eigen::all));
-      plane_factors.push_back(est.plane_factor());
-      plane_normals.push_back(est.plane_normal());
-    }
+      if (nn_idcs.size() < 3) {
+        continue;
+      }
+
+      common::zip_sort(nn_idcs.begin(), nn_idcs.end(), nn_dists.begin(),
+                       [](const auto& a, const auto& b) { return a.second < b.second; });
+
+      // The moments for all radii are accumulated in a single pass over the sorted neighbors.
+      geometry::Vector3 sum = geometry::Vector3::Zero();
+      Mat3 sum_sq = Mat3::Zero();
+      Index n{};
+
+      plane_factors.clear();
+      plane_normals.clear();
+      for (auto radius : radii_sorted) {
+        auto it = std::upper_bound(nn_dists.begin(), nn_dists.end(), radius);
+        auto k = std::distance(nn_dists.begin(), it);
+        for (; n < k; n++) {
+          geometry::Vector3 d = points_.row(nn_idcs.at(n)) - p;
+          sum += d;
+          sum_sq += d.transpose() * d;
+        }
+        if (n < 3) {
+          continue;
+        }
+        PlaneEstimator est(sum_sq - sum.transpose() * sum / static_cast<double>(n), n);
+        plane_factors.push_back(est.plane_factor());
+        plane_normals.push_back(est.plane_normal());
+      }
 
-    auto best = std::distance(plane_factors.begin(),
-                              std::max_element(plane_factors.begin(), plane_factors.end()));
+      // Ties are resolved in favor of the largest radius.
+      auto best = std::distance(std::max_element(plane_factors.rbegin(), plane_factors.rend()),
+                                plane_factors.rend()) -
+                  1;
 
-    normals_.row(i) = plane_normals.at(best);
-    plane_factors_(i) = plane_factors.at(best);
+      normals_.row(i) = plane_normals.at(best);
+      plane_factors_(i) = plane_factors.at(best);
+    }
   }
 
   estimated_ = true;
@@ -279,4 +321,317 @@ NormalEstimator& NormalEstimator::orient_closed_surface(Index k) & {
   return *this;
 }
 
+NormalEstimator& NormalEstimator::orient_closed_surface_by_patches(Index k, Index patch_size) & {
+  throw_if_not_estimated();
+
+  if (k <= 0) {
+    throw std::runtime_error("k must be positive");
+  }
+
+  if (patch_size <= 0) {
+    throw std::runtime_error("patch_size must be positive");
+  }
+
+  geometry::Vector3 seed_point_direction{-geometry::Vector3::UnitY()};
+
+  // Split the points into patches by recursively splitting them at the median
+  // of the coordinate with the largest spread.
+  std::vector<Index> order(n_points_);
+  std::iota(order.begin(), order.end(), Index{0});
+  std::vector<Index> bounds{0, n_points_};
+  while (true) {
+    auto n_patches = static_cast<Index>(bounds.size()) - 1;
+    std::vector<Index> mids(n_patches, -1);
+
+#pragma omp parallel for schedule(dynamic)
+    for (Index j = 0; j < n_patches; j++) {
+      auto begin = order.begin() + bounds.at(j);
+      auto end = order.begin() + bounds.at(j + 1);
+      if (end - begin <= patch_size) {
+        continue;
+      }
+
+      geometry::Point3 min = points_.row(*begin);
+      geometry::Point3 max = min;
+      for (auto it = begin + 1; it < end; ++it) {
+        min = min.cwiseMin(points_.row(*it));
+        max = max.cwiseMax(points_.row(*it));
+      }
+
+      int dim{};
+      (max - min).maxCoeff(&dim);
+
+      auto mid = begin + (end - begin) / 2;
+      std::nth_element(begin, mid, end,
+                       [&](auto a, auto b) { return points_(a, dim) < points_(b, dim); });
+      mids.at(j) = static_cast<Index>(std::distance(order.begin(), mid));
+    }
+
+    if (std::all_of(mids.begin(), mids.end(), [](auto mid) { return mid < 0; })) {
+      break;
+    }
+
+    std::vector<Index> new_bounds;
+    for (Index j = 0; j < n_patches; j++) {
+      new_bounds.push_back(bounds.at(j));
+      if (mids.at(j) >= 0) {
+        new_bounds.push_back(mids.at(j));
+      }
+    }
+    new_bounds.push_back(n_points_);
+    bounds = std::move(new_bounds);
+  }
+
+  auto n_patches = static_cast<Index>(bounds.size()) - 1;
+  std::vector<Index> patch_of(n_points_);
+  std::vector<Index> position_of(n_points_);
+  for (Index j = 0; j < n_patches; j++) {
+    for (auto it = bounds.at(j); it < bounds.at(j + 1); it++) {
+      patch_of.at(order.at(it)) = j;
+      position_of.at(order.at(it)) = it;
+    }
+  }
+
+  // Each patch is oriented independently with the same propagation as orient_closed_surface.
+  // The resulting connected components within the patches are called fragments.
+  // Each thread only writes to the elements of the points in its own patch.
+  std::vector<char> oriented(n_points_);
+  std::vector<Index> fragment_of(n_points_, -1);
+  for (Index i = 0; i < n_points_; i++) {
+    oriented.at(i) = normals_.row(i).isZero();
+  }
+
+  // The seed point of each fragment, i.e., its farthest point in seed_point_direction.
+  std::vector<std::vector<Index>> fragment_seeds(n_patches);
+  // The pairs of neighboring points which lie in different patches.
+  std::vector<std::vector<std::pair<Index, Index>>> boundary_pairs(n_patches);
+
+#pragma omp parallel
+  {
+    std::vector<Index> connected_component;
+    std::priority_queue<WeightedPair> queue;
+    geometry::Points3 patch_points;
+    std::vector<std::vector<Index>> nn_indices;
+    std::vector<std::vector<double>> nn_distances;
+
+#pragma omp for schedule(dynamic)
+    for (Index j = 0; j < n_patches; j++) {
+      auto& seeds = fragment_seeds.at(j);
+      auto& pairs = boundary_pairs.at(j);
+
+      // Every point in the patch is visited once, so the neighbors are searched all at once.
+      auto patch_begin = bounds.at(j);
+      patch_points.resize(bounds.at(j + 1) - patch_begin, 3);
+      for (auto it = patch_begin; it < bounds.at(j + 1); it++) {
+        patch_points.row(it - patch_begin) = points_.row(order.at(it));
+      }
+      tree_.knn_search_batch(patch_points, k, nn_indices, nn_distances);
+
+      auto visit = [&](Index cur) {
+        auto p_cur = points_.row(cur);
+        auto n_cur = normals_.row(cur);
+
+        oriented.at(cur) = true;
+        fragment_of.at(cur) = static_cast<Index>(seeds.size());
+        connected_component.push_back(cur);
+
+        for (auto next : nn_indices.at(position_of.at(cur) - patch_begin)) {
+          if (patch_of.at(next) != j) {
+            // Since the neighbor relation is not symmetric, the pair is recorded
+            // regardless of the side it is found from, and deduplicated later.
+            pairs.push_back(std::minmax(cur, next));
+            continue;
+          }
+
+          if (oriented.at(next)) {
+            continue;
+          }
+
+          auto p_next = points_.row(next);
+          auto n_next = normals_.row(next);
+
+          auto w_next = std::abs(n_next.dot(n_cur)) / (p_next - p_cur).norm();
+          queue.emplace(cur, next, w_next);
+        }
+      };
+
+      for (auto it = bounds.at(j); it < bounds.at(j + 1); it++) {
+        auto seed = order.at(it);
+        if (oriented.at(seed)) {
+          continue;
+        }
+
+        connected_component.clear();
+        visit(seed);
+
+        while (!queue.empty()) {
+          auto [prev, cur, w_cur] = queue.top();
+          queue.pop();
+          if (oriented.at(cur)) {
+            continue;
+          }
+
+          auto n_prev = normals_.row(prev);
+          auto n_cur = normals_.row(cur);
+          if (n_cur.dot(n_prev) < 0.0) {
+            n_cur *= -1.0;
+          }
+          visit(cur);
+        }
+
+        seeds.push_back(*std::max_element(connected_component.begin(),
+                                          connected_component.end(), [&](auto a, auto b) {
+                                            return points_.row(a).dot(seed_point_direction) <
+                                                   points_.row(b).dot(seed_point_direction);
+                                          }));
+      }
+
+      std::sort(pairs.begin(), pairs.end());
+      pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+    }
+  }
+
+  // A pair found from both sides is recorded in both patches.
+  std::vector<std::pair<Index, Index>> pairs;
+  for (auto& p : boundary_pairs) {
+    pairs.insert(pairs.end(), p.begin(), p.end());
+    p = {};
+  }
+  std::sort(pairs.begin(), pairs.end());
+  pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+  // Number the fragments globally.
+  std::vector<Index> fragment_offsets(n_patches + 1);
+  for (Index j = 0; j < n_patches; j++) {
+    fragment_offsets.at(j + 1) =
+        fragment_offsets.at(j) + static_cast<Index>(fragment_seeds.at(j).size());
+  }
+  auto n_fragments = fragment_offsets.back();
+
+#pragma omp parallel for schedule(static)
+  for (Index i = 0; i < n_points_; i++) {
+    if (fragment_of.at(i) >= 0) {
+      fragment_of.at(i) += fragment_offsets.at(patch_of.at(i));
+    }
+  }
+
+  // Each pair of neighboring points in different fragments votes for whether the fragments
+  // have consistent orientations, weighted in the same way as the propagation.
+  struct Vote {
+    bool operator<(const Vote& rhs) const {
+      return std::tie(first, second) < std::tie(rhs.first, rhs.second);
+    }
+
+    Index first{};
+    Index second{};
+    double score{};
+  };
+
+  auto reduce_votes = [](std::vector<Vote>& votes) {
+    std::sort(votes.begin(), votes.end());
+    std::vector<Vote> reduced;
+    for (const auto& vote : votes) {
+      if (!reduced.empty() && reduced.back().first == vote.first &&
+          reduced.back().second == vote.second) {
+        reduced.back().score += vote.score;
+      } else {
+        reduced.push_back(vote);
+      }
+    }
+    votes = std::move(reduced);
+  };
+
+  // The pairs with an unoriented point are marked with negative fragments and removed.
+  std::vector<Vote> votes(pairs.size());
+
+#pragma omp parallel for schedule(static)
+  for (std::size_t i = 0; i < pairs.size(); i++) {
+    auto [a, b] = pairs.at(i);
+    auto fa = fragment_of.at(a);
+    auto fb = fragment_of.at(b);
+    if (fa < 0 || fb < 0) {
+      votes.at(i) = {-1, -1, 0.0};
+      continue;
+    }
+
+    auto dot = normals_.row(a).dot(normals_.row(b));
+    auto w = std::abs(dot) / (points_.row(a) - points_.row(b)).norm();
+    votes.at(i) = {std::min(fa, fb), std::max(fa, fb), dot < 0.0 ? -w : w};
+  }
+  pairs = {};
+  std::erase_if(votes, [](const auto& vote) { return vote.first < 0; });
+  reduce_votes(votes);
+
+  std::vector<std::vector<std::pair<Index, double>>> adjacency(n_fragments);
+  for (const auto& vote : votes) {
+    adjacency.at(vote.first).emplace_back(vote.second, vote.score);
+    adjacency.at(vote.second).emplace_back(vote.first, vote.score);
+  }
+
+  std::vector<Index> seeds;
+  for (const auto& s : fragment_seeds) {
+    seeds.insert(seeds.end(), s.begin(), s.end());
+  }
+
+  // Orient the fragments by propagation over the graph of the fragments,
+  // following the strongest votes first.
+  std::vector<char> flip(n_fragments);
+  std::vector<char> fragment_oriented(n_fragments);
+
+  std::priority_queue<WeightedPair> queue;
+  std::vector<Index> connected_component;
+  for (Index f = 0; f < n_fragments; f++) {
+    if (fragment_oriented.at(f)) {
+      continue;
+    }
+
+    connected_component.clear();
+    queue.emplace(f, f, 0.0);
+
+    while (!queue.empty()) {
+      auto [prev, cur, w_cur] = queue.top();
+      queue.pop();
+      if (fragment_oriented.at(cur)) {
+        continue;
+      }
+
+      if (cur != prev) {
+        auto it = std::find_if(adjacency.at(prev).begin(), adjacency.at(prev).end(),
+                               [cur](const auto& e) { return e.first == cur; });
+        flip.at(cur) = static_cast<char>(flip.at(prev) != (it->second < 0.0));
+      }
+      fragment_oriented.at(cur) = true;
+      connected_component.push_back(cur);
+
+      for (auto [next, score] : adjacency.at(cur)) {
+        if (!fragment_oriented.at(next)) {
+          queue.emplace(cur, next, std::abs(score));
+        }
+      }
+    }
+
+    auto seed_it = std::max_element(connected_component.begin(), connected_component.end(),
+                                    [&](auto a, auto b) {
+                                      return points_.row(seeds.at(a)).dot(seed_point_direction) <
+                                             points_.row(seeds.at(b)).dot(seed_point_direction);
+                                    });
+    auto seed_sign = flip.at(*seed_it) ? -1.0 : 1.0;
+    if (seed_sign * normals_.row(seeds.at(*seed_it)).dot(seed_point_direction) < 0.0) {
+      for (auto g : connected_component) {
+        flip.at(g) = static_cast<char>(!flip.at(g));
+      }
+    }
+  }
+
+#pragma omp parallel for schedule(static)
+  for (Index i = 0; i < n_points_; i++) {
+    auto f = fragment_of.at(i);
+    if (f >= 0 && flip.at(f)) {
+      normals_.row(i) *= -1.0;
+    }
+  }
+
+  return *this;
+}
+
 }  // namespace polatory::point_cloud
@@ -1,3 +1,5 @@
+#include <Eigen/Eigenvalues>
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <polatory/common/macros.hpp>
@@ -10,26 +12,28 @@ PlaneEstimator::PlaneEstimator(const geometry::Points3& points) {
 
   auto svd = pca_svd(points);
 
-  auto n_points = points.rows();
   auto s0 = svd.singularValues()(0);
   auto s1 = svd.singularValues()(1);
   auto s2 = svd.singularValues()(2);
+  set_errors(s0, s1, s2, points.rows());
 
-  point_err_ = std::hypot(s0, s1, s2) / std::sqrt(n_points);
-  line_err_ = std::hypot(s1, s2) / std::sqrt(n_points);
-  plane_err_ = std::abs(s2) / std::sqrt(n_points);
+  basis_ = svd.matrixV();
+}
 
-  if (s0 == 0.0) {
-    plane_factor_ = std::numeric_limits<double>::quiet_NaN();
-  } else if (s1 == 0.0) {
-    plane_factor_ = 0.0;
-  } else if (s2 == 0.0) {
-    plane_factor_ = std::numeric_limits<double>::infinity();
-  } else {
-    plane_factor_ = line_err_ * line_err_ / (plane_err_ * point_err_);
-  }
+PlaneEstimator::PlaneEstimator(const Mat3& scatter, Index n_points) {
+  POLATORY_ASSERT(n_points >= 3);
 
-  basis_ = svd.matrixV();
+  // The eigenvalues are the squared singular values of the centered points, in ascending order.
+  Eigen::SelfAdjointEigenSolver<Mat3> eigen;
+  eigen.compute(scatter);
+
+  const auto& lambda = eigen.eigenvalues();
+  auto s0 = std::sqrt(std::max(lambda(2), 0.0));
+  auto s1 = std::sqrt(std::max(lambda(1), 0.0));
+  auto s2 = std::sqrt(std::max(lambda(0), 0.0));
+  set_errors(s0, s1, s2, n_points);
+
+  basis_ = eigen.eigenvectors().rowwise().reverse();
 }
 
 double PlaneEstimator::line_error() const { return line_err_; }
@@ -47,4 +51,20 @@ Eigen::JacobiSVD<geometry::Points3> PlaneEstimator::pca_svd(const geometry::Poin
   return Eigen::JacobiSVD<geometry::Points3>(points.rowwise() - barycenter, Eigen::ComputeFullV);
 }
 
+void PlaneEstimator::set_errors(double s0, double s1, double s2, Index n_points) {
+  point_err_ = std::hypot(s0, s1, s2) / std::sqrt(n_points);
+  line_err_ = std::hypot(s1, s2) / std::sqrt(n_points);
+  plane_err_ = std::abs(s2) / std::sqrt(n_points);
+
+  if (s0 == 0.0) {
+    plane_factor_ = std::numeric_limits<double>::quiet_NaN();
+  } else if (s1 == 0.0) {
+    plane_factor_ = 0.0;
+  } else if (s2 == 0.0) {
+    plane_factor_ = std::numeric_limits<double>::infinity();
+  } else {
+    plane_factor_ = line_err_ * line_err_ / (plane_err_ * point_err_);
+  }
+}
+
 }  // namespace polatory::point_cloud
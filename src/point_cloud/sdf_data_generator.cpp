@@ -1,4 +1,5 @@
 #include <Eigen/LU>
+#include <algorithm>
 #include <polatory/point_cloud/kdtree.hpp>
 #include <polatory/point_cloud/sdf_data_generator.hpp>
 #include <stdexcept>
@@ -13,13 +14,24 @@ SdfDataGenerator::SdfDataGenerator(const geometry::Points3& points,
 
 SdfDataGenerator::SdfDataGenerator(const geometry::Points3& points,
                                    const geometry::Vectors3& normals, double min_distance,
-                                   double max_distance, const Mat3& aniso) {
+                                   double max_distance, const Mat3& aniso)
+    : SdfDataGenerator(points, normals, min_distance, std::vector<double>{max_distance}, aniso) {}
+
+SdfDataGenerator::SdfDataGenerator(const geometry::Points3& points,
+                                   const geometry::Vectors3& normals, double min_distance,
+                                   const std::vector<double>& max_distances, const Mat3& aniso) {
   if (normals.rows() != points.rows()) {
     throw std::invalid_argument("normals.rows() must be equal to points.rows()");
   }
 
-  if (!(min_distance <= max_distance)) {
-    throw std::invalid_argument("min_distance must be less than or equal to max_distance");
+  if (max_distances.empty()) {
+    throw std::invalid_argument("max_distances must not be empty");
+  }
+
+  for (auto max_distance : max_distances) {
+    if (!(min_distance <= max_distance)) {
+      throw std::invalid_argument("min_distance must be less than or equal to max_distance");
+    }
   }
 
   if (!(aniso.determinant() > 0.0)) {
@@ -27,7 +39,7 @@ SdfDataGenerator::SdfDataGenerator(const geometry::Points3& points,
   }
 
   if (aniso.isIdentity()) {
-    auto [sdf_points, sdf_values] = estimate_impl(points, normals, min_distance, max_distance);
+    auto [sdf_points, sdf_values] = estimate_impl(points, normals, min_distance, max_distances);
     sdf_points_ = sdf_points;
     sdf_values_ = sdf_values;
   } else {
@@ -38,7 +50,7 @@ SdfDataGenerator::SdfDataGenerator(const geometry::Points3& points,
         n = n.normalized();
       }
     }
-    auto [sdf_points, sdf_values] = estimate_impl(a_points, a_normals, min_distance, max_distance);
+    auto [sdf_points, sdf_values] = estimate_impl(a_points, a_normals, min_distance, max_distances);
     sdf_points_ = geometry::transform_points<3>(aniso.inverse(), sdf_points);
     sdf_values_ = sdf_values;
   }
@@ -46,64 +58,149 @@ SdfDataGenerator::SdfDataGenerator(const geometry::Points3& points,
 
 std::pair<geometry::Points3, VecX> SdfDataGenerator::estimate_impl(
     const geometry::Points3& points, const geometry::Vectors3& normals, double min_distance,
-    double max_distance) {
-  KdTree tree(points);
+    const std::vector<double>& max_distances) {
+  static constexpr Index kChunkSize = 1024;
 
-  auto n_points = points.rows();
-  auto n_max_sdf_points = 3 * n_points;
-  auto n_sdf_points = n_points;
-
-  geometry::Points3 sdf_points(n_max_sdf_points, 3);
-  sdf_points.topRows(n_points) = points;
-  VecX sdf_values = VecX::Zero(n_max_sdf_points);
+  struct OffSurfacePoints {
+    std::vector<geometry::Point3> points;
+    std::vector<double> values;
+  };
 
-  std::vector<Index> nn_indices;
-  std::vector<double> nn_distances;
-
-  for (auto sign : {-1.0, 1.0}) {
-    for (Index i = 0; i < n_points; i++) {
-      auto p = points.row(i);
-      auto n = normals.row(i);
-
-      if (n.isZero()) {
-        continue;
-      }
-
-      auto d = max_distance;
-      geometry::Point3 q = p + sign * d * n;
-
-      tree.knn_search(q, 1, nn_indices, nn_distances);
-      auto i_nearest = nn_indices.at(0);
-
-      while (i_nearest != i) {
-        auto p_nearest = points.row(i_nearest);
-        auto r = (p_nearest - p).norm() / 2.0;
-        auto cos = (q - p).normalized().dot((p_nearest - p).normalized());
+  KdTree tree(points);
 
-        d = 0.99 * r / cos;
-        q = p + sign * d * n;
+  std::vector<double> distances(max_distances);
+  std::sort(distances.rbegin(), distances.rend());
+  distances.erase(std::unique(distances.begin(), distances.end()), distances.end());
 
-        if (d < min_distance) {
-          break;
+  auto n_points = points.rows();
+  auto n_chunks = (n_points + kChunkSize - 1) / kChunkSize;
+
+  // The points generated from each chunk of points on each side are merged in a fixed order,
+  // so that the result does not depend on the number of threads.
+  std::vector<OffSurfacePoints> chunks(2 * n_chunks);
+
+#pragma omp parallel
+  {
+    std::vector<Index> nn_indices;
+    std::vector<double> nn_distances;
+    geometry::Points3 first_queries;
+    std::vector<std::vector<Index>> first_nn_indices;
+    std::vector<std::vector<double>> first_nn_distances;
+    std::vector<Index> blockers;
+
+#pragma omp for schedule(dynamic)
+    for (Index c = 0; c < n_chunks; c++) {
+      auto begin = c * kChunkSize;
+      auto end = std::min(begin + kChunkSize, n_points);
+
+      for (auto side = 0; side < 2; side++) {
+        auto sign = side == 0 ? -1.0 : 1.0;
+        auto& chunk = chunks.at(side * n_chunks + c);
+
+        // The first query for each point, at the largest distance, does not depend on
+        // the previous ones, so the queries for the whole chunk are made at once.
+        first_queries = points.middleRows(begin, end - begin) +
+                        sign * distances.front() * normals.middleRows(begin, end - begin);
+        tree.knn_search_batch(first_queries, 1, first_nn_indices, first_nn_distances);
+
+        for (auto i = begin; i < end; i++) {
+          geometry::Point3 p = points.row(i);
+          auto n = normals.row(i);
+
+          if (n.isZero()) {
+            continue;
+          }
+
+          auto first_query = true;
+
+          // Points whose bisector planes with p cut the ray, found for the larger distances.
+          blockers.clear();
+          // The segment from p to the point at this distance is known to be closest to p.
+          auto d_inside = 0.0;
+
+          for (auto max_distance : distances) {
+            if (max_distance <= d_inside) {
+              if (max_distance < d_inside) {
+                chunk.points.emplace_back(p + sign * max_distance * n);
+                chunk.values.push_back(sign * max_distance);
+              }
+              continue;
+            }
+
+            auto d = max_distance;
+            geometry::Point3 q = p + sign * d * n;
+
+            auto shrink = [&](Index j) {
+              auto p_nearest = points.row(j);
+              auto r = (p_nearest - p).norm() / 2.0;
+              auto cos = (q - p).normalized().dot((p_nearest - p).normalized());
+
+              d = 0.99 * r / cos;
+              q = p + sign * d * n;
+            };
+
+            for (auto j : blockers) {
+              if ((q - points.row(j)).squaredNorm() < (q - p).squaredNorm()) {
+                shrink(j);
+              }
+            }
+
+            if (d >= min_distance && d > d_inside) {
+              auto i_nearest = Index{};
+              if (first_query) {
+                i_nearest = first_nn_indices.at(i - begin).at(0);
+              } else {
+                tree.knn_search(q, 1, nn_indices, nn_distances);
+                i_nearest = nn_indices.at(0);
+              }
+
+              while (i_nearest != i) {
+                blockers.push_back(i_nearest);
+                shrink(i_nearest);
+
+                if (d < min_distance || d <= d_inside) {
+                  break;
+                }
+
+                tree.knn_search(q, 1, nn_indices, nn_distances);
+                i_nearest = nn_indices.at(0);
+              }
+            }
+
+            first_query = false;
+
+            if (d < min_distance || d <= d_inside) {
+              continue;
+            }
+
+            chunk.points.push_back(q);
+            chunk.values.push_back(sign * d);
+            d_inside = d;
+          }
         }
-
-        tree.knn_search(q, 1, nn_indices, nn_distances);
-        i_nearest = nn_indices.at(0);
       }
+    }
+  }
 
-      if (d < min_distance) {
-        continue;
-      }
+  auto n_sdf_points = n_points;
+  for (const auto& chunk : chunks) {
+    n_sdf_points += static_cast<Index>(chunk.values.size());
+  }
 
-      sdf_points.row(n_sdf_points) = q;
-      sdf_values(n_sdf_points) = sign * d;
-      n_sdf_points++;
+  geometry::Points3 sdf_points(n_sdf_points, 3);
+  sdf_points.topRows(n_points) = points;
+  VecX sdf_values = VecX::Zero(n_sdf_points);
+
+  auto offset = n_points;
+  for (const auto& chunk : chunks) {
+    auto size = static_cast<Index>(chunk.values.size());
+    for (Index i = 0; i < size; i++) {
+      sdf_points.row(offset + i) = chunk.points.at(i);
+      sdf_values(offset + i) = chunk.values.at(i);
     }
+    offset += size;
   }
 
-  sdf_points.conservativeResize(n_sdf_points, 3);
-  sdf_values.conservativeResize(n_sdf_points);
-
   return {sdf_points, sdf_values};
 }
 
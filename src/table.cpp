@@ -0,0 +1,332 @@
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <fast_float/fast_float.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <polatory/table.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace polatory {
+
+namespace {
+
+// A read-only memory mapping of a whole file.
+// Files that cannot be mapped, such as pipes, are read into a buffer instead.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& filename) {
+    std::filesystem::path path(filename);
+
+#ifdef _WIN32
+    file_ = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                          FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+      throw std::runtime_error(std::format("cannot open file '{}'", filename));
+    }
+
+    if (::GetFileType(file_) != FILE_TYPE_DISK) {
+      // Pipes and character devices cannot be mapped.
+      read_all(filename);
+      return;
+    }
+
+    LARGE_INTEGER li;
+    if (!::GetFileSizeEx(file_, &li)) {
+      ::CloseHandle(file_);
+      throw std::runtime_error(std::format("cannot read file '{}'", filename));
+    }
+    size_ = static_cast<std::size_t>(li.QuadPart);
+    if (size_ == 0) {
+      return;
+    }
+
+    mapping_ = ::CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr) {
+      ::CloseHandle(file_);
+      throw std::runtime_error(std::format("cannot map file '{}'", filename));
+    }
+
+    data_ = ::MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (data_ == nullptr) {
+      ::CloseHandle(mapping_);
+      ::CloseHandle(file_);
+      throw std::runtime_error(std::format("cannot map file '{}'", filename));
+    }
+#else
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+    file_ = ::open(path.c_str(), O_RDONLY);
+    if (file_ == -1) {
+      throw std::runtime_error(std::format("cannot open file '{}'", filename));
+    }
+
+    struct ::stat st {};
+    if (::fstat(file_, &st) == -1) {
+      ::close(file_);
+      throw std::runtime_error(std::format("cannot read file '{}'", filename));
+    }
+
+    if (!S_ISREG(st.st_mode)) {
+      // FIFOs (including /dev/stdin and process substitutions) cannot be mapped.
+      read_all(filename);
+      return;
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ == 0) {
+      return;
+    }
+
+    data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file_, 0);
+    if (data_ == MAP_FAILED) {
+      data_ = nullptr;
+      ::close(file_);
+      throw std::runtime_error(std::format("cannot map file '{}'", filename));
+    }
+    ::madvise(data_, size_, MADV_SEQUENTIAL);
+#endif
+  }
+
+  ~MappedFile() {
+#ifdef _WIN32
+    if (data_ != nullptr) {
+      ::UnmapViewOfFile(data_);
+      ::CloseHandle(mapping_);
+    }
+    ::CloseHandle(file_);
+#else
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+    }
+    ::close(file_);
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&&) = delete;
+
+  const char* data() const {
+    return data_ != nullptr ? static_cast<const char*>(data_) : buffer_.data();
+  }
+
+  std::size_t size() const { return data_ != nullptr ? size_ : buffer_.size(); }
+
+ private:
+  // Reads the whole file into the buffer instead of mapping it.
+  void read_all(const std::string& filename) {
+    static constexpr std::size_t kBlockSize = std::size_t{1} << 16;
+
+    while (true) {
+      auto offset = buffer_.size();
+      buffer_.resize(offset + kBlockSize);
+#ifdef _WIN32
+      DWORD n{};
+      auto ok = ::ReadFile(file_, buffer_.data() + offset, static_cast<DWORD>(kBlockSize), &n,
+                           nullptr);
+      if (!ok && ::GetLastError() == ERROR_BROKEN_PIPE) {
+        // The write end of the pipe has been closed.
+        ok = TRUE;
+        n = 0;
+      }
+      if (!ok) {
+        ::CloseHandle(file_);
+        throw std::runtime_error(std::format("cannot read file '{}'", filename));
+      }
+#else
+      auto n = ::read(file_, buffer_.data() + offset, kBlockSize);
+      if (n == -1) {
+        if (errno == EINTR) {
+          buffer_.resize(offset);
+          continue;
+        }
+        ::close(file_);
+        throw std::runtime_error(std::format("cannot read file '{}'", filename));
+      }
+#endif
+      buffer_.resize(offset + static_cast<std::size_t>(n));
+      if (n == 0) {
+        break;
+      }
+    }
+  }
+
+  std::size_t size_{};
+  std::string buffer_;
+
+#ifdef _WIN32
+  HANDLE file_{};
+  HANDLE mapping_{};
+#else
+  int file_{};
+#endif
+
+  void* data_{};
+};
+
+// Splits a range of the file into lines, in the same way as std::getline.
+template <class Fn>
+void for_each_line(const char* begin, const char* end, Fn fn) {
+  while (begin < end) {
+    const auto* nl = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+    const auto* line_end = nl != nullptr ? nl : end;
+    fn(begin, line_end);
+    begin = line_end + 1;
+  }
+}
+
+bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+}  // namespace
+
+MatX read_table(const std::string& filename, const char* delimiters) {
+  static constexpr std::size_t kChunkSize = std::size_t{1} << 20;
+
+  MappedFile file(filename);
+  const auto* data = file.data();
+  auto size = file.size();
+
+  std::array<bool, 256> is_delimiter{};
+  for (const auto* d = delimiters; *d != '\0'; d++) {
+    is_delimiter.at(static_cast<unsigned char>(*d)) = true;
+  }
+
+  auto is_delim = [&](char c) { return is_delimiter.at(static_cast<unsigned char>(c)); };
+
+  auto count_cells = [&](const char* begin, const char* end) {
+    return 1 + static_cast<Index>(std::count_if(begin, end, is_delim));
+  };
+
+  auto is_comment = [](const char* begin, const char* end) { return begin < end && *begin == '#'; };
+
+  // The number of columns is determined by the first line that is not a comment.
+  auto n_cols = Index{0};
+  if (size > 0) {
+    const auto* line = data;
+    while (line < data + size) {
+      const auto* nl = static_cast<const char*>(std::memchr(line, '\n', data + size - line));
+      const auto* line_end = nl != nullptr ? nl : data + size;
+      if (!is_comment(line, line_end)) {
+        n_cols = count_cells(line, line_end);
+        break;
+      }
+      line = line_end + 1;
+    }
+  }
+
+  if (n_cols == 0) {
+    throw std::runtime_error(std::format("file '{}' is empty", filename));
+  }
+
+  // Split the file into chunks at line boundaries.
+  std::vector<const char*> bounds{data};
+  for (auto offset = kChunkSize; offset < size; offset += kChunkSize) {
+    auto from = std::max(bounds.back(), data + offset - 1);
+    const auto* nl = static_cast<const char*>(std::memchr(from, '\n', data + size - from));
+    if (nl == nullptr) {
+      break;
+    }
+    bounds.push_back(nl + 1);
+  }
+  bounds.push_back(data + size);
+  auto n_chunks = static_cast<Index>(bounds.size()) - 1;
+
+  // The first pass counts the lines and the rows in each chunk.
+  std::vector<Index> line_offsets(n_chunks + 1);
+  std::vector<Index> row_offsets(n_chunks + 1);
+
+#pragma omp parallel for schedule(dynamic)
+  for (Index c = 0; c < n_chunks; c++) {
+    Index n_lines{};
+    Index n_rows{};
+    for_each_line(bounds.at(c), bounds.at(c + 1), [&](const char* begin, const char* end) {
+      n_lines++;
+      if (!is_comment(begin, end) && count_cells(begin, end) == n_cols) {
+        n_rows++;
+      }
+    });
+    line_offsets.at(c + 1) = n_lines;
+    row_offsets.at(c + 1) = n_rows;
+  }
+
+  for (Index c = 0; c < n_chunks; c++) {
+    line_offsets.at(c + 1) += line_offsets.at(c);
+    row_offsets.at(c + 1) += row_offsets.at(c);
+  }
+
+  // The second pass parses the rows directly into the table.
+  MatX table(row_offsets.back(), n_cols);
+  std::vector<std::vector<Index>> skipped_lines(n_chunks);
+
+#pragma omp parallel for schedule(dynamic)
+  for (Index c = 0; c < n_chunks; c++) {
+    auto line_no = line_offsets.at(c);
+    auto row = row_offsets.at(c);
+    for_each_line(bounds.at(c), bounds.at(c + 1), [&](const char* begin, const char* end) {
+      line_no++;
+
+      if (is_comment(begin, end)) {
+        return;
+      }
+
+      if (count_cells(begin, end) != n_cols) {
+        skipped_lines.at(c).push_back(line_no);
+        return;
+      }
+
+      auto* out = table.row(row).data();
+      const auto* cell = begin;
+      for (Index j = 0; j < n_cols; j++) {
+        const auto* cell_end = cell;
+        while (cell_end < end && !is_delim(*cell_end)) {
+          cell_end++;
+        }
+
+        const auto* first = cell;
+        const auto* last = cell_end;
+        while (first < last && is_space(*first)) {
+          first++;
+        }
+        while (first < last && is_space(*(last - 1))) {
+          last--;
+        }
+
+        auto value = std::numeric_limits<double>::quiet_NaN();
+        fast_float::from_chars(first, last, value);
+        out[j] = value;
+
+        cell = cell_end + 1;
+      }
+      row++;
+    });
+  }
+
+  for (const auto& lines : skipped_lines) {
+    for (auto line_no : lines) {
+      std::cerr << std::format("warning: skipping line {} with a different number of columns",
+                               line_no)
+                << std::endl;
+    }
+  }
+
+  return table;
+}
+
+}  // namespace polatory
@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/types.hpp>
+
+using polatory::Index;
+using polatory::Mat3;
+using polatory::geometry::Bbox3;
+using polatory::geometry::GridPoints3;
+using polatory::geometry::Point3;
+using polatory::geometry::Points3;
+using polatory::geometry::Vector3;
+
+TEST(grid_points, trivial) {
+  Vector3 offset(0.5, -1.0, 2.0);
+  Mat3 basis = Mat3::Random();
+
+  GridPoints3 grid(offset, basis);
+  grid.add_run({-2, 3, 1}, 4);
+  grid.add_run({0, 0, 0}, 0);
+  grid.add_run({5, -1, 2}, 3);
+
+  Points3 expected(7, 3);
+  for (Index i = 0; i < 4; i++) {
+    expected.row(i) = (offset + Vector3(-2.0 + static_cast<double>(i), 3.0, 1.0)) * basis;
+  }
+  for (Index i = 0; i < 3; i++) {
+    expected.row(4 + i) = (offset + Vector3(5.0 + static_cast<double>(i), -1.0, 2.0)) * basis;
+  }
+
+  ASSERT_EQ(7, grid.rows());
+  EXPECT_EQ(expected, grid.points());
+  EXPECT_EQ(expected.middleRows(2, 4), grid.points(2, 6));
+  EXPECT_EQ(Bbox3::from_points(expected), grid.bbox());
+}
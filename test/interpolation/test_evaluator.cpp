@@ -2,6 +2,7 @@
 
 #include <Eigen/Core>
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolation/direct_evaluator.hpp>
 #include <polatory/interpolation/evaluator.hpp>
@@ -14,9 +15,11 @@
 #include "../utility.hpp"
 
 using polatory::Index;
+using polatory::Mat;
 using polatory::Model;
 using polatory::VecX;
 using polatory::geometry::Bbox;
+using polatory::geometry::GridPoints;
 using polatory::geometry::Point;
 using polatory::geometry::Points;
 using polatory::interpolation::DirectEvaluator;
@@ -74,3 +77,82 @@ TEST(rbf_evaluator, trivial) {
                                             direct_values.tail(kDim * n_grad_eval_points)),
             grad_accuracy);
 }
+
+TEST(rbf_evaluator, multiple_targets) {
+  constexpr int kDim = 3;
+  using Bbox = Bbox<kDim>;
+  using Point = Point<kDim>;
+  using Points = Points<kDim>;
+
+  Index n_points = 1024;
+  Index n_eval_points = 1024;
+  auto accuracy = 1e-4;
+
+  Triharmonic3D<kDim> rbf({1.0});
+  rbf.set_anisotropy(random_anisotropy<kDim>());
+
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+
+  Points points = Points::Random(n_points, kDim);
+
+  Bbox bbox{-Point::Ones(), Point::Ones()};
+  Evaluator<kDim> eval(model, points, bbox, accuracy);
+  DirectEvaluator<kDim> direct_eval(model, points);
+
+  // The evaluator can be reused for other targets, with or without changing the weights.
+  for (auto i = 0; i < 4; i++) {
+    if (i % 2 == 0) {
+      VecX weights = VecX::Random(n_points + model.poly_basis_size());
+      eval.set_weights(weights);
+      direct_eval.set_weights(weights);
+    }
+
+    Points eval_points = Points::Random(n_eval_points, kDim);
+    direct_eval.set_target_points(eval_points);
+
+    auto values = eval.evaluate(eval_points);
+    auto direct_values = direct_eval.evaluate();
+
+    EXPECT_LT(absolute_error<Eigen::Infinity>(values, direct_values), accuracy);
+  }
+}
+
+TEST(rbf_evaluator, grid_targets) {
+  constexpr int kDim = 3;
+  using Bbox = Bbox<kDim>;
+  using GridPoints = GridPoints<kDim>;
+  using Point = Point<kDim>;
+  using Points = Points<kDim>;
+
+  Index n_points = 1024;
+  auto accuracy = 1e-4;
+
+  Triharmonic3D<kDim> rbf({1.0});
+  rbf.set_anisotropy(random_anisotropy<kDim>());
+
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+
+  Points points = Points::Random(n_points, kDim);
+  VecX weights = VecX::Random(n_points + model.poly_basis_size());
+
+  GridPoints grid(-Point::Ones() * 10.0, Mat<kDim>::Identity() * 0.1);
+  for (Index i = 0; i < 16; i++) {
+    grid.add_run({i % 4, i, i}, 17 - i);
+  }
+
+  Bbox bbox{-Point::Ones(), Point::Ones()};
+  Evaluator<kDim> eval(model, points, bbox, accuracy);
+  eval.set_weights(weights);
+
+  DirectEvaluator<kDim> direct_eval(model, points);
+  direct_eval.set_weights(weights);
+  direct_eval.set_target_points(grid.points());
+
+  auto values = eval.evaluate(grid);
+  auto direct_values = direct_eval.evaluate();
+
+  EXPECT_EQ(grid.rows(), values.rows());
+  EXPECT_LT(absolute_error<Eigen::Infinity>(values, direct_values), accuracy);
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <Eigen/Core>
+#include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolation/fitter.hpp>
 #include <polatory/interpolation/symmetric_evaluator.hpp>
 #include <polatory/model.hpp>
@@ -14,6 +15,7 @@
 using polatory::Index;
 using polatory::Model;
 using polatory::VecX;
+using polatory::geometry::Points3;
 using polatory::interpolation::Fitter;
 using polatory::interpolation::SymmetricEvaluator;
 using polatory::numeric::absolute_error;
@@ -71,3 +73,30 @@ TEST(rbf_fitter, values) { test(10000, 0); }
 TEST(rbf_fitter, values_and_grads) { test(10000, 10000); }
 
 TEST(rbf_fitter, special_case) { test(1, 10000); }
+
+TEST(rbf_fitter, out_of_core) {
+  constexpr int kDim = 3;
+  auto n_points = Index{10000};
+  auto tolerance = 1e-3;
+  auto max_iter = 100;
+  auto accuracy = tolerance / 100.0;
+
+  auto aniso = random_anisotropy<kDim>();
+  auto [points, values] = sample_data(n_points, aniso);
+  Points3 grad_points(0, kDim);
+
+  Triharmonic3D<kDim> rbf({1.0});
+  rbf.set_anisotropy(aniso);
+
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+  model.set_nugget(0.01);
+
+  Fitter<kDim> fitter(model, points, grad_points);
+  VecX weights = fitter.fit(values, tolerance, tolerance, max_iter, accuracy, accuracy);
+
+  fitter.set_out_of_core(true);
+  VecX weights_ooc = fitter.fit(values, tolerance, tolerance, max_iter, accuracy, accuracy);
+
+  EXPECT_EQ(weights, weights_ooc);
+}
@@ -4,6 +4,7 @@
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolation/direct_operator.hpp>
 #include <polatory/interpolation/operator.hpp>
+#include <polatory/interpolation/symmetric_evaluator.hpp>
 #include <polatory/model.hpp>
 #include <polatory/numeric/error.hpp>
 #include <polatory/rbf/polyharmonic_odd.hpp>
@@ -18,6 +19,7 @@ using polatory::VecX;
 using polatory::geometry::Points;
 using polatory::interpolation::DirectOperator;
 using polatory::interpolation::Operator;
+using polatory::interpolation::SymmetricEvaluator;
 using polatory::numeric::absolute_error;
 using polatory::rbf::Triharmonic3D;
 
@@ -60,3 +62,50 @@ TEST(rbf_operator, trivial) {
                                       direct_op_weights.segment(n_points, kDim * n_grad_points)),
       grad_accuracy);
 }
+
+TEST(rbf_operator, shared_evaluator) {
+  constexpr int kDim = 3;
+  using Points = Points<kDim>;
+
+  Index n_points = 1024;
+  Index n_grad_points = 1024;
+  auto accuracy = 1e-4;
+  auto grad_accuracy = 1e-4;
+
+  Triharmonic3D<kDim> rbf({1.0});
+  rbf.set_anisotropy(random_anisotropy<kDim>());
+
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+  model.set_nugget(0.01);
+
+  Points points = Points::Random(n_points, kDim);
+  Points grad_points = Points::Random(n_grad_points, kDim);
+
+  VecX weights = VecX::Random(n_points + kDim * n_grad_points + model.poly_basis_size());
+
+  SymmetricEvaluator<kDim> eval(model, points, grad_points);
+  Operator<kDim> op(model, eval, accuracy, grad_accuracy);
+  op.set_points(points, grad_points);
+
+  DirectOperator<kDim> direct_op(model, points, grad_points);
+
+  VecX direct_op_weights = direct_op(weights);
+
+  // Use the evaluator with another accuracy in between.
+  for (auto i = 0; i < 2; i++) {
+    VecX op_weights = op(weights);
+
+    EXPECT_LT(absolute_error<Eigen::Infinity>(op_weights.head(n_points),
+                                              direct_op_weights.head(n_points)),
+              accuracy);
+    EXPECT_LT(
+        absolute_error<Eigen::Infinity>(op_weights.segment(n_points, kDim * n_grad_points),
+                                        direct_op_weights.segment(n_points, kDim * n_grad_points)),
+        grad_accuracy);
+
+    eval.set_accuracy(1e-2, 1e-2);
+    eval.set_weights(weights);
+    eval.evaluate();
+  }
+}
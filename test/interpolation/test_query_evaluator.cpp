@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+#include <filesystem>
+#include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/interpolant.hpp>
+#include <polatory/interpolation/direct_evaluator.hpp>
+#include <polatory/interpolation/query_evaluator.hpp>
+#include <polatory/model.hpp>
+#include <polatory/numeric/error.hpp>
+#include <polatory/rbf/polyharmonic_odd.hpp>
+#include <polatory/rbf/rbf_io.hpp>
+#include <polatory/types.hpp>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "../utility.hpp"
+
+using polatory::Index;
+using polatory::Interpolant;
+using polatory::Model;
+using polatory::VecX;
+using polatory::geometry::Bbox;
+using polatory::geometry::Point;
+using polatory::geometry::Points;
+using polatory::interpolation::DirectEvaluator;
+using polatory::interpolation::QueryEvaluator;
+using polatory::numeric::absolute_error;
+using polatory::rbf::Biharmonic3D;
+
+TEST(query_evaluator, trivial) {
+  constexpr int kDim = 3;
+  using Bbox = Bbox<kDim>;
+  using Point = Point<kDim>;
+  using Points = Points<kDim>;
+
+  Index n_points = 4096;
+  Index n_grad_points = 1024;
+  Index n_eval_points = 1024;
+  auto accuracy = 1e-6;
+
+  Biharmonic3D<kDim> rbf({1.0});
+  rbf.set_anisotropy(random_anisotropy<kDim>());
+
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+
+  Points points = Points::Random(n_points, kDim);
+  Points grad_points = Points::Random(n_grad_points, kDim);
+  Points eval_points = Points::Random(n_eval_points, kDim);
+
+  VecX weights = VecX::Random(n_points + kDim * n_grad_points + model.poly_basis_size());
+
+  Bbox bbox{-Point::Ones(), Point::Ones()};
+  QueryEvaluator<kDim> query_eval(model, points, grad_points, weights, bbox, accuracy);
+
+  DirectEvaluator<kDim> direct_eval(model, points, grad_points);
+  direct_eval.set_weights(weights);
+  direct_eval.set_target_points(eval_points);
+
+  EXPECT_GT(query_eval.num_cells(), 1);
+
+  auto values = query_eval.evaluate(eval_points);
+  auto direct_values = direct_eval.evaluate();
+
+  EXPECT_EQ(n_eval_points, values.rows());
+  EXPECT_LT(absolute_error<Eigen::Infinity>(values, direct_values), 1e-3);
+
+  // Single-point queries must agree with batched ones.
+  for (Index i = 0; i < 8; i++) {
+    Points p = eval_points.row(i);
+    EXPECT_DOUBLE_EQ(values(i), query_eval.evaluate(p)(0));
+  }
+}
+
+TEST(query_evaluator, outside_bbox) {
+  constexpr int kDim = 3;
+  using Bbox = Bbox<kDim>;
+  using Point = Point<kDim>;
+  using Points = Points<kDim>;
+
+  Index n_points = 1024;
+
+  Biharmonic3D<kDim> rbf({1.0});
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+
+  Points points = Points::Random(n_points, kDim);
+  VecX weights = VecX::Random(n_points + model.poly_basis_size());
+
+  Bbox bbox{-Point::Ones(), Point::Ones()};
+  QueryEvaluator<kDim> query_eval(model, points, Points(0, kDim), weights, bbox);
+
+  Points corner = Point::Ones();
+  EXPECT_NO_THROW(query_eval.evaluate(corner));
+
+  Points outside(2, kDim);
+  outside << Point::Zero(), Point(0.0, 0.0, 1.5);
+  EXPECT_THROW(query_eval.evaluate(outside), std::invalid_argument);
+}
+
+TEST(query_evaluator, moved_interpolant) {
+  constexpr int kDim = 3;
+  using Bbox = Bbox<kDim>;
+  using Point = Point<kDim>;
+  using Points = Points<kDim>;
+
+  Index n_points = 1024;
+  Index n_eval_points = 256;
+  auto tolerance = 1e-4;
+  auto accuracy = 1e-6;
+
+  Biharmonic3D<kDim> rbf({1.0});
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+
+  auto [points, values] = sample_data<kDim>(n_points, polatory::Mat<kDim>::Identity());
+  Points eval_points = Points::Random(n_eval_points, kDim);
+  Bbox bbox{-Point::Ones(), Point::Ones()};
+
+  Interpolant<kDim> interpolant(model);
+  interpolant.fit(points, values, tolerance);
+  interpolant.set_query_bbox(bbox, accuracy);
+  VecX expected = interpolant.query(eval_points);
+
+  // The moved-from interpolant is kept alive with an empty model.
+  auto moved = std::move(interpolant);
+  EXPECT_EQ(expected, moved.query(eval_points));
+
+  std::vector<Interpolant<kDim>> interpolants;
+  interpolants.push_back(std::move(moved));
+  EXPECT_EQ(expected, interpolants.front().query(eval_points));
+
+  auto filename = (std::filesystem::temp_directory_path() / "query_interpolant.bin").string();
+  interpolants.front().save(filename);
+  auto loaded = Interpolant<kDim>::load(filename);
+  std::filesystem::remove(filename);
+
+  loaded.set_query_bbox(bbox, accuracy);
+  auto loaded_moved = std::move(loaded);
+  EXPECT_LT(absolute_error<Eigen::Infinity>(loaded_moved.query(eval_points), expected), 1e-12);
+}
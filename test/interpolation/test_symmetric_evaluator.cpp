@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <Eigen/Core>
+#include <polatory/geometry/bbox3d.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/interpolation/direct_evaluator.hpp>
 #include <polatory/interpolation/symmetric_evaluator.hpp>
@@ -15,6 +16,8 @@
 using polatory::Index;
 using polatory::Model;
 using polatory::VecX;
+using polatory::geometry::Bbox;
+using polatory::geometry::Point;
 using polatory::geometry::Points;
 using polatory::interpolation::DirectEvaluator;
 using polatory::interpolation::SymmetricEvaluator;
@@ -61,3 +64,53 @@ TEST(rbf_symmetric_evaluator, trivial) {
                                             direct_values.tail(kDim * n_grad_points)),
             grad_accuracy);
 }
+
+TEST(rbf_symmetric_evaluator, reconfigure) {
+  constexpr int kDim = 3;
+  using Bbox = Bbox<kDim>;
+  using Point = Point<kDim>;
+  using Points = Points<kDim>;
+
+  Index n_points = 2048;
+  Index n_grad_points = 512;
+  auto coarse_accuracy = 1e-2;
+  auto fine_accuracy = 1e-6;
+
+  Triharmonic3D<kDim> rbf({1.0});
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+
+  Bbox bbox{-Point::Ones(), Point::Ones()};
+  SymmetricEvaluator<kDim> eval(model, bbox, coarse_accuracy, coarse_accuracy);
+
+  auto expect_accurate = [&](const Points& points, const Points& grad_points, const VecX& weights,
+                             double accuracy) {
+    DirectEvaluator<kDim> direct_eval(model, points, grad_points);
+    direct_eval.set_weights(weights);
+    direct_eval.set_target_points(points, grad_points);
+
+    eval.set_weights(weights);
+    EXPECT_LT(absolute_error<Eigen::Infinity>(eval.evaluate(), direct_eval.evaluate()), accuracy);
+  };
+
+  // The points are first clustered around the origin, and then spread over the bbox.
+  Points points = 0.1 * Points::Random(n_points, kDim);
+  Points grad_points = 0.1 * Points::Random(n_grad_points, kDim);
+  VecX weights = VecX::Random(n_points + kDim * n_grad_points + model.poly_basis_size());
+  eval.set_points(points, grad_points);
+  expect_accurate(points, grad_points, weights, coarse_accuracy);
+
+  // The configuration must be derived again for the new accuracy.
+  eval.set_accuracy(fine_accuracy, fine_accuracy);
+  expect_accurate(points, grad_points, weights, fine_accuracy);
+
+  // The configuration must be derived again for the new points.
+  points = Points::Random(n_points, kDim);
+  grad_points = Points::Random(n_grad_points, kDim);
+  weights = VecX::Random(n_points + kDim * n_grad_points + model.poly_basis_size());
+  eval.set_points(points, grad_points);
+  expect_accurate(points, grad_points, weights, fine_accuracy);
+
+  eval.set_accuracy(coarse_accuracy, coarse_accuracy);
+  expect_accurate(points, grad_points, weights, coarse_accuracy);
+}
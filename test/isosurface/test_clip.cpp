@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/isosurface/clip.hpp>
+#include <polatory/isosurface/mesh.hpp>
+#include <polatory/isosurface/types.hpp>
+#include <polatory/types.hpp>
+#include <set>
+#include <vector>
+
+using polatory::Index;
+using polatory::geometry::Bbox3;
+using polatory::geometry::Point3;
+using polatory::geometry::Points3;
+using polatory::isosurface::Faces;
+using polatory::isosurface::Mesh;
+using polatory::isosurface::MeshClipper;
+
+namespace {
+
+// A square [0, n]^2 on the plane z = 0.5, made of n^2 unit squares each split into two triangles.
+Mesh square(Index n) {
+  Points3 vertices((n + 1) * (n + 1), 3);
+  for (Index j = 0; j <= n; j++) {
+    for (Index i = 0; i <= n; i++) {
+      vertices.row(j * (n + 1) + i) = Point3(static_cast<double>(i), static_cast<double>(j), 0.5);
+    }
+  }
+
+  Faces faces(2 * n * n, 3);
+  for (Index j = 0; j < n; j++) {
+    for (Index i = 0; i < n; i++) {
+      auto v = j * (n + 1) + i;
+      faces.row(2 * (j * n + i)) << v, v + 1, v + n + 2;
+      faces.row(2 * (j * n + i) + 1) << v, v + n + 2, v + n + 1;
+    }
+  }
+
+  return {vertices, faces};
+}
+
+}  // namespace
+
+TEST(clip, boundary_faces_only) {
+  auto mesh = square(4);
+  Bbox3 bbox(Point3(0.5, 0.5, 0.0), Point3(3.5, 3.5, 1.0));
+
+  MeshClipper clipper(mesh, bbox);
+  const auto& clipped = clipper.clipped_mesh();
+  const auto& original_vertices = clipper.original_vertices();
+  const auto& generating_faces = clipper.generating_faces();
+
+  auto is_interior = [&](Index vi) {
+    auto v = mesh.vertices().row(vi);
+    return (v.array() > bbox.min().array() && v.array() < bbox.max().array()).all();
+  };
+
+  // The faces strictly inside the bbox are passed through with the same vertices.
+  std::set<std::array<Index, 3>> clipped_faces;
+  for (auto f : clipped.faces().rowwise()) {
+    clipped_faces.insert(
+        {original_vertices.at(f(0)), original_vertices.at(f(1)), original_vertices.at(f(2))});
+  }
+
+  Index n_interior_faces{};
+  for (auto f : mesh.faces().rowwise()) {
+    if (is_interior(f(0)) && is_interior(f(1)) && is_interior(f(2))) {
+      ASSERT_TRUE(clipped_faces.contains({f(0), f(1), f(2)}));
+      n_interior_faces++;
+    }
+  }
+  ASSERT_EQ(8, n_interior_faces);
+
+  // The original vertices are kept, and the other ones are generated by the boundary faces.
+  for (Index i = 0; i < clipped.vertices().rows(); i++) {
+    Point3 p = clipped.vertices().row(i);
+    ASSERT_TRUE(bbox.contains(p));
+
+    auto vi = original_vertices.at(i);
+    auto fi = generating_faces.at(i);
+    if (vi >= 0) {
+      ASSERT_EQ(-1, fi);
+      ASSERT_EQ(mesh.vertices().row(vi), p);
+    } else {
+      ASSERT_GE(fi, 0);
+      auto f = mesh.faces().row(fi);
+      ASSERT_FALSE(is_interior(f(0)) && is_interior(f(1)) && is_interior(f(2)));
+    }
+  }
+
+  // The vertices generated by clipping are shared between the adjacent faces.
+  std::set<std::array<double, 3>> positions;
+  for (auto v : clipped.vertices().rowwise()) {
+    ASSERT_TRUE(positions.insert({v(0), v(1), v(2)}).second);
+  }
+
+  auto area = 0.0;
+  for (auto f : clipped.faces().rowwise()) {
+    Point3 a = clipped.vertices().row(f(0));
+    Point3 b = clipped.vertices().row(f(1));
+    Point3 c = clipped.vertices().row(f(2));
+    area += 0.5 * (b - a).cross(c - a).norm();
+  }
+  ASSERT_NEAR(9.0, area, 1e-12);
+}
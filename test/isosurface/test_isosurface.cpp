@@ -1,14 +1,26 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
 #include <boost/container_hash/hash.hpp>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <numbers>
+#include <omp.h>
 #include <polatory/geometry/bbox3d.hpp>
+#include <polatory/geometry/grid_points.hpp>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/isosurface/isosurface.hpp>
 #include <polatory/isosurface/mesh_defects_finder.hpp>
+#include <polatory/isosurface/mesh_stream_writer.hpp>
 #include <polatory/types.hpp>
+#include <set>
+#include <sstream>
+#include <string>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "../utility.hpp"
 
@@ -16,13 +28,17 @@ using polatory::Index;
 using polatory::Mat3;
 using polatory::VecX;
 using polatory::geometry::Bbox3;
+using polatory::geometry::GridPoints3;
 using polatory::geometry::Point3;
 using polatory::geometry::Points3;
 using polatory::geometry::Vector3;
+using polatory::geometry::Vectors3;
 using polatory::isosurface::FieldFunction;
+using polatory::isosurface::FieldFunctionWithGradient;
 using polatory::isosurface::Isosurface;
 using polatory::isosurface::Mesh;
 using polatory::isosurface::MeshDefectsFinder;
+using polatory::isosurface::MeshStreamWriter;
 
 namespace {
 
@@ -40,6 +56,47 @@ class DistanceFromPoint : public FieldFunction {
   Point3 point_;
 };
 
+class CountingDistanceFromPoint : public DistanceFromPoint {
+ public:
+  VecX operator()(const Points3& points) const override {
+    num_evaluations_ += points.rows();
+    return DistanceFromPoint::operator()(points);
+  }
+
+  Index num_evaluations() const { return num_evaluations_; }
+
+ private:
+  mutable Index num_evaluations_{};
+};
+
+// The signed distance from the union of two spheres.
+class TwoSpheres : public FieldFunction {
+ public:
+  TwoSpheres(const Point3& center1, double radius1, const Point3& center2, double radius2)
+      : center1_(center1), radius1_(radius1), center2_(center2), radius2_(radius2) {}
+
+  VecX operator()(const Points3& points) const override {
+    return ((points.rowwise() - center1_).rowwise().norm().array() - radius1_)
+        .min((points.rowwise() - center2_).rowwise().norm().array() - radius2_);
+  }
+
+ private:
+  Point3 center1_;
+  double radius1_;
+  Point3 center2_;
+  double radius2_;
+};
+
+// Same as DistanceFromPoint, but the grid points are evaluated one by one as they are generated.
+class GridDistanceFromPoint : public DistanceFromPoint {
+ public:
+  VecX evaluate_grid(const GridPoints3& points) const override {
+    VecX values(points.rows());
+    points.for_each_point([&](Index i, const Point3& p) { values(i) = p.norm(); });
+    return values;
+  }
+};
+
 class RandomFieldFunction : public FieldFunction {
  public:
   VecX operator()(const Points3& points) const override {
@@ -64,6 +121,44 @@ class SignedDistanceFromPlane : public FieldFunction {
   double d_;
 };
 
+// f(x) = s + 10 s^3, where s is the signed distance from the plane.
+class CubicOfSignedDistanceFromPlane : public FieldFunctionWithGradient {
+ public:
+  explicit CubicOfSignedDistanceFromPlane(const Point3& point, const Vector3& direction)
+      : normal_(direction.normalized()), d_(-normal_.dot(point)) {}
+
+  VecX operator()(const Points3& points) const override {
+    VecX s = signed_distance(points);
+    return s.array() + 10.0 * s.array().cube();
+  }
+
+  std::pair<VecX, Vectors3> evaluate_with_gradient(const Points3& points) const override {
+    VecX s = signed_distance(points);
+    VecX values = s.array() + 10.0 * s.array().cube();
+    Vectors3 grads = (1.0 + 30.0 * s.array().square()).matrix() * normal_;
+    return {std::move(values), std::move(grads)};
+  }
+
+  VecX signed_distance(const Points3& points) const {
+    return (points * normal_.transpose()).array() + d_;
+  }
+
+ private:
+  Vector3 normal_;
+  double d_;
+};
+
+// Hides the gradient of the wrapped field function.
+class ValueOnlyFieldFunction : public FieldFunction {
+ public:
+  explicit ValueOnlyFieldFunction(const FieldFunction& field_fn) : field_fn_(field_fn) {}
+
+  VecX operator()(const Points3& points) const override { return field_fn_(points); }
+
+ private:
+  const FieldFunction& field_fn_;
+};
+
 using Halfedge = std::pair<Index, Index>;
 
 struct HalfedgeHash {
@@ -75,7 +170,7 @@ struct HalfedgeHash {
   }
 };
 
-bool test_boundary_coordinates(const Mesh& mesh, const Bbox3& bbox) {
+std::unordered_set<Halfedge, HalfedgeHash> boundary_halfedges(const Mesh& mesh) {
   std::unordered_set<Halfedge, HalfedgeHash> boundary_hes;
   for (auto f : mesh.faces().rowwise()) {
     for (auto i = 0; i < 3; i++) {
@@ -89,6 +184,45 @@ bool test_boundary_coordinates(const Mesh& mesh, const Bbox3& bbox) {
       }
     }
   }
+  return boundary_hes;
+}
+
+using CanonicalPoint = std::array<double, 3>;
+using CanonicalFace = std::array<CanonicalPoint, 3>;
+
+// Returns the sorted positions of the vertices and the sorted faces given by the positions
+// of their vertices, each rotated to start with the smallest one, which identify a mesh
+// regardless of the order of the vertices and the faces.
+// The positions are rounded so that rounding errors in the field values do not affect the order.
+std::pair<std::vector<CanonicalPoint>, std::vector<CanonicalFace>> canonical_mesh(
+    const Mesh& mesh) {
+  constexpr double kPrecision = 1e-9;
+
+  auto point = [&](Index vi) -> CanonicalPoint {
+    auto v = mesh.vertices().row(vi);
+    return {std::round(v(0) / kPrecision) * kPrecision, std::round(v(1) / kPrecision) * kPrecision,
+            std::round(v(2) / kPrecision) * kPrecision};
+  };
+
+  std::vector<CanonicalPoint> vertices;
+  for (Index vi = 0; vi < mesh.vertices().rows(); vi++) {
+    vertices.push_back(point(vi));
+  }
+  std::sort(vertices.begin(), vertices.end());
+
+  std::vector<CanonicalFace> faces;
+  for (auto f : mesh.faces().rowwise()) {
+    CanonicalFace face{point(f(0)), point(f(1)), point(f(2))};
+    std::rotate(face.begin(), std::min_element(face.begin(), face.end()), face.end());
+    faces.push_back(face);
+  }
+  std::sort(faces.begin(), faces.end());
+
+  return {vertices, faces};
+}
+
+bool test_boundary_coordinates(const Mesh& mesh, const Bbox3& bbox) {
+  auto boundary_hes = boundary_halfedges(mesh);
 
   std::unordered_set<Index> boundary_vertices;
   for (const auto& he : boundary_hes) {
@@ -108,6 +242,62 @@ bool test_boundary_coordinates(const Mesh& mesh, const Bbox3& bbox) {
   return true;
 }
 
+Mesh generate_streaming(Isosurface& isosurf, FieldFunction& field_fn, double isovalue,
+                        int refine = 1) {
+  auto filename =
+      (std::filesystem::temp_directory_path() / "a5634591-12bb-4a34-b524-1e02fdd5f9a6").string();
+
+  {
+    MeshStreamWriter writer(filename);
+    isosurf.generate_streaming(field_fn, writer, isovalue, refine);
+  }
+
+  std::vector<Point3> vertices;
+  std::vector<std::array<Index, 3>> faces;
+  auto entire = false;
+
+  std::ifstream ifs(filename);
+  std::string line;
+  while (std::getline(ifs, line)) {
+    std::istringstream iss(line);
+    std::string type;
+    iss >> type;
+    if (type == "v") {
+      Point3 p;
+      iss >> p(0) >> p(1) >> p(2);
+      vertices.push_back(p);
+    } else if (type == "f") {
+      Index a{};
+      Index b{};
+      Index c{};
+      iss >> a >> b >> c;
+      // Every vertex must be defined before it is referenced.
+      EXPECT_LE(std::max({a, b, c}), static_cast<Index>(vertices.size()));
+      faces.push_back({a - 1, b - 1, c - 1});
+    } else if (line == "# entire") {
+      entire = true;
+    }
+  }
+  ifs.close();
+  std::filesystem::remove(filename);
+
+  if (entire) {
+    return Mesh(polatory::isosurface::EntireTag{});
+  }
+
+  Points3 mesh_vertices(static_cast<Index>(vertices.size()), 3);
+  for (std::size_t i = 0; i < vertices.size(); i++) {
+    mesh_vertices.row(static_cast<Index>(i)) = vertices.at(i);
+  }
+  polatory::isosurface::Faces mesh_faces(static_cast<Index>(faces.size()), 3);
+  for (std::size_t i = 0; i < faces.size(); i++) {
+    const auto& f = faces.at(i);
+    mesh_faces.row(static_cast<Index>(i)) << f.at(0), f.at(1), f.at(2);
+  }
+
+  return {std::move(mesh_vertices), std::move(mesh_faces)};
+}
+
 }  // namespace
 
 TEST(isosurface, generate) {
@@ -123,6 +313,129 @@ TEST(isosurface, generate) {
   ASSERT_EQ(2160, mesh.faces().rows());
 }
 
+TEST(isosurface, generate_grid_evaluation) {
+  const Bbox3 bbox(Point3(-1.2, -1.2, -1.2), Point3(1.2, 1.2, 1.2));
+  const auto resolution = 0.1;
+
+  Isosurface isosurf(bbox, resolution);
+
+  DistanceFromPoint field_fn;
+  auto expected = canonical_mesh(isosurf.generate(field_fn, 1.0));
+
+  GridDistanceFromPoint grid_field_fn;
+  auto grid = canonical_mesh(isosurf.generate(grid_field_fn, 1.0));
+  auto adaptive = canonical_mesh(isosurf.generate_adaptive(grid_field_fn, 1.0));
+
+  ASSERT_EQ(expected, grid);
+  ASSERT_EQ(expected, adaptive);
+}
+
+TEST(isosurface, generate_deterministic) {
+  const Bbox3 bbox(Point3(-1.2, -1.2, -1.2), Point3(1.2, 1.2, 1.2));
+  const auto resolution = 0.05;
+
+  Isosurface isosurf(bbox, resolution);
+  DistanceFromPoint field_fn;
+
+  auto max_threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+  auto expected = isosurf.generate(field_fn, 1.0);
+  omp_set_num_threads(4);
+  auto actual = isosurf.generate(field_fn, 1.0);
+  omp_set_num_threads(max_threads);
+
+  ASSERT_EQ(expected.vertices(), actual.vertices());
+  ASSERT_EQ(expected.faces(), actual.faces());
+}
+
+TEST(isosurface, generate_multiple) {
+  const Bbox3 bbox(Point3(-1.0, -1.0, -1.0), Point3(1.0, 1.0, 1.0));
+  const auto resolution = 0.1;
+  const std::vector<double> isovalues{0.2, 0.5, 0.8, 2.0};
+
+  Isosurface isosurf(bbox, resolution);
+  CountingDistanceFromPoint field_fn;
+
+  auto meshes = isosurf.generate_multiple(field_fn, isovalues);
+  auto num_evaluations = field_fn.num_evaluations();
+
+  ASSERT_EQ(isovalues.size(), meshes.size());
+
+  Index num_evaluations_separate{};
+  for (std::size_t i = 0; i < isovalues.size(); i++) {
+    CountingDistanceFromPoint separate_field_fn;
+    auto mesh = isosurf.generate(separate_field_fn, isovalues.at(i));
+    num_evaluations_separate += separate_field_fn.num_evaluations();
+
+    ASSERT_EQ(mesh.is_entire(), meshes.at(i).is_entire());
+    ASSERT_EQ(mesh.vertices(), meshes.at(i).vertices());
+    ASSERT_EQ(mesh.faces(), meshes.at(i).faces());
+  }
+
+  ASSERT_TRUE(meshes.back().is_entire());
+  ASSERT_LT(2 * num_evaluations, num_evaluations_separate);
+}
+
+TEST(isosurface, generate_adaptive) {
+  const Bbox3 bbox(Point3(-1.2, -1.2, -1.2), Point3(1.2, 1.2, 1.2));
+  const auto resolution = 0.025;
+
+  Isosurface isosurf(bbox, resolution);
+  CountingDistanceFromPoint field_fn;
+
+  auto expected = isosurf.generate(field_fn, 1.0);
+  auto full_evaluations = field_fn.num_evaluations();
+
+  CountingDistanceFromPoint adaptive_field_fn;
+  auto actual = isosurf.generate_adaptive(adaptive_field_fn, 1.0);
+
+  ASSERT_EQ(canonical_mesh(expected), canonical_mesh(actual));
+  ASSERT_LT(2 * adaptive_field_fn.num_evaluations(), full_evaluations);
+}
+
+TEST(isosurface, generate_adaptive_small_component) {
+  const Bbox3 bbox(Point3(-1.2, -1.2, -1.2), Point3(1.2, 1.2, 1.2));
+  const auto resolution = 0.05;
+
+  Isosurface isosurf(bbox, resolution);
+  TwoSpheres field_fn(Point3(-0.3, -0.3, -0.3), 0.6, Point3(0.7, 0.7, 0.7), 0.12);
+
+  // The small sphere is smaller than a coarse cell, whose edge length is 8 * resolution.
+  auto expected = isosurf.generate(field_fn, 0.0);
+  auto actual = isosurf.generate_adaptive(field_fn, 0.0);
+
+  ASSERT_EQ(canonical_mesh(expected), canonical_mesh(actual));
+}
+
+TEST(isosurface, generate_adaptive_plane) {
+  const Bbox3 bbox(Point3(-1.2, -1.2, -1.2), Point3(1.2, 1.2, 1.2));
+  const auto resolution = 0.1;
+
+  for (auto i = 0; i < 10; i++) {
+    const auto aniso = random_anisotropy<3>();
+
+    Isosurface isosurf(bbox, resolution, aniso);
+    SignedDistanceFromPlane field_fn(bbox.center(), Vector3::Random().normalized());
+
+    auto expected = isosurf.generate(field_fn, 0.5);
+    auto actual = isosurf.generate_adaptive(field_fn, 0.5);
+
+    ASSERT_EQ(canonical_mesh(expected), canonical_mesh(actual));
+  }
+}
+
+TEST(isosurface, generate_adaptive_entire) {
+  const Bbox3 bbox(Point3(-1.0, -1.0, -1.0), Point3(1.0, 1.0, 1.0));
+  const auto resolution = 0.1;
+
+  Isosurface isosurf(bbox, resolution);
+  SignedDistanceFromPlane field_fn(Point3::Zero(), Vector3::Ones().normalized());
+
+  auto mesh = isosurf.generate_adaptive(field_fn, 1.01 * std::numbers::sqrt3);
+
+  ASSERT_TRUE(mesh.is_entire());
+}
+
 TEST(isosurface, generate_from_seed_points) {
   const Bbox3 bbox(Point3(-1.2, -1.2, -1.2), Point3(1.2, 1.2, 1.2));
   const auto resolution = 0.1;
@@ -231,6 +544,29 @@ TEST(isosurface, generate_plane) {
   ASSERT_EQ(1421, mesh.faces().rows());
 }
 
+TEST(isosurface, generate_with_gradient) {
+  const Bbox3 bbox(Point3(-1.0, -1.0, -1.0), Point3(1.0, 1.0, 1.0));
+  const auto resolution = 0.1;
+
+  Isosurface isosurf(bbox, resolution);
+  CubicOfSignedDistanceFromPlane field_fn(Point3(0.01, 0.02, 0.03), Vector3(1.0, 2.0, 3.0));
+  ValueOnlyFieldFunction value_only_field_fn(field_fn);
+
+  auto max_error = [&](const Mesh& mesh) {
+    return field_fn.signed_distance(mesh.vertices()).cwiseAbs().maxCoeff();
+  };
+
+  auto mesh = isosurf.generate(field_fn, 0.0, 1);
+  auto value_only_mesh = isosurf.generate(value_only_field_fn, 0.0, 1);
+
+  ASSERT_EQ(value_only_mesh.vertices().rows(), mesh.vertices().rows());
+  ASSERT_EQ(value_only_mesh.faces().rows(), mesh.faces().rows());
+
+  // The Hermite cubic fit is exact for the field function.
+  ASSERT_LT(max_error(mesh), 1e-10);
+  ASSERT_LT(max_error(mesh), max_error(value_only_mesh));
+}
+
 TEST(isosurface, manifold) {
   const Bbox3 bbox(Point3(-1.0, -1.0, -1.0), Point3(1.0, 1.0, 1.0));
   const auto resolution = 0.1;
@@ -281,3 +617,98 @@ TEST(isosurface, boundary_coordinates_seed_points) {
 
   ASSERT_TRUE(test_boundary_coordinates(mesh, bbox));
 }
+
+TEST(isosurface, generate_streaming) {
+  const Bbox3 bbox(Point3(-1.2, -1.2, -1.2), Point3(1.2, 1.2, 1.2));
+  const auto resolution = 0.1;
+
+  Isosurface isosurf(bbox, resolution);
+  DistanceFromPoint field_fn;
+
+  auto mesh = generate_streaming(isosurf, field_fn, 1.0);
+
+  ASSERT_EQ(1082, mesh.vertices().rows());
+  ASSERT_EQ(2160, mesh.faces().rows());
+
+  // The sphere must be closed.
+  ASSERT_TRUE(test_boundary_coordinates(mesh, bbox));
+}
+
+TEST(isosurface, generate_streaming_empty_entire) {
+  const Bbox3 bbox(Point3(-1.0, -1.0, -1.0), Point3(1.0, 1.0, 1.0));
+  const auto resolution = 0.1;
+
+  Isosurface isosurf(bbox, resolution);
+  SignedDistanceFromPlane field_fn(Point3::Zero(), Vector3::Ones().normalized());
+
+  auto empty = generate_streaming(isosurf, field_fn, -1.01 * std::numbers::sqrt3);
+  ASSERT_TRUE(empty.is_empty());
+
+  auto entire = generate_streaming(isosurf, field_fn, 1.01 * std::numbers::sqrt3);
+  ASSERT_TRUE(entire.is_entire());
+}
+
+TEST(isosurface, generate_streaming_manifold) {
+  const Bbox3 bbox(Point3(-1.0, -1.0, -1.0), Point3(1.0, 1.0, 1.0));
+  const auto resolution = 0.1;
+  const auto aniso = random_anisotropy<3>();
+
+  Isosurface isosurf(bbox, resolution, aniso);
+  RandomFieldFunction field_fn;
+
+  auto mesh = generate_streaming(isosurf, field_fn, 0.0, 0);
+
+  MeshDefectsFinder defects(mesh);
+
+  const auto& min = bbox.min();
+  const auto& max = bbox.max();
+  for (auto vi : defects.singular_vertices()) {
+    Point3 p = mesh.vertices().row(vi);
+    ASSERT_TRUE((p.array() == min.array() || p.array() == max.array()).any());
+  }
+
+  ASSERT_TRUE(defects.intersecting_faces().empty());
+  ASSERT_TRUE(test_boundary_coordinates(mesh, bbox));
+}
+
+TEST(isosurface, generate_streaming_clipped) {
+  const Bbox3 bbox(Point3(-0.8, -0.8, -0.8), Point3(0.8, 0.8, 0.8));
+  const auto resolution = 0.1;
+
+  Mat3 stretched = Mat3::Identity();
+  stretched.diagonal() << 2.0, 1.0, 0.5;
+  Mat3 rotated;
+  rotated << 0.0, 1.0, 0.0,  //
+      0.0, 0.0, 1.0,         //
+      1.0, 0.0, 0.0;
+
+  for (const Mat3& aniso : {Mat3(Mat3::Identity()), stretched, rotated}) {
+    Isosurface isosurf(bbox, resolution, aniso);
+    DistanceFromPoint field_fn;
+
+    auto expected = isosurf.generate(field_fn, 1.0);
+    isosurf.clear();
+    auto actual = generate_streaming(isosurf, field_fn, 1.0);
+
+    ASSERT_EQ(canonical_mesh(expected), canonical_mesh(actual));
+  }
+
+  for (auto i = 0; i < 10; i++) {
+    const auto aniso = random_anisotropy<3>();
+
+    Isosurface isosurf(bbox, resolution, aniso);
+    DistanceFromPoint field_fn;
+
+    auto mesh = generate_streaming(isosurf, field_fn, 1.0);
+
+    // Under an arbitrary anisotropy, the mesh is not always the same as the one generated
+    // at once, as the vertices around the slab boundaries are unclustered more conservatively.
+    // Nevertheless, the vertices on the slab boundaries and on the bbox must not be duplicated,
+    // and the faces must be connected across the slab boundaries.
+    std::set<std::array<double, 3>> positions;
+    for (auto v : mesh.vertices().rowwise()) {
+      ASSERT_TRUE(positions.insert({v(0), v(1), v(2)}).second);
+    }
+    ASSERT_TRUE(test_boundary_coordinates(mesh, bbox));
+  }
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/isosurface/mesh.hpp>
+#include <polatory/isosurface/mesh_stream_writer.hpp>
+#include <polatory/isosurface/types.hpp>
+#include <polatory/types.hpp>
+#include <string>
+
+using polatory::Index;
+using polatory::geometry::Points3;
+using polatory::isosurface::EntireTag;
+using polatory::isosurface::Faces;
+using polatory::isosurface::Mesh;
+using polatory::isosurface::MeshStreamWriter;
+
+namespace {
+
+// A tetrahedron.
+Mesh tetrahedron() {
+  Points3 vertices(4, 3);
+  vertices << 0.0, 0.0, 0.0,  //
+      1.0, 0.0, 0.0,          //
+      0.0, 1.0, 0.0,          //
+      0.0, 0.0, 0.125;
+
+  Faces faces(4, 3);
+  faces << 0, 2, 1,  //
+      0, 1, 3,       //
+      0, 3, 2,       //
+      1, 2, 3;
+
+  return {vertices, faces};
+}
+
+std::string read_file(const std::string& filename) {
+  std::ifstream ifs(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+}
+
+std::string temp_filename(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+
+template <class T>
+T read_at(const std::string& bytes, std::size_t offset) {
+  T value{};
+  std::memcpy(&value, bytes.data() + offset, sizeof(T));
+  return value;
+}
+
+}  // namespace
+
+TEST(mesh, export_obj) {
+  auto mesh = tetrahedron();
+  auto filename = temp_filename("mesh.obj");
+
+  mesh.export_obj(filename);
+
+  EXPECT_EQ(
+      "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 0.125\n"
+      "f 1 3 2\nf 1 2 4\nf 1 4 3\nf 2 3 4\n",
+      read_file(filename));
+}
+
+TEST(mesh, export_ply) {
+  auto mesh = tetrahedron();
+  auto filename = temp_filename("mesh.ply");
+
+  mesh.export_file(filename);
+
+  auto bytes = read_file(filename);
+  std::string end_header = "end_header\n";
+  auto offset = bytes.find(end_header);
+  ASSERT_NE(std::string::npos, offset);
+  EXPECT_EQ(0, bytes.find("ply\nformat binary_little_endian 1.0\nelement vertex 4\n"));
+  EXPECT_NE(std::string::npos, bytes.find("element face 4\n"));
+  offset += end_header.size();
+
+  ASSERT_EQ(offset + 4 * 3 * sizeof(double) + 4 * (1 + 3 * sizeof(std::int32_t)), bytes.size());
+  EXPECT_EQ(0.125, read_at<double>(bytes, offset + 11 * sizeof(double)));
+  offset += 4 * 3 * sizeof(double);
+  for (Index i = 0; i < 4; i++) {
+    EXPECT_EQ(3, bytes.at(offset));
+    for (Index j = 0; j < 3; j++) {
+      EXPECT_EQ(mesh.faces()(i, j), read_at<std::int32_t>(bytes, offset + 1 + 4 * j));
+    }
+    offset += 1 + 3 * sizeof(std::int32_t);
+  }
+}
+
+TEST(mesh, export_stl) {
+  auto mesh = tetrahedron();
+  auto filename = temp_filename("mesh.STL");
+
+  mesh.export_file(filename);
+
+  auto bytes = read_file(filename);
+  ASSERT_EQ(84 + 4 * 50, bytes.size());
+  EXPECT_NE(0, bytes.find("solid"));
+  EXPECT_EQ(4, read_at<std::uint32_t>(bytes, 80));
+
+  // The normal and the vertices of the first face.
+  EXPECT_EQ(-1.0F, read_at<float>(bytes, 84 + 8));
+  EXPECT_EQ(1.0F, read_at<float>(bytes, 84 + 12 + 12 + 4));
+  EXPECT_EQ(1.0F, read_at<float>(bytes, 84 + 12 + 24));
+}
+
+TEST(mesh, save_load) {
+  auto filename = temp_filename("mesh.raw");
+
+  auto mesh = tetrahedron();
+  mesh.export_file(filename);
+
+  auto bytes = read_file(filename);
+  ASSERT_EQ(8 + 4 * 3 * 8 + 8 + 4 * 3 * 8 + 1, bytes.size());
+  EXPECT_EQ(4, read_at<Index>(bytes, 0));
+
+  auto loaded = Mesh::load(filename);
+  EXPECT_EQ(mesh.vertices(), loaded.vertices());
+  EXPECT_EQ(mesh.faces(), loaded.faces());
+  EXPECT_FALSE(loaded.is_entire());
+
+  Mesh(EntireTag{}).save(filename);
+  EXPECT_TRUE(Mesh::load(filename).is_entire());
+}
+
+TEST(mesh, stream_obj) {
+  auto filename = temp_filename("mesh_stream.obj");
+  auto mesh = tetrahedron();
+
+  Points3 other_vertices(3, 3);
+  other_vertices << 2.0, 0.0, 0.0,  //
+      3.0, 0.0, 0.0,                //
+      2.0, 1.0, 0.0;
+
+  Faces other_faces(1, 3);
+  other_faces << 0, 1, 2;
+
+  {
+    MeshStreamWriter writer(filename);
+    // The vertices shared with a chunk other than the previous one are not written again.
+    writer.write(Mesh(mesh.vertices(), mesh.faces().topRows(2)), {10, 11, 12, 13});
+    writer.write(Mesh(other_vertices, other_faces), {20, 21, 22});
+    writer.write(Mesh(mesh.vertices(), mesh.faces().bottomRows(2)), {10, 11, 12, 13});
+    writer.finish(false);
+  }
+
+  EXPECT_EQ(
+      "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 0 0 0.125\n"
+      "f 1 3 2\nf 1 2 4\n"
+      "v 2 0 0\nv 3 0 0\nv 2 1 0\n"
+      "f 5 6 7\n"
+      "f 1 4 3\nf 2 3 4\n",
+      read_file(filename));
+}
+
+TEST(mesh, stream_stl) {
+  auto filename = temp_filename("mesh_stream.stl");
+
+  {
+    MeshStreamWriter writer(filename);
+    writer.write(tetrahedron());
+    writer.write(tetrahedron());
+    writer.finish(false);
+  }
+
+  auto bytes = read_file(filename);
+  ASSERT_EQ(84 + 8 * 50, bytes.size());
+  EXPECT_EQ(8, read_at<std::uint32_t>(bytes, 80));
+
+  EXPECT_THROW(MeshStreamWriter(temp_filename("mesh_stream.ply")), std::invalid_argument);
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/isosurface/mesh.hpp>
+#include <polatory/isosurface/mesh_defects_finder.hpp>
+#include <polatory/isosurface/types.hpp>
+#include <polatory/types.hpp>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+using polatory::Index;
+using polatory::geometry::Points3;
+using polatory::isosurface::Faces;
+using polatory::isosurface::Mesh;
+using polatory::isosurface::MeshDefectsFinder;
+
+namespace {
+
+// Two squares that share only the vertex 0 (a bowtie), each made of two triangles.
+Mesh bowtie() {
+  Points3 vertices(7, 3);
+  vertices << 0.0, 0.0, 0.0,  //
+      1.0, 0.0, 0.0,          //
+      1.0, 1.0, 0.0,          //
+      0.0, 1.0, 0.0,          //
+      -1.0, 0.0, 0.0,         //
+      -1.0, -1.0, 0.0,        //
+      0.0, -1.0, 0.0;
+
+  Faces faces(4, 3);
+  faces << 0, 1, 2,  //
+      0, 2, 3,       //
+      0, 4, 5,       //
+      0, 5, 6;
+
+  return {vertices, faces};
+}
+
+// Two triangles that share only the vertex 0, where the edge 3-4 pierces the face 0.
+// The face 2 is apart from them.
+Mesh piercing_triangles() {
+  Points3 vertices(8, 3);
+  vertices << 0.0, 0.0, 0.0,  //
+      1.0, 0.0, 0.0,          //
+      0.0, 1.0, 0.0,          //
+      0.25, 0.25, -1.0,       //
+      0.25, 0.25, 1.0,        //
+      5.0, 0.0, 0.0,          //
+      6.0, 0.0, 0.0,          //
+      5.0, 1.0, 0.0;
+
+  Faces faces(3, 3);
+  faces << 0, 1, 2,  //
+      0, 3, 4,       //
+      5, 6, 7;
+
+  return {vertices, faces};
+}
+
+// Random triangles on a few vertices, which have many defects.
+Mesh random_triangles() {
+  const Index n_vertices = 20;
+  const Index n_faces = 60;
+
+  std::mt19937 gen(0);
+  std::uniform_real_distribution<double> coord_dist(-1.0, 1.0);
+  std::uniform_int_distribution<Index> vi_dist(0, n_vertices - 1);
+
+  Points3 vertices(n_vertices, 3);
+  for (auto& x : vertices.reshaped()) {
+    x = coord_dist(gen);
+  }
+
+  Faces faces(n_faces, 3);
+  for (auto f : faces.rowwise()) {
+    do {
+      f << vi_dist(gen), vi_dist(gen), vi_dist(gen);
+    } while (f(0) == f(1) || f(1) == f(2) || f(2) == f(0));
+  }
+
+  return {vertices, faces};
+}
+
+std::vector<Index> sorted(std::vector<Index> v) {
+  std::sort(v.begin(), v.end());
+  return v;
+}
+
+}  // namespace
+
+TEST(mesh_defects_finder, singular_vertices) {
+  auto mesh = bowtie();
+  MeshDefectsFinder defects(mesh);
+
+  ASSERT_EQ(std::vector<Index>{0}, defects.singular_vertices());
+  ASSERT_TRUE(defects.intersecting_faces().empty());
+}
+
+TEST(mesh_defects_finder, singular_vertices_around) {
+  auto mesh = bowtie();
+  MeshDefectsFinder defects(mesh.vertices(), mesh.faces());
+
+  // The vertex 0 is adjacent to the vertex 2.
+  ASSERT_EQ(std::vector<Index>{0}, defects.singular_vertices({2}));
+  ASSERT_EQ(std::vector<Index>{0}, defects.singular_vertices({0}));
+  ASSERT_TRUE(defects.intersecting_faces({2}).empty());
+}
+
+TEST(mesh_defects_finder, intersecting_faces_around) {
+  auto mesh = piercing_triangles();
+  MeshDefectsFinder defects(mesh);
+
+  ASSERT_EQ((std::vector<Index>{0, 1}), defects.intersecting_faces());
+
+  // The vertex 0 is adjacent to the vertex 3.
+  ASSERT_EQ((std::vector<Index>{0, 1}), defects.intersecting_faces({3}));
+  ASSERT_EQ((std::vector<Index>{0, 1}), defects.intersecting_faces({0}));
+  ASSERT_TRUE(defects.intersecting_faces({5}).empty());
+}
+
+TEST(mesh_defects_finder, incremental_vs_full) {
+  auto mesh = random_triangles();
+  const auto& faces = mesh.faces();
+  auto n_vertices = mesh.vertices().rows();
+  MeshDefectsFinder defects(mesh);
+
+  auto singular = sorted(defects.singular_vertices());
+  auto intersecting = defects.intersecting_faces();
+  ASSERT_FALSE(singular.empty());
+  ASSERT_FALSE(intersecting.empty());
+
+  std::vector<Index> all_vis(n_vertices);
+  std::iota(all_vis.begin(), all_vis.end(), Index{0});
+  ASSERT_EQ(singular, sorted(defects.singular_vertices(all_vis)));
+  ASSERT_EQ(intersecting, defects.intersecting_faces(all_vis));
+
+  for (Index vi = 0; vi < n_vertices; vi++) {
+    // The vertices in vis or adjacent to them.
+    std::unordered_set<Index> neighborhood{vi};
+    for (auto f : faces.rowwise()) {
+      if ((f.array() == vi).any()) {
+        neighborhood.insert(f.begin(), f.end());
+      }
+    }
+
+    std::vector<Index> expected_singular;
+    std::copy_if(singular.begin(), singular.end(), std::back_inserter(expected_singular),
+                 [&](auto vj) { return neighborhood.contains(vj); });
+    ASSERT_EQ(expected_singular, sorted(defects.singular_vertices({vi})));
+
+    // The intersecting faces around vi must be found, and no other faces than the ones found by
+    // the full pass.
+    auto actual_intersecting = defects.intersecting_faces({vi});
+    ASSERT_TRUE(std::includes(intersecting.begin(), intersecting.end(),
+                              actual_intersecting.begin(), actual_intersecting.end()));
+    for (auto fi : intersecting) {
+      if ((faces.row(fi).array() == vi).any()) {
+        ASSERT_TRUE(std::binary_search(actual_intersecting.begin(), actual_intersecting.end(), fi));
+      }
+    }
+  }
+}
@@ -8,10 +8,16 @@
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/isosurface/bit.hpp>
 #include <polatory/isosurface/rmt/edge.hpp>
+#include <polatory/isosurface/rmt/lattice.hpp>
 #include <polatory/isosurface/rmt/lattice_coordinates.hpp>
 #include <polatory/isosurface/rmt/node.hpp>
+#include <polatory/isosurface/rmt/node_list.hpp>
 #include <polatory/isosurface/rmt/primitive_lattice.hpp>
 #include <polatory/point_cloud/random_points.hpp>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+#include <vector>
 
 using polatory::Mat3;
 using polatory::geometry::Bbox3;
@@ -28,7 +34,11 @@ using polatory::isosurface::rmt::kLatticeBasis;
 using polatory::isosurface::rmt::kNeighborLatticeCoordinatesDeltas;
 using polatory::isosurface::rmt::kNeighborMasks;
 using polatory::isosurface::rmt::kOppositeEdge;
+using polatory::isosurface::rmt::Lattice;
 using polatory::isosurface::rmt::LatticeCoordinates;
+using polatory::isosurface::rmt::LatticeCoordinatesHash;
+using polatory::isosurface::rmt::Node;
+using polatory::isosurface::rmt::NodeList;
 using polatory::isosurface::rmt::PrimitiveLattice;
 using polatory::point_cloud::random_points;
 
@@ -51,6 +61,13 @@ TEST(rmt, lattice) {
   }
 }
 
+TEST(rmt, lattice_too_large) {
+  Bbox3 bbox(Point3(-1.0, -1.0, -1.0), Point3(1.0, 1.0, 1.0));
+
+  EXPECT_NO_THROW(Lattice(bbox, 1e-3, Mat3::Identity()));
+  EXPECT_THROW(Lattice(bbox, 1e-6, Mat3::Identity()), std::runtime_error);
+}
+
 TEST(rmt, construction_of_basis) {
   auto pi = std::numbers::pi;
 
@@ -131,3 +148,37 @@ TEST(rmt, opposite_edge) {
               kNeighborLatticeCoordinatesDeltas.at(kOppositeEdge.at(ei)));
   }
 }
+
+TEST(rmt, node_list) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> dist(-50, 50);
+
+  NodeList node_list;
+  std::unordered_set<LatticeCoordinates, LatticeCoordinatesHash> expected;
+
+  for (auto i = 0; i < 10000; i++) {
+    LatticeCoordinates lc(dist(gen), dist(gen), dist(gen));
+    auto inserted = node_list.emplace(lc, Node(lc.cast<double>())).second;
+    EXPECT_EQ(expected.insert(lc).second, inserted);
+  }
+
+  std::vector<LatticeCoordinates> lcs(expected.begin(), expected.end());
+  for (std::size_t i = 0; i < lcs.size(); i += 2) {
+    EXPECT_EQ(1, node_list.erase(lcs.at(i)));
+    EXPECT_EQ(0, node_list.erase(lcs.at(i)));
+    expected.erase(lcs.at(i));
+  }
+
+  EXPECT_EQ(expected.size(), node_list.size());
+  for (const auto& lc : lcs) {
+    ASSERT_EQ(expected.contains(lc), node_list.contains(lc));
+    if (expected.contains(lc)) {
+      EXPECT_EQ(lc.cast<double>(), node_list.at(lc).position());
+    }
+  }
+
+  for (const auto& [lc, node] : node_list) {
+    EXPECT_TRUE(expected.contains(lc));
+    EXPECT_EQ(lc.cast<double>(), node.position());
+  }
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+#include <omp.h>
+#include <polatory/interpolant.hpp>
+#include <polatory/kriging/cross_validate.hpp>
+#include <polatory/model.hpp>
+#include <polatory/rbf/polyharmonic_odd.hpp>
+#include <polatory/types.hpp>
+#include <utility>
+#include <vector>
+
+#include "../utility.hpp"
+
+using polatory::Index;
+using polatory::Interpolant;
+using polatory::Model;
+using polatory::VecX;
+using polatory::kriging::cross_validate;
+using polatory::rbf::Triharmonic3D;
+
+TEST(cross_validate, trivial) {
+  constexpr int kDim = 3;
+  auto n_points = Index{1000};
+  auto n_sets = 5;
+  auto tolerance = 1e-4;
+  auto max_iter = 100;
+  auto accuracy = tolerance / 100.0;
+
+  auto [points, values] = sample_data<kDim>(n_points, Eigen::Matrix3d::Identity());
+
+  Eigen::VectorXi set_ids(n_points);
+  for (Index i = 0; i < n_points; i++) {
+    set_ids(i) = static_cast<int>(i % n_sets);
+  }
+
+  Triharmonic3D<kDim> rbf({1.0});
+  auto poly_degree = rbf.cpd_order() - 1;
+  Model<kDim> model(std::move(rbf), poly_degree);
+
+  VecX predictions =
+      cross_validate(model, points, values, set_ids, tolerance, max_iter, accuracy);
+  VecX predictions2 =
+      cross_validate(model, points, values, set_ids, tolerance, max_iter, accuracy, 2);
+
+  auto max_active_levels = omp_get_max_active_levels();
+  VecX predictions3 =
+      cross_validate(model, points, values, set_ids, tolerance, max_iter, accuracy, 2, true);
+  EXPECT_EQ(max_active_levels, omp_get_max_active_levels());
+
+  // Fit to the points not in the first set.
+  std::vector<Index> train_set;
+  std::vector<Index> test_set;
+  for (Index i = 0; i < n_points; i++) {
+    (set_ids(i) == 0 ? test_set : train_set).push_back(i);
+  }
+
+  Interpolant<kDim> interpolant(model);
+  interpolant.fit(points(train_set, Eigen::all), values(train_set), tolerance, max_iter,
+                  accuracy);
+  VecX expected = interpolant.evaluate(points(test_set, Eigen::all), accuracy);
+
+  for (Index j = 0; j < static_cast<Index>(test_set.size()); j++) {
+    auto i = test_set.at(j);
+    EXPECT_NEAR(expected(j), predictions(i), 10.0 * tolerance);
+    EXPECT_NEAR(expected(j), predictions2(i), 10.0 * tolerance);
+    EXPECT_NEAR(expected(j), predictions3(i), 10.0 * tolerance);
+  }
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include <polatory/kriging/multi_start_variogram_fitting.hpp>
+#include <polatory/kriging/variogram_calculator.hpp>
+#include <polatory/kriging/variogram_fitting_3d.hpp>
+#include <polatory/model.hpp>
+#include <polatory/rbf/cov_exponential.hpp>
+#include <polatory/types.hpp>
+#include <utility>
+
+#include "../utility.hpp"
+
+using polatory::Index;
+using polatory::Model;
+using polatory::kriging::fit_variogram;
+using polatory::kriging::VariogramCalculator;
+using polatory::rbf::CovExponential;
+
+TEST(multi_start_variogram_fitting, trivial) {
+  constexpr int kDim = 3;
+  auto n_points = Index{2000};
+
+  auto [points, values] = sample_data<kDim>(n_points, random_anisotropy<kDim>());
+
+  VariogramCalculator<kDim> calc(0.1, 10);
+  calc.set_directions(VariogramCalculator<kDim>::kAnisotropicDirections);
+  auto variog_set = calc.calculate(points, values);
+
+  CovExponential<kDim> rbf({1.0, 0.5});
+  Model<kDim> model(std::move(rbf), -1);
+  model.set_nugget(0.01);
+
+  auto single = fit_variogram(variog_set, model, 1);
+  auto multi = fit_variogram(variog_set, model, 8);
+  auto multi2 = fit_variogram(variog_set, model, 8);
+
+  ASSERT_EQ(1u, single.size());
+  ASSERT_EQ(8u, multi.size());
+
+  // The first start is common, so the best fit is at least as good.
+  EXPECT_LE(multi.front().final_cost(), single.front().final_cost());
+
+  for (std::size_t i = 1; i < multi.size(); i++) {
+    EXPECT_LE(multi.at(i - 1).final_cost(), multi.at(i).final_cost());
+  }
+
+  // The result is reproducible.
+  for (std::size_t i = 0; i < multi.size(); i++) {
+    EXPECT_EQ(multi.at(i).final_cost(), multi2.at(i).final_cost());
+    EXPECT_EQ(multi.at(i).model().parameters(), multi2.at(i).model().parameters());
+  }
+}
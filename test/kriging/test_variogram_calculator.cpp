@@ -9,6 +9,7 @@
 #include <polatory/kriging/variogram_calculator.hpp>
 #include <polatory/point_cloud/random_points.hpp>
 #include <polatory/types.hpp>
+#include <vector>
 
 namespace fs = std::filesystem;
 using polatory::Index;
@@ -17,9 +18,96 @@ using polatory::geometry::Cuboid3;
 using polatory::geometry::Point3;
 using polatory::geometry::Points3;
 using polatory::kriging::VariogramCalculator;
+using polatory::kriging::VariogramEstimator;
 using polatory::kriging::VariogramSet;
 using polatory::point_cloud::random_points;
 
+TEST(variogram_calculator, estimators) {
+  const auto n_points = Index{4};
+
+  // Tetrahedron vertices separated from each other by a distance d.
+  auto d = 2.0;
+  Points3 points(n_points, 3);
+  points << d * Point3(std::sqrt(3.0) / 3.0, 0.0, 0.0),
+      d * Point3(-std::sqrt(3.0) / 6.0, 1.0 / 2.0, 0.0),
+      d * Point3(-std::sqrt(3.0) / 6.0, -1.0 / 2.0, 0.0),
+      d * Point3(0.0, 0.0, std::sqrt(6.0) / 3.0);
+
+  VecX values = VecX::Random(n_points);
+
+  auto sum_squared = 0.0;
+  auto sum_sqrt_abs = 0.0;
+  auto sum_abs = 0.0;
+  for (Index i = 0; i < n_points; i++) {
+    for (Index j = i + 1; j < n_points; j++) {
+      auto incr = std::abs(values(j) - values(i));
+      sum_squared += incr * incr;
+      sum_sqrt_abs += std::sqrt(incr);
+      sum_abs += incr;
+    }
+  }
+  auto np = 6.0;
+  auto ch_gamma =
+      0.5 * std::pow(sum_sqrt_abs / np, 4.0) / (0.457 + 0.494 / np + 0.045 / (np * np));
+
+  VariogramCalculator<3> calc(1.0, 5);
+  auto variog_sets = calc.calculate_multiple(
+      points, values,
+      {VariogramEstimator::kMatheron, VariogramEstimator::kCressieHawkins,
+       VariogramEstimator::kMadogram});
+
+  ASSERT_EQ(3u, variog_sets.size());
+  EXPECT_DOUBLE_EQ(0.5 * sum_squared / np, variog_sets.at(0).variograms().at(0).bin_gamma().at(0));
+  EXPECT_DOUBLE_EQ(ch_gamma, variog_sets.at(1).variograms().at(0).bin_gamma().at(0));
+  EXPECT_DOUBLE_EQ(0.5 * sum_abs / np, variog_sets.at(2).variograms().at(0).bin_gamma().at(0));
+
+  calc.set_estimator(VariogramEstimator::kMadogram);
+  auto variog_set = calc.calculate(points, values);
+  EXPECT_DOUBLE_EQ(variog_sets.at(2).variograms().at(0).bin_gamma().at(0),
+                   variog_set.variograms().at(0).bin_gamma().at(0));
+}
+
+TEST(variogram_calculator, pairs_within_max_lag) {
+  const auto n_points = Index{500};
+
+  Points3 points = random_points(Cuboid3(), n_points, 0);
+  VecX values = VecX::Random(n_points);
+
+  auto lag_distance = 0.05;
+  auto num_lags = Index{4};
+  auto lag_tolerance = 0.5 * lag_distance;
+
+  // Bin all pairs by brute force.
+  std::vector<double> bin_distance(num_lags);
+  std::vector<double> bin_gamma(num_lags);
+  std::vector<Index> bin_num_pairs(num_lags);
+  for (Index i = 0; i < n_points; i++) {
+    for (Index j = i + 1; j < n_points; j++) {
+      auto dist = (points.row(j) - points.row(i)).norm();
+      auto gamma = 0.5 * std::pow(values(j) - values(i), 2.0);
+      for (Index bin = 0; bin < num_lags; bin++) {
+        if (std::abs(dist - static_cast<double>(bin) * lag_distance) <= lag_tolerance) {
+          bin_distance.at(bin) += dist;
+          bin_gamma.at(bin) += gamma;
+          bin_num_pairs.at(bin)++;
+        }
+      }
+    }
+  }
+
+  VariogramCalculator<3> calc(lag_distance, num_lags);
+  auto variog_set = calc.calculate(points, values);
+  const auto& v = variog_set.variograms().at(0);
+
+  ASSERT_EQ(num_lags, v.num_bins());
+  for (Index bin = 0; bin < num_lags; bin++) {
+    auto np = bin_num_pairs.at(bin);
+    EXPECT_EQ(np, v.bin_num_pairs().at(bin));
+    EXPECT_NEAR(bin_distance.at(bin) / static_cast<double>(np), v.bin_distance().at(bin), 1e-12);
+    EXPECT_NEAR(bin_gamma.at(bin) / static_cast<double>(np), v.bin_gamma().at(bin), 1e-12);
+  }
+}
+
 TEST(variogram_calculator, serialization) {
   const auto n_points = Index{1000};
 
@@ -93,3 +181,27 @@ TEST(variogram_calculator, zero_points) {
 
   EXPECT_EQ(0, variogs_set.num_variograms());
 }
+
+TEST(variogram_calculator, tiny_lag_tolerance) {
+  const auto n_points = Index{3};
+
+  // The maximum distance of pairs is too small for the points to be put in a grid.
+  Points3 points(n_points, 3);
+  points << Point3(0.0, 0.0, 0.0), Point3(0.0, 0.0, 0.0), Point3(1.0, 0.0, 0.0);
+
+  VecX values(n_points);
+  values << 0.0, 1.0, 2.0;
+
+  auto lag_distance = 1.0;
+  auto num_lags = Index{1};
+
+  VariogramCalculator<3> calc(lag_distance, num_lags);
+  calc.set_lag_tolerance(1e-300);
+  auto variog_set = calc.calculate(points, values);
+  const auto& v = variog_set.variograms().at(0);
+
+  EXPECT_EQ(1, v.num_bins());
+
+  EXPECT_EQ(0.0, v.bin_distance().at(0));
+  EXPECT_EQ(1u, v.bin_num_pairs().at(0));
+}
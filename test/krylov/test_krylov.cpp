@@ -81,8 +81,10 @@ class KrylovTest : public ::testing::Test {
   void TearDown() override {}
 
   template <class Solver>
-  void test_solver(bool with_initial_solution, bool with_right_pc, bool with_left_pc) {
+  void test_solver(bool with_initial_solution, bool with_right_pc, bool with_left_pc,
+                   bool out_of_core = false) {
     Solver solver(*op, rhs, n);
+    solver.set_out_of_core(out_of_core);
     if (with_initial_solution) {
       solver.set_initial_solution(x0);
     }
@@ -122,6 +124,11 @@ TEST_F(KrylovTest, fgmres) {
   test_solver<Fgmres>(true, true, false);
 }
 
+TEST_F(KrylovTest, fgmres_out_of_core) {
+  test_solver<Fgmres>(false, false, false, true);
+  test_solver<Fgmres>(true, true, false, true);
+}
+
 TEST_F(KrylovTest, gmres) {
   test_solver<Gmres>(false, false, false);
   test_solver<Gmres>(false, true, false);
@@ -131,6 +138,11 @@ TEST_F(KrylovTest, gmres) {
   test_solver<Gmres>(true, false, true);
 }
 
+TEST_F(KrylovTest, gmres_out_of_core) {
+  test_solver<Gmres>(true, true, false, true);
+  test_solver<Gmres>(true, false, true, true);
+}
+
 TEST_F(KrylovTest, minres) {
   test_solver<Minres>(false, false, false);
   test_solver<Minres>(true, false, false);
@@ -1,14 +1,39 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <numeric>
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/point_cloud/distance_filter.hpp>
+#include <polatory/point_cloud/random_points.hpp>
 #include <polatory/types.hpp>
+#include <random>
 #include <vector>
 
 using polatory::Index;
+using polatory::geometry::Cuboid3;
 using polatory::geometry::Point3;
 using polatory::geometry::Points3;
+using polatory::geometry::Sphere3;
 using polatory::point_cloud::DistanceFilter;
+using polatory::point_cloud::random_points;
+
+namespace {
+
+std::vector<Index> sequential_filter(const Points3& points, double distance,
+                                     const std::vector<Index>& indices) {
+  std::vector<Index> filtered_indices;
+  for (auto i : indices) {
+    auto keep = std::none_of(filtered_indices.begin(), filtered_indices.end(), [&](auto j) {
+      return (points.row(i) - points.row(j)).norm() <= distance;
+    });
+    if (keep) {
+      filtered_indices.push_back(i);
+    }
+  }
+  return filtered_indices;
+}
+
+}  // namespace
 
 TEST(distance_filter, trivial) {
   Points3 points(9, 3);
@@ -50,3 +75,37 @@ TEST(distance_filter, non_trivial_indices) {
 
   EXPECT_EQ(expected_filtered_indices, filter.filtered_indices());
 }
+
+TEST(distance_filter, greedy_order) {
+  const auto n_points = Index{10000};
+  const auto distance = 0.05;
+
+  Points3 points = random_points(Sphere3(), n_points);
+
+  std::vector<Index> indices(n_points);
+  std::iota(indices.begin(), indices.end(), Index{0});
+  std::shuffle(indices.begin(), indices.end(), std::mt19937{});
+
+  DistanceFilter filter(points);
+  filter.filter(distance, indices);
+
+  EXPECT_EQ(sequential_filter(points, distance, indices), filter.filtered_indices());
+}
+
+TEST(distance_filter, sorted_order) {
+  const auto n_points = Index{50000};
+  const auto distance = 0.05;
+
+  // The points are ordered along the x-axis, so each point depends on the preceding ones.
+  Points3 points = random_points(Cuboid3({0, 0, 0}, {50, 0.1, 0.1}), n_points);
+
+  std::vector<Index> indices(n_points);
+  std::iota(indices.begin(), indices.end(), Index{0});
+  std::sort(indices.begin(), indices.end(),
+            [&](auto i, auto j) { return points(i, 0) < points(j, 0); });
+
+  DistanceFilter filter(points);
+  filter.filter(distance, indices);
+
+  EXPECT_EQ(sequential_filter(points, distance, indices), filter.filtered_indices());
+}
@@ -6,6 +6,7 @@
 #include <polatory/point_cloud/kdtree.hpp>
 #include <polatory/point_cloud/random_points.hpp>
 #include <polatory/types.hpp>
+#include <vector>
 
 using polatory::Index;
 using polatory::geometry::Point3;
@@ -67,6 +68,8 @@ TEST(kdtree, zero_points) {
   std::vector<double> distances;
 
   {
+    indices = {0};
+    distances = {0.0};
     tree.knn_search(query_point, k, indices, distances);
 
     EXPECT_EQ(0u, indices.size());
@@ -74,9 +77,58 @@ TEST(kdtree, zero_points) {
   }
 
   {
+    indices = {0};
+    distances = {0.0};
     tree.radius_search(query_point, search_radius, indices, distances);
 
     EXPECT_EQ(0u, indices.size());
     EXPECT_EQ(0u, distances.size());
   }
 }
+
+TEST(kdtree, exact) {
+  const auto n_points = Index{1024};
+  const auto k = Index{10};
+  const auto search_radius = 0.2;
+
+  auto points = random_points(Sphere3(), n_points);
+  auto query_points = random_points(Sphere3(), Index{64});
+
+  KdTree tree(points);
+
+  std::vector<std::vector<Index>> batch_indices;
+  std::vector<std::vector<double>> batch_distances;
+  tree.knn_search_batch(query_points, k, batch_indices, batch_distances);
+  ASSERT_EQ(query_points.rows(), batch_indices.size());
+
+  std::vector<Index> indices;
+  std::vector<double> distances;
+
+  for (Index i = 0; i < query_points.rows(); i++) {
+    Point3 q = query_points.row(i);
+
+    std::vector<double> all_distances;
+    for (Index j = 0; j < n_points; j++) {
+      all_distances.push_back((points.row(j) - q).norm());
+    }
+    std::sort(all_distances.begin(), all_distances.end());
+
+    tree.knn_search(q, k, indices, distances);
+    EXPECT_EQ(indices, batch_indices.at(i));
+    for (Index j = 0; j < k; j++) {
+      EXPECT_DOUBLE_EQ(all_distances.at(j), distances.at(j));
+      EXPECT_DOUBLE_EQ((points.row(indices.at(j)) - q).norm(), distances.at(j));
+    }
+
+    tree.radius_search(q, search_radius, indices, distances);
+    auto n_within = std::upper_bound(all_distances.begin(), all_distances.end(), search_radius) -
+                    all_distances.begin();
+    EXPECT_EQ(n_within, indices.size());
+  }
+
+  tree.radius_search_batch(query_points, search_radius, batch_indices, batch_distances);
+  for (Index i = 0; i < query_points.rows(); i++) {
+    tree.radius_search(query_points.row(i), search_radius, indices, distances);
+    EXPECT_EQ(indices, batch_indices.at(i));
+  }
+}
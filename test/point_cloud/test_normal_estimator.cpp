@@ -52,3 +52,23 @@ TEST(normal_estimator, radius) {
     ASSERT_GT(n.dot(direction), 0.0);
   }
 }
+
+TEST(normal_estimator, closed_surface_by_patches) {
+  const auto n_points = Index{4096};
+  const auto k = Index{10};
+  auto points = random_points(Sphere3(), n_points);
+
+  auto normals = NormalEstimator(points)
+                     .estimate_with_knn(k)
+                     .orient_closed_surface_by_patches(k, 256)
+                     .into_normals();
+
+  for (Index i = 0; i < n_points; i++) {
+    auto n = normals.row(i);
+    if (n.norm() == 0.0) {
+      continue;
+    }
+
+    ASSERT_GT(n.dot(points.row(i)), 0.0);
+  }
+}
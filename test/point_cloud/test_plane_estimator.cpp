@@ -4,6 +4,7 @@
 #include <polatory/geometry/point3d.hpp>
 #include <polatory/point_cloud/plane_estimator.hpp>
 
+using polatory::Mat3;
 using polatory::geometry::Point3;
 using polatory::geometry::Points3;
 using polatory::geometry::Vector3;
@@ -27,3 +28,21 @@ TEST(plane_estimator, trivial) {
   auto normal = estimator.plane_normal();
   EXPECT_DOUBLE_EQ(1.0, std::abs(normal_expected.dot(normal)));
 }
+
+TEST(plane_estimator, scatter) {
+  Points3 points = Points3::Random(100, 3);
+  points.col(2) *= 0.1;
+
+  Point3 barycenter = points.colwise().mean();
+  Points3 centered = points.rowwise() - barycenter;
+  Mat3 scatter = centered.transpose() * centered;
+
+  auto expected = PlaneEstimator(points);
+  auto estimator = PlaneEstimator(scatter, points.rows());
+
+  EXPECT_NEAR(expected.point_error(), estimator.point_error(), 1e-12);
+  EXPECT_NEAR(expected.line_error(), estimator.line_error(), 1e-12);
+  EXPECT_NEAR(expected.plane_error(), estimator.plane_error(), 1e-12);
+  EXPECT_NEAR(expected.plane_factor(), estimator.plane_factor(), 1e-10);
+  EXPECT_NEAR(1.0, std::abs(expected.plane_normal().dot(estimator.plane_normal())), 1e-12);
+}
@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/polynomial/evaluate_into.hpp>
+#include <polatory/polynomial/monomial_basis.hpp>
+#include <polatory/types.hpp>
+
+using polatory::Index;
+using polatory::MatX;
+using polatory::geometry::Points3;
+using polatory::polynomial::evaluate_into;
+using polatory::polynomial::MonomialBasis;
+
+TEST(evaluate_into, trivial) {
+  // More points than the chunk size.
+  const auto n_points = Index{100000};
+  const auto n_grad_points = Index{70000};
+
+  MonomialBasis<3> basis(2);
+  Points3 points = Points3::Random(n_points, 3);
+  Points3 grad_points = Points3::Random(n_grad_points, 3);
+
+  MatX expected = basis.evaluate(points, grad_points);
+
+  MatX result(n_points + 3 * n_grad_points, basis.basis_size());
+  evaluate_into(basis, points, grad_points, result);
+
+  EXPECT_EQ(expected, result);
+}
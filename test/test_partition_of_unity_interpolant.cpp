@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+#include <filesystem>
+#include <polatory/geometry/point3d.hpp>
+#include <polatory/interpolant.hpp>
+#include <polatory/model.hpp>
+#include <polatory/numeric/error.hpp>
+#include <polatory/partition_of_unity_interpolant.hpp>
+#include <polatory/rbf/cov_exponential.hpp>
+#include <polatory/rbf/rbf_io.hpp>
+#include <polatory/types.hpp>
+#include <utility>
+
+#include "utility.hpp"
+
+using polatory::Index;
+using polatory::Interpolant;
+using polatory::Mat;
+using polatory::Model;
+using polatory::PartitionOfUnityInterpolant;
+using polatory::VecX;
+using polatory::geometry::Points3;
+using polatory::numeric::absolute_error;
+using polatory::rbf::CovExponential;
+
+namespace {
+
+constexpr int kDim = 3;
+
+// With a short-range covariance function and no polynomial trend,
+// the local interpolants should agree well with the global one.
+Model<kDim> test_model() {
+  CovExponential<kDim> rbf({1.0, 0.1});
+
+  return Model<kDim>(std::move(rbf), -1);
+}
+
+}  // namespace
+
+TEST(partition_of_unity_interpolant, fit) {
+  Index n_points = 4096;
+  auto tolerance = 1e-4;
+  auto accuracy = tolerance / 100.0;
+
+  auto model = test_model();
+  auto [points, values] = sample_data<kDim>(n_points, Mat<kDim>::Identity());
+
+  PartitionOfUnityInterpolant<kDim> pu(model, 512);
+  pu.fit(points, values, tolerance, 100, accuracy);
+
+  EXPECT_GT(pu.num_patches(), 1);
+
+  VecX values_fit = pu.evaluate(points, accuracy);
+  EXPECT_LT(absolute_error<Eigen::Infinity>(values_fit, values), 2.0 * tolerance);
+}
+
+TEST(partition_of_unity_interpolant, global_fit) {
+  Index n_points = 4096;
+  Index n_eval_points = 1024;
+  auto tolerance = 1e-4;
+  auto accuracy = tolerance / 100.0;
+
+  auto model = test_model();
+  auto [points, values] = sample_data<kDim>(n_points, Mat<kDim>::Identity());
+  Points3 eval_points = Points3::Random(n_eval_points, kDim);
+
+  Interpolant<kDim> global(model);
+  global.fit(points, values, tolerance, 100, accuracy);
+
+  PartitionOfUnityInterpolant<kDim> pu(model, 512);
+  pu.fit(points, values, tolerance, 100, accuracy);
+
+  VecX expected = global.evaluate(eval_points, eval_points, accuracy, accuracy);
+  VecX actual = pu.evaluate(eval_points, eval_points, accuracy, accuracy);
+
+  EXPECT_LT(absolute_error<Eigen::Infinity>(actual.head(n_eval_points),
+                                            expected.head(n_eval_points)),
+            1e-2);
+  EXPECT_LT(absolute_error<Eigen::Infinity>(actual.tail(kDim * n_eval_points),
+                                            expected.tail(kDim * n_eval_points)),
+            1e-1);
+}
+
+TEST(partition_of_unity_interpolant, serialize) {
+  Index n_points = 1024;
+  auto tolerance = 1e-4;
+
+  auto model = test_model();
+  auto [points, values] = sample_data<kDim>(n_points, Mat<kDim>::Identity());
+  Points3 eval_points = Points3::Random(256, kDim);
+
+  PartitionOfUnityInterpolant<kDim> pu(model, 256);
+  pu.fit(points, values, tolerance);
+
+  auto filename = (std::filesystem::temp_directory_path() / "pu_interpolant.bin").string();
+  pu.save(filename);
+  auto loaded = PartitionOfUnityInterpolant<kDim>::load(filename);
+  std::filesystem::remove(filename);
+
+  EXPECT_EQ(loaded.num_patches(), pu.num_patches());
+  EXPECT_EQ(loaded.evaluate(eval_points), pu.evaluate(eval_points));
+}
@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <polatory/table.hpp>
+#include <polatory/types.hpp>
+#include <string>
+#include <thread>
+#include <utility>
+
+using polatory::Index;
+using polatory::MatX;
+using polatory::read_table;
+using polatory::write_table;
+
+namespace {
+
+// Runs the given function when it goes out of scope, even if an exception is thrown.
+class ScopeExit {
+ public:
+  explicit ScopeExit(std::function<void()> fn) : fn_(std::move(fn)) {}
+
+  ~ScopeExit() { fn_(); }
+
+  ScopeExit(const ScopeExit&) = delete;
+  ScopeExit& operator=(const ScopeExit&) = delete;
+
+ private:
+  std::function<void()> fn_;
+};
+
+}  // namespace
+
+TEST(table, read) {
+  auto filename =
+      (std::filesystem::temp_directory_path() / "614e93d4-8e7d-48d5-8b68-d029e9dda163").string();
+  ScopeExit remove_file([&] { std::filesystem::remove(filename); });
+
+  {
+    std::ofstream ofs(filename, std::ios::binary);
+    ofs << "# x,y,z\n"
+        << "1,2,3\r\n"
+        << "4,5,6e-1\r\n"
+        << "7,8\n"
+        << "9,abc,-0.5";
+  }
+
+  auto table = read_table(filename);
+
+  ASSERT_EQ(3, table.rows());
+  ASSERT_EQ(3, table.cols());
+  EXPECT_EQ(1.0, table(0, 0));
+  EXPECT_EQ(3.0, table(0, 2));
+  EXPECT_EQ(4.0, table(1, 0));
+  EXPECT_EQ(0.6, table(1, 2));
+  EXPECT_EQ(9.0, table(2, 0));
+  EXPECT_TRUE(std::isnan(table(2, 1)));
+  EXPECT_EQ(-0.5, table(2, 2));
+}
+
+TEST(table, read_large) {
+  const auto n_rows = Index{100000};
+  auto filename =
+      (std::filesystem::temp_directory_path() / "591570ae-f637-44b5-ae70-986d1604383f").string();
+  ScopeExit remove_file([&] { std::filesystem::remove(filename); });
+
+  MatX expected = MatX::Random(n_rows, 4);
+  write_table(filename, expected);
+
+  auto table = read_table(filename);
+
+  EXPECT_EQ(expected, table);
+}
+
+#ifndef _WIN32
+TEST(table, read_fifo) {
+  const auto n_rows = Index{10000};
+  auto filename =
+      (std::filesystem::temp_directory_path() / "933e2cc4-42ff-4845-9660-28c019684d69").string();
+
+  std::filesystem::remove(filename);
+  ASSERT_EQ(0, ::mkfifo(filename.c_str(), 0600));
+  ScopeExit remove_file([&] { std::filesystem::remove(filename); });
+
+  MatX expected = MatX::Random(n_rows, 4);
+  std::thread writer([&] { write_table(filename, expected); });
+  ScopeExit join_writer([&] { writer.join(); });
+
+  auto table = read_table(filename);
+
+  EXPECT_EQ(expected, table);
+}
+#endif
+
+TEST(table, empty) {
+  auto filename =
+      (std::filesystem::temp_directory_path() / "2f346015-6930-4f94-8189-e70e2ee790b3").string();
+  ScopeExit remove_file([&] { std::filesystem::remove(filename); });
+
+  {
+    std::ofstream ofs(filename);
+    ofs << "# x,y,z\n";
+  }
+
+  EXPECT_THROW(read_table(filename), std::runtime_error);
+}